@@ -0,0 +1,103 @@
+#include "BenchHarness.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+#endif
+
+namespace
+{
+  std::atomic<uint64_t> allocationCount{0};
+  std::atomic<uint64_t> allocationBytes{0};
+
+  void countAllocation(size_t size)
+  {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+}
+
+#if defined(__GLIBC__)
+// rapidjson's CrtAllocator calls malloc directly, so on glibc the C allocation functions are
+// interposed too; elsewhere only operator new is counted and pool chunks go unreported.
+extern "C" void* malloc(size_t size)
+{
+  countAllocation(size);
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+  countAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+  countAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+void* operator new(size_t size)
+{
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+#else
+void* operator new(size_t size)
+{
+  countAllocation(size);
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+#endif
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace mgutils::bench
+{
+  AllocationStats allocationStats()
+  {
+    return {allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed)};
+  }
+
+  Runner::Runner(int argc, char** argv): _budget(std::chrono::milliseconds(500))
+  {
+    if (argc > 1)
+      _filter = argv[1];
+    if (const char* budget = std::getenv("MGUTILS_BENCH_BUDGET_MS"))
+      _budget = std::chrono::milliseconds(std::max(1L, std::strtol(budget, nullptr, 10)));
+
+    std::printf("%-48s %12s %10s %10s %12s\n", "benchmark", "ns/op", "MB/s", "allocs/op", "bytes/op");
+  }
+
+  double Runner::median(std::vector<double>& samples)
+  {
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+  }
+
+  void Runner::report(const Result& result)
+  {
+    if (result.mbPerSec > 0)
+      std::printf("%-48s %12.1f %10.1f %10.2f %12.1f\n", result.name.c_str(), result.nsPerOp, result.mbPerSec,
+                  result.allocsPerOp, result.bytesAllocatedPerOp);
+    else
+      std::printf("%-48s %12.1f %10s %10.2f %12.1f\n", result.name.c_str(), result.nsPerOp, "-",
+                  result.allocsPerOp, result.bytesAllocatedPerOp);
+    std::fflush(stdout);
+    _results.push_back(result);
+  }
+}
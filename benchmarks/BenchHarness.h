@@ -0,0 +1,114 @@
+#ifndef MGUTILS_BENCHHARNESS_H
+#define MGUTILS_BENCHHARNESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mgutils::bench
+{
+  // Keeps the compiler from discarding a result or hoisting the work that produced it out of the loop
+  template <typename T>
+  inline void doNotOptimize(const T& value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+  }
+
+  // Forces pending writes to memory, so stores into reused buffers are not elided
+  inline void clobberMemory()
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+  }
+
+  // Process wide counters fed by the replaced global operator new (see BenchHarness.cpp)
+  struct AllocationStats
+  {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+  };
+
+  AllocationStats allocationStats();
+
+  struct Result
+  {
+    std::string name;
+    double nsPerOp = 0;
+    double allocsPerOp = 0;
+    double bytesAllocatedPerOp = 0;
+    double mbPerSec = 0; // 0 when the benchmark has no payload size
+  };
+
+  // Minimal runner: calibrates a batch size to the time budget, times several batches and reports
+  // the median, with heap allocations per operation counted over the measured batches.
+  //
+  //   Runner runner(argc, argv);
+  //   runner.run("parse/tick/rapidjson", tick.size(), [&] { ... });
+  class Runner
+  {
+  public:
+    // argv[1], when given, is a substring filter on benchmark names
+    Runner(int argc, char** argv);
+
+    template <typename F>
+    void run(const std::string& name, size_t payloadBytes, F&& f)
+    {
+      if (!_filter.empty() && name.find(_filter) == std::string::npos)
+        return;
+
+      for (int i = 0; i < WARMUP_ITERATIONS; ++i)
+        f();
+
+      uint64_t batch = 1;
+      while (elapsed(f, batch) < _budget / (SAMPLES * 2) && batch < (uint64_t(1) << 30))
+        batch *= 2;
+
+      std::vector<double> samples;
+      AllocationStats before = allocationStats();
+      for (int s = 0; s < SAMPLES; ++s)
+        samples.push_back(std::chrono::duration<double, std::nano>(elapsed(f, batch)).count() / batch);
+      AllocationStats after = allocationStats();
+
+      const double ops = double(batch) * SAMPLES;
+      Result result;
+      result.name = name;
+      result.nsPerOp = median(samples);
+      result.allocsPerOp = (after.count - before.count) / ops;
+      result.bytesAllocatedPerOp = (after.bytes - before.bytes) / ops;
+      if (payloadBytes > 0)
+        result.mbPerSec = payloadBytes / result.nsPerOp * 1e9 / (1024 * 1024);
+      report(result);
+    }
+
+    const std::vector<Result>& results() const { return _results; }
+
+  private:
+    static constexpr int WARMUP_ITERATIONS = 16;
+    static constexpr int SAMPLES = 5;
+
+    template <typename F>
+    static std::chrono::nanoseconds elapsed(F& f, uint64_t iterations)
+    {
+      auto start = std::chrono::steady_clock::now();
+      for (uint64_t i = 0; i < iterations; ++i)
+        f();
+      return std::chrono::steady_clock::now() - start;
+    }
+
+    static double median(std::vector<double>& samples);
+    void report(const Result& result);
+
+    std::string _filter;
+    std::chrono::nanoseconds _budget;
+    std::vector<Result> _results;
+  };
+}
+
+#endif //MGUTILS_BENCHHARNESS_H
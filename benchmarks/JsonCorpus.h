@@ -0,0 +1,102 @@
+#ifndef MGUTILS_JSONCORPUS_H
+#define MGUTILS_JSONCORPUS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mgutils::bench
+{
+  // Deterministic payloads shaped like the messages the library handles in production.
+  // Every generator takes a seed so a benchmark can cycle through distinct but equally sized inputs.
+  namespace corpus
+  {
+    inline std::string price(double value, int decimals = 2)
+    {
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+      return buffer;
+    }
+
+    // Binance style trade event: short keys, prices as strings, one flat object of ~130 bytes
+    inline std::string tradeTick(uint32_t seed)
+    {
+      std::mt19937 rng(seed);
+      std::uniform_real_distribution<double> px(64000, 66000);
+      std::uniform_real_distribution<double> qty(0.001, 2);
+      const uint64_t time = 1729500000000ULL + seed;
+
+      return R"({"e":"trade","E":)" + std::to_string(time) + R"(,"s":"BTCUSDT","t":)" +
+             std::to_string(3900000000ULL + seed) + R"(,"p":")" + price(px(rng)) + R"(","q":")" +
+             price(qty(rng), 5) + R"(","T":)" + std::to_string(time - 1) + R"(,"m":)" +
+             (rng() % 2 ? "true" : "false") + R"(,"M":true})";
+    }
+
+    // Order book snapshot with numeric [price, quantity] levels on each side
+    inline std::string l2Snapshot(uint32_t seed, int levels = 500)
+    {
+      std::mt19937 rng(seed);
+      std::uniform_real_distribution<double> qty(0.001, 25);
+      const double mid = 65000 + seed % 100;
+
+      std::string out = R"({"lastUpdateId":)" + std::to_string(45000000000ULL + seed) + R"(,"symbol":"BTCUSDT","bids":[)";
+      for (int i = 0; i < levels; ++i)
+        out += (i ? ",[" : "[") + price(mid - 0.1 * (i + 1), 1) + "," + price(qty(rng), 5) + "]";
+      out += R"(],"asks":[)";
+      for (int i = 0; i < levels; ++i)
+        out += (i ? ",[" : "[") + price(mid + 0.1 * (i + 1), 1) + "," + price(qty(rng), 5) + "]";
+      out += "]}";
+      return out;
+    }
+
+    // Array of uniform candle objects, the typical large REST history response
+    inline std::string candles(uint32_t seed, int count = 10000)
+    {
+      std::mt19937 rng(seed);
+      std::normal_distribution<double> move(0, 15);
+      double close = 65000;
+
+      std::string out = "[";
+      for (int i = 0; i < count; ++i) {
+        const double open = close;
+        close = open + move(rng);
+        const double high = std::max(open, close) + std::abs(move(rng));
+        const double low = std::min(open, close) - std::abs(move(rng));
+        out += (i ? "," : "") + std::string(R"({"t":)") + std::to_string(1729500000000ULL + 60000ULL * i) +
+               R"(,"o":)" + price(open) + R"(,"h":)" + price(high) + R"(,"l":)" + price(low) +
+               R"(,"c":)" + price(close) + R"(,"v":)" + price(std::abs(move(rng)) * 3, 4) + "}";
+      }
+      out += "]";
+      return out;
+    }
+
+    // Deeply nested configuration: each level carries a few settings and a "child" object
+    inline std::string nestedConfig(uint32_t seed, int depth = 32)
+    {
+      std::string out;
+      for (int i = 0; i < depth; ++i)
+        out += R"({"name":"level)" + std::to_string(i) + R"(","enabled":)" + ((seed + i) % 3 ? "true" : "false") +
+               R"(,"limits":{"maxOrders":)" + std::to_string(100 + i) + R"(,"maxNotional":)" +
+               price(1e6 / (i + 1)) + R"(},"tags":["risk","level)" + std::to_string(i) + R"("],"child":)";
+      out += "null";
+      out.append(depth, '}');
+      return out;
+    }
+
+    // Count distinct variants of one generator, for benchmarks that cycle inputs
+    template <typename Generator>
+    std::vector<std::string> variants(Generator&& generate, uint32_t count)
+    {
+      std::vector<std::string> out;
+      for (uint32_t i = 0; i < count; ++i)
+        out.push_back(generate(i));
+      return out;
+    }
+  }
+}
+
+#endif //MGUTILS_JSONCORPUS_H
@@ -0,0 +1,188 @@
+// CSV benchmarks: writing trades through CsvWriter against the ofstream code it replaces, and
+// reading them back: the structural scan kernels, record splitting with and without them, whole
+// file loads against the rapidcsv based CsvLoader and time range reads with and without the index.
+// MB/s is over the CSV text.
+//
+//   ./csv_bench            run everything
+//   ./csv_bench write      run benchmarks whose name contains "write"
+//   ./csv_bench scan       compare the scalar, SSE4.2 and AVX2 kernels
+//
+// MGUTILS_BENCH_BUDGET_MS sets the time spent per benchmark (default 500).
+
+#include "BenchHarness.h"
+#include <mgutils/CsvLoader.h>
+#include <mgutils/csv/CsvScanner.h>
+#include <mgutils/csv/CsvTimeIndex.h>
+#include <mgutils/csv/CsvWriter.h>
+#include <mgutils/csv/MappedCsvReader.h>
+#include <mgutils/models/Trade.h>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+using namespace mgutils;
+using namespace mgutils::bench;
+
+namespace
+{
+  // Rows go to /dev/null: the point is the formatting and buffering cost, not the disk
+  const char* const SINK = "/dev/null";
+
+  std::vector<models::Trade> makeTrades(size_t count)
+  {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> px(64000, 66000);
+    std::uniform_real_distribution<double> qty(0.001, 2);
+
+    std::vector<models::Trade> trades(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto& trade = trades[i];
+      trade.source = "binance";
+      trade.symbol = "BTCUSDT";
+      trade.price = std::round(px(rng) * 100) / 100;
+      trade.amount = std::round(qty(rng) * 100000) / 100000;
+      trade.makerSide = rng() % 2 ? models::BUY : models::SELL;
+      trade.time = 1729500000000LL + static_cast<int64_t>(i);
+    }
+    return trades;
+  }
+
+  void writeBenchmarks(Runner& runner)
+  {
+    const auto trades = makeTrades(1024);
+    const size_t rowBytes = 55; // typical formatted trade row
+
+    {
+      // What persisting row by row looks like without the writer; precision 17 keeps it lossless like to_chars
+      std::ofstream out(SINK);
+      out.precision(17);
+      size_t i = 0;
+      runner.run("write/trade/ofstream", rowBytes, [&] {
+        const auto& trade = trades[i++ % trades.size()];
+        out << trade.source << ',' << trade.symbol << ',' << trade.price << ',' << trade.amount << ','
+            << trade.makerSide << ',' << trade.time << '\n';
+      });
+    }
+    {
+      CsvWriter writer(SINK);
+      size_t i = 0;
+      runner.run("write/trade/CsvWriter", rowBytes, [&] { writer.append(trades[i++ % trades.size()]); });
+    }
+    {
+      CsvWriterOptions options;
+      options.background = true;
+      CsvWriter writer(SINK, options);
+      size_t i = 0;
+      runner.run("write/trade/CsvWriter-background", rowBytes, [&] { writer.append(trades[i++ % trades.size()]); });
+    }
+    {
+      CsvWriter writer(SINK);
+      size_t i = 0;
+      runner.run("write/trade/CsvWriter-writeRow", rowBytes, [&] {
+        const auto& trade = trades[i++ % trades.size()];
+        writer.writeRow(trade.source, trade.symbol, trade.price, trade.amount, trade.makerSide, trade.time);
+      });
+    }
+  }
+
+  void readBenchmarks(Runner& runner)
+  {
+    // About 10 MB, large enough that a load is dominated by scanning rather than setup
+    const std::string path = "csv_bench_trades.csv";
+    {
+      CsvWriterOptions options;
+      options.append = false;
+      CsvWriter writer(path, options);
+      writer.writeHeader<models::Trade>();
+      for (const auto& trade : makeTrades(200000))
+        writer.append(trade);
+    }
+
+    std::string text;
+    {
+      std::ifstream in(path, std::ios::binary);
+      text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t bytes = text.size();
+
+    for (auto kernel : {csv::CsvScanKernel::Scalar, csv::CsvScanKernel::Sse42, csv::CsvScanKernel::Avx2})
+    {
+      if (!csv::scanKernelSupported(kernel))
+        continue;
+      const csv::CsvScanner scanner({}, kernel);
+      std::vector<csv::CsvBlockMasks> masks(bytes / csv::CsvScanner::BLOCK_SIZE + 1);
+      runner.run(std::string("scan/trades/") + csv::scanKernelName(kernel), bytes, [&] {
+        scanner.classify(text.data(), text.size(), masks.data(), masks.size());
+        clobberMemory();
+      });
+    }
+
+    // Trade rows have no quotes, so splitting leaves the text as it was and can be repeated on it
+    {
+      csv::CsvTokenizer tokenizer;
+      std::vector<csv::CsvField> fields;
+      runner.run("split/trades/CsvTokenizer", bytes, [&] {
+        size_t records = 0;
+        for (size_t pos = 0; pos < text.size(); ++records)
+          pos += tokenizer.next(text.data() + pos, text.size() - pos, true, fields);
+        doNotOptimize(records);
+      });
+    }
+    {
+      const csv::CsvScanner scanner;
+      runner.run(std::string("split/trades/CsvScanner-") + csv::scanKernelName(scanner.kernel()), bytes, [&] {
+        size_t records = 0;
+        scanner.forEachRecord(text.data(), 0, text.size(),
+                              [&](size_t, const csv::CsvField*, size_t) { ++records; });
+        doNotOptimize(records);
+      });
+    }
+
+    runner.run("load/trades/CsvLoader", bytes, [&] {
+      CsvLoader loader(path);
+      doNotOptimize(loader.getColumn<double>("price"));
+    });
+    runner.run("load/trades/MappedCsvReader", bytes, [&] {
+      MappedCsvReader reader(path);
+      doNotOptimize(reader.getColumn<double>("price"));
+    });
+    runner.run("load/trades/loadColumns", bytes, [&] {
+      auto table = CsvLoader::loadColumns<double>(path, {"price"});
+      doNotOptimize(table.column<0>());
+    });
+
+    // An hour out of a day of trades, stopping at its end either way: a stream from the top of the
+    // file against a seek through the time index. MB/s is over the whole file.
+    const int64_t from = 1729500000000LL + 100000;
+    const int64_t to = from + 200000 / 24;
+    runner.run("range/trades/rows", bytes, [&] {
+      size_t count = 0;
+      auto rows = CsvLoader::rows(path);
+      const size_t time = rows.columnIndex("time");
+      for (const CsvRow& row : rows)
+      {
+        const auto value = row.get<int64_t>(time);
+        if (value >= to)
+          break;
+        count += value >= from;
+      }
+      doNotOptimize(count);
+    });
+    CsvTimeIndex::build(path, "time");
+    runner.run("range/trades/readRange", bytes, [&] {
+      doNotOptimize(CsvLoader::readRange(path, from, to, [](const CsvRow&) {}));
+    });
+
+    std::remove(CsvTimeIndex::sidecarPath(path).c_str());
+    std::remove(path.c_str());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Runner runner(argc, argv);
+  writeBenchmarks(runner);
+  readBenchmarks(runner);
+  return 0;
+}
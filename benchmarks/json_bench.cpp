@@ -0,0 +1,395 @@
+// JSON benchmarks: parse, lookup, iteration, build and serialization through the mgutils wrapper
+// against the same work done with raw rapidjson, over the payloads in JsonCorpus.h.
+//
+//   ./json_bench            run everything
+//   ./json_bench parse/l2   run benchmarks whose name contains "parse/l2"
+//
+// MGUTILS_BENCH_BUDGET_MS sets the time spent per benchmark (default 500).
+
+#include "BenchHarness.h"
+#include "JsonCorpus.h"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include <mgutils/Json.h>
+#include <mgutils/json/LazyJson.h>
+#include <cstdio>
+
+using namespace mgutils;
+using namespace mgutils::bench;
+
+namespace
+{
+  constexpr uint32_t VARIANTS = 8;
+
+  struct Payload
+  {
+    std::string name;
+    std::vector<std::string> inputs;
+
+    size_t size() const { return inputs.front().size(); }
+  };
+
+  // Cycles through the variants of a payload so branch predictors cannot learn a single input
+  class Cycle
+  {
+  public:
+    explicit Cycle(const std::vector<std::string>& inputs): _inputs(inputs) {}
+    const std::string& next() { return _inputs[_index++ % _inputs.size()]; }
+
+  private:
+    const std::vector<std::string>& _inputs;
+    size_t _index = 0;
+  };
+
+  void parseBenchmarks(Runner& runner, const Payload& payload)
+  {
+    {
+      Cycle inputs(payload.inputs);
+      runner.run("parse/" + payload.name + "/rapidjson", payload.size(), [&] {
+        rapidjson::Document document;
+        const std::string& input = inputs.next();
+        document.Parse(input.c_str(), input.size());
+        doNotOptimize(document.IsObject());
+      });
+    }
+    {
+      Cycle inputs(payload.inputs);
+      runner.run("parse/" + payload.name + "/wrapper", payload.size(), [&] {
+        auto document = Json::parse(inputs.next());
+        doNotOptimize(document);
+      });
+    }
+    {
+      Cycle inputs(payload.inputs);
+      auto pool = std::make_shared<StringPool>();
+      runner.run("parse/" + payload.name + "/wrapper-pool", payload.size(), [&] {
+        auto document = Json::parse(inputs.next(), pool);
+        doNotOptimize(document);
+      });
+    }
+    {
+      Cycle inputs(payload.inputs);
+      runner.run("parse/" + payload.name + "/lazy", payload.size(), [&] {
+        auto document = LazyJson::parse(inputs.next());
+        doNotOptimize(document);
+      });
+    }
+
+    // Binary decoding, reported against the size of the equivalent text for comparison
+    std::vector<std::vector<uint8_t>> msgPack;
+    std::vector<std::vector<uint8_t>> cbor;
+    for (const auto& input : payload.inputs)
+    {
+      auto document = Json::parse(input);
+      msgPack.push_back(document->toMsgPack());
+      cbor.push_back(document->toCbor());
+    }
+    {
+      size_t index = 0;
+      runner.run("parse/" + payload.name + "/msgpack", payload.size(), [&] {
+        auto document = Json::parseMsgPack(msgPack[index++ % msgPack.size()]);
+        doNotOptimize(document);
+      });
+    }
+    {
+      size_t index = 0;
+      runner.run("parse/" + payload.name + "/cbor", payload.size(), [&] {
+        auto document = Json::parseCbor(cbor[index++ % cbor.size()]);
+        doNotOptimize(document);
+      });
+    }
+  }
+
+  void serializeBenchmarks(Runner& runner, const Payload& payload)
+  {
+    rapidjson::Document raw;
+    raw.Parse(payload.inputs.front().c_str(), payload.size());
+    auto document = Json::parse(payload.inputs.front());
+
+    rapidjson::StringBuffer buffer;
+    runner.run("serialize/" + payload.name + "/rapidjson", payload.size(), [&] {
+      buffer.Clear();
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      raw.Accept(writer);
+      doNotOptimize(buffer.GetString());
+    });
+    runner.run("serialize/" + payload.name + "/wrapper-toString", payload.size(), [&] {
+      auto text = document->toString();
+      doNotOptimize(text);
+    });
+
+    std::string out;
+    runner.run("serialize/" + payload.name + "/wrapper-serializeTo", payload.size(), [&] {
+      out.clear();
+      document->serializeTo(out);
+      doNotOptimize(out.data());
+      clobberMemory();
+    });
+
+    std::vector<uint8_t> msgPack;
+    runner.run("serialize/" + payload.name + "/wrapper-msgpack", payload.size(), [&] {
+      msgPack.clear();
+      document->toMsgPack(msgPack);
+      doNotOptimize(msgPack.data());
+      clobberMemory();
+    });
+
+    std::vector<uint8_t> cbor;
+    runner.run("serialize/" + payload.name + "/wrapper-cbor", payload.size(), [&] {
+      cbor.clear();
+      document->toCbor(cbor);
+      doNotOptimize(cbor.data());
+      clobberMemory();
+    });
+  }
+
+  // Encoded size of the first variant of each payload as text, MessagePack and CBOR
+  void reportEncodedSizes(const std::vector<Payload>& payloads)
+  {
+    std::printf("\n%-16s %12s %12s %12s\n", "payload", "json bytes", "msgpack", "cbor");
+    for (const auto& payload : payloads)
+    {
+      auto document = Json::parse(payload.inputs.front());
+      const size_t json = document->toString().size();
+      const size_t msgPack = document->toMsgPack().size();
+      const size_t cbor = document->toCbor().size();
+      std::printf("%-16s %12zu %6zu (%3.0f%%) %6zu (%3.0f%%)\n", payload.name.c_str(), json,
+                  msgPack, 100.0 * msgPack / json, cbor, 100.0 * cbor / json);
+    }
+  }
+
+  void tickBenchmarks(Runner& runner, const Payload& ticks)
+  {
+    rapidjson::Document raw;
+    raw.Parse(ticks.inputs.front().c_str());
+    auto document = Json::parse(ticks.inputs.front());
+    JsonValue root = document->getRoot();
+    JsonView view = document->view();
+
+    runner.run("lookup/tick/rapidjson", 0, [&] {
+      doNotOptimize(raw["s"].GetString());
+      doNotOptimize(raw["p"].GetString());
+      doNotOptimize(raw["T"].GetUint64());
+      doNotOptimize(raw["m"].GetBool());
+    });
+    runner.run("lookup/tick/wrapper-value", 0, [&] {
+      doNotOptimize(root.getString("s"));
+      doNotOptimize(root.getString("p"));
+      doNotOptimize(root.getUint64("T"));
+      doNotOptimize(root.getBool("m"));
+    });
+    runner.run("lookup/tick/wrapper-view", 0, [&] {
+      doNotOptimize(view.get<std::string_view>("s"));
+      doNotOptimize(view.get<std::string_view>("p"));
+      doNotOptimize(view.get<uint64_t>("T"));
+      doNotOptimize(view.get<bool>("m"));
+    });
+
+    // Parse plus the reads a trade handler does, the end to end cost per message
+    Cycle domInputs(ticks.inputs);
+    runner.run("parse+read/tick/wrapper", ticks.size(), [&] {
+      auto message = Json::parse(domInputs.next())->view();
+      doNotOptimize(message.get<std::string_view>("s"));
+      doNotOptimize(message.get<std::string_view>("p"));
+      doNotOptimize(message.get<uint64_t>("T"));
+    });
+    Cycle lazyInputs(ticks.inputs);
+    runner.run("parse+read/tick/lazy", ticks.size(), [&] {
+      auto message = LazyJson::parse(lazyInputs.next())->root();
+      doNotOptimize(message.get<std::string_view>("s"));
+      doNotOptimize(message.get<std::string_view>("p"));
+      doNotOptimize(message.get<uint64_t>("T"));
+    });
+
+    runner.run("build/tick/rapidjson", 0, [&] {
+      rapidjson::Document out(rapidjson::kObjectType);
+      auto& allocator = out.GetAllocator();
+      rapidjson::Value event(rapidjson::StringRef("trade"));
+      rapidjson::Value eventTime(uint64_t(1729500000123));
+      rapidjson::Value symbol(rapidjson::StringRef("BTCUSDT"));
+      rapidjson::Value price("65000.50", allocator);
+      rapidjson::Value quantity("0.01500", allocator);
+      rapidjson::Value maker(true);
+      out.AddMember("e", event, allocator);
+      out.AddMember("E", eventTime, allocator);
+      out.AddMember("s", symbol, allocator);
+      out.AddMember("p", price, allocator);
+      out.AddMember("q", quantity, allocator);
+      out.AddMember("m", maker, allocator);
+      doNotOptimize(out.MemberCount());
+    });
+    runner.run("build/tick/wrapper-set", 0, [&] {
+      auto out = Json::createDocument();
+      auto message = out->getRoot();
+      message.set("e", "trade").set("E", uint64_t(1729500000123)).set("s", "BTCUSDT");
+      message.set("p", std::string("65000.50")).set("q", std::string("0.01500")).set("m", true);
+      out->setRoot(std::move(message));
+      doNotOptimize(out);
+    });
+    runner.run("build/tick/wrapper-builder", 0, [&] {
+      auto out = Json::createDocument();
+      out->setRoot(ObjectBuilder(out, 6, true)
+                       .add("e", "trade")
+                       .add("E", uint64_t(1729500000123))
+                       .add("s", "BTCUSDT")
+                       .add("p", "65000.50")
+                       .add("q", "0.01500")
+                       .add("m", true)
+                       .build());
+      doNotOptimize(out);
+    });
+  }
+
+  void l2Benchmarks(Runner& runner, const Payload& snapshots)
+  {
+    rapidjson::Document raw;
+    raw.Parse(snapshots.inputs.front().c_str());
+    auto document = Json::parse(snapshots.inputs.front());
+    JsonValue root = document->getRoot();
+    JsonView view = document->view();
+
+    runner.run("iterate/l2/rapidjson", 0, [&] {
+      double notional = 0;
+      for (const auto& level : raw["bids"].GetArray())
+        notional += level[0].GetDouble() * level[1].GetDouble();
+      doNotOptimize(notional);
+    });
+    runner.run("iterate/l2/wrapper-getArray", 0, [&] {
+      double notional = 0;
+      for (const auto& level : root.getArray("bids")) {
+        auto pair = level.getArray();
+        notional += *pair[0].asDouble() * *pair[1].asDouble();
+      }
+      doNotOptimize(notional);
+    });
+    runner.run("iterate/l2/wrapper-view", 0, [&] {
+      double notional = 0;
+      view.get("bids")->forEach([&](JsonView level) {
+        notional += *level.at(0)->asDouble() * *level.at(1)->asDouble();
+      });
+      doNotOptimize(notional);
+    });
+
+    std::vector<double> prices;
+    runner.run("iterate/l2/wrapper-getNumbers", 0, [&] {
+      double total = 0;
+      view.get("bids")->forEach([&](JsonView level) {
+        level.asNumbers(prices);
+        total += prices[0] * prices[1];
+      });
+      doNotOptimize(total);
+    });
+
+    runner.run("build/l2/wrapper-set", 0, [&] {
+      auto out = Json::createDocument();
+      std::vector<JsonValue> levels;
+      levels.reserve(100);
+      for (int i = 0; i < 100; ++i) {
+        JsonValue level(out);
+        level.set("px", 65000.0 - i).set("qty", 1.5);
+        levels.push_back(std::move(level));
+      }
+      auto message = out->getRoot();
+      message.set("bids", std::move(levels));
+      doNotOptimize(out);
+    });
+    runner.run("build/l2/wrapper-builder", 0, [&] {
+      auto out = Json::createDocument();
+      ArrayBuilder bids(out, 100);
+      for (int i = 0; i < 100; ++i)
+        bids.push(ObjectBuilder(out, 2, true).add("px", 65000.0 - i).add("qty", 1.5).build());
+      out->setRoot(ObjectBuilder(out, 1, true).add("bids", std::move(bids)).build());
+      doNotOptimize(out);
+    });
+  }
+
+  void candleBenchmarks(Runner& runner, const Payload& candles)
+  {
+    rapidjson::Document raw;
+    raw.Parse(candles.inputs.front().c_str());
+    auto document = Json::parse(candles.inputs.front());
+    JsonView view = document->view();
+
+    runner.run("lookup/candles/rapidjson-middle", 0, [&] {
+      doNotOptimize(raw[raw.Size() / 2]["c"].GetDouble());
+    });
+    runner.run("lookup/candles/wrapper-middle", 0, [&] {
+      doNotOptimize(view.at(view.size() / 2)->get<double>("c"));
+    });
+
+    runner.run("iterate/candles/rapidjson", candles.size(), [&] {
+      double sum = 0;
+      for (const auto& candle : raw.GetArray())
+        sum += candle["c"].GetDouble();
+      doNotOptimize(sum);
+    });
+    runner.run("iterate/candles/wrapper-view", candles.size(), [&] {
+      double sum = 0;
+      view.forEach([&](JsonView candle) { sum += candle.getOr<double>("c", 0); });
+      doNotOptimize(sum);
+    });
+
+    std::vector<uint64_t> times;
+    std::vector<double> closes;
+    runner.run("iterate/candles/wrapper-columns", candles.size(), [&] {
+      view.asColumns({"t", "c"}, times, closes);
+      doNotOptimize(closes.data());
+      clobberMemory();
+    });
+  }
+
+  void configBenchmarks(Runner& runner, const Payload& configs)
+  {
+    rapidjson::Document raw;
+    raw.Parse(configs.inputs.front().c_str());
+    auto document = Json::parse(configs.inputs.front());
+    JsonValue root = document->getRoot();
+    JsonView view = document->view();
+
+    runner.run("lookup/config/rapidjson-deepest", 0, [&] {
+      const rapidjson::Value* level = &raw;
+      while (level->HasMember("child") && level->FindMember("child")->value.IsObject())
+        level = &(*level)["child"];
+      doNotOptimize((*level)["limits"]["maxOrders"].GetInt());
+    });
+    runner.run("lookup/config/wrapper-value-deepest", 0, [&] {
+      JsonValue level = root.getObject("child");
+      while (level.hasObject("child"))
+        level = level.getObject("child");
+      doNotOptimize(level.getObject("limits").getInt("maxOrders"));
+    });
+    runner.run("lookup/config/wrapper-view-deepest", 0, [&] {
+      JsonView level = view;
+      while (level.hasObject("child"))
+        level = *level.get("child");
+      doNotOptimize(level.get("limits")->get<int>("maxOrders"));
+    });
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Runner runner(argc, argv);
+
+  const std::vector<Payload> payloads = {
+      {"tick", corpus::variants([](uint32_t seed) { return corpus::tradeTick(seed); }, VARIANTS)},
+      {"l2", corpus::variants([](uint32_t seed) { return corpus::l2Snapshot(seed); }, VARIANTS)},
+      {"candles", corpus::variants([](uint32_t seed) { return corpus::candles(seed); }, 2)},
+      {"config", corpus::variants([](uint32_t seed) { return corpus::nestedConfig(seed); }, VARIANTS)},
+  };
+
+  for (const auto& payload : payloads)
+    parseBenchmarks(runner, payload);
+
+  tickBenchmarks(runner, payloads[0]);
+  l2Benchmarks(runner, payloads[1]);
+  candleBenchmarks(runner, payloads[2]);
+  configBenchmarks(runner, payloads[3]);
+
+  for (const auto& payload : payloads)
+    serializeBenchmarks(runner, payload);
+
+  reportEncodedSizes(payloads);
+  return 0;
+}
@@ -8,6 +8,23 @@ set (MGUTILS_SRCS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/Logger.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonDocument.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonValue.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonView.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonPath.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonPatch.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonSchema.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonBinary.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonIncrementalParser.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/JsonBuilder.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/FrozenJson.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/json/LazyJson.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/MappedCsvReader.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/CsvRowStream.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/CsvParallel.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/CsvWriter.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/CsvColumnCache.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/CsvScanner.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/CsvSource.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/csv/CsvTimeIndex.cpp
 )
 
 set (MGUTILS_INCLUDE_DIRS
@@ -2,26 +2,115 @@
 #define MGUTILS_CSVLOADER_H
 
 #include "rapidcsv.h"
+#include <istream>
 #include <string>
 #include <vector>
 #include <memory>
 #include <stdexcept>
 #include "Exceptions.h"
+#include "CsvTokenizer.h"
+#include "CsvRowStream.h"
+#include "CsvSource.h"
+#include "CsvParallel.h"
+#include "CsvTable.h"
+#include "CsvStruct.h"
+#include "CsvTimeIndex.h"
 
 namespace mgutils {
 
   class CsvLoader {
   public:
+    // The constructors load the whole table through rapidcsv. A compressed file is first decompressed
+    // into memory in full, since rapidcsv seeks in its input, so it needs its decompressed size on top of
+    // the table while loading; rows(), loadColumns and loadStructs stream compressed files instead.
+
     // Constructor with optional delimiter
     explicit CsvLoader(const std::string& filename, char delimiter = ',') {
       try {
         // Pass delimiter parameter to the rapidcsv::Document
-        _document = std::make_unique<rapidcsv::Document>(filename, rapidcsv::LabelParams(0, -1), rapidcsv::SeparatorParams(delimiter));
+        _document = openDocument(filename, rapidcsv::LabelParams(0, -1), rapidcsv::SeparatorParams(delimiter));
+      } catch (const std::exception& e) {
+        throw CsvReadException("Failed to load CSV file: " + std::string(e.what()));
+      }
+    }
+
+    // Same dialect options as the other CSV readers; without a header, columns are addressed by index
+    CsvLoader(const std::string& filename, const CsvOptions& options) {
+      try {
+        // rapidcsv defaults for everything but the delimiter and the quote character
+        _document = openDocument(filename, rapidcsv::LabelParams(options.hasHeader ? 0 : -1, -1),
+                                 rapidcsv::SeparatorParams(options.delimiter, false, rapidcsv::sPlatformHasCR,
+                                                           false, true, options.quote));
       } catch (const std::exception& e) {
         throw CsvReadException("Failed to load CSV file: " + std::string(e.what()));
       }
     }
 
+    // Streams the file instead of loading it: blocks of blockSize bytes are read as the range is iterated
+    // and each step yields the same reusable row view, so memory does not grow with the file.
+    static CsvRowStream rows(const std::string& filename, const CsvOptions& options = {},
+                             size_t blockSize = CsvRowStream::DEFAULT_BLOCK_SIZE) {
+      return CsvRowStream(filename, options, blockSize);
+    }
+
+    // Column names from the first record, without reading the rest of the file
+    static std::vector<std::string> readHeader(const std::string& filename, const CsvOptions& options = {}) {
+      CsvOptions header = options;
+      header.hasHeader = true;
+      return CsvRowStream(filename, header, 64 * 1024).columnNames();
+    }
+
+    // Parses the file on threads JobPool workers (0 for one per core) and returns handler(row) for every
+    // record, in file order. The mapped file is split into byte ranges whose first record start is found
+    // with a quote-aware two-pass scan, so quoted fields may hold newlines. handler runs concurrently and
+    // must be safe to call from several threads; the row it gets is only valid during the call.
+    // A compressed file is decompressed into memory in full before it is split.
+    //
+    //   auto prices = CsvLoader::parallelLoad("trades.csv", [](const CsvRow& row) { return row.get<double>(2); });
+    template <typename Handler>
+    static auto parallelLoad(const std::string& filename, Handler&& handler, size_t threads = 0,
+                             const CsvOptions& options = {}) {
+      return csv::parallelMap(filename, handler, threads, options);
+    }
+
+    // Parses only the named columns, in one pass, into contiguous vectors of the given types:
+    //
+    //   auto table = CsvLoader::loadColumns<double, double, int64_t>("trades.csv", {"price", "amount", "time"});
+    //   const std::vector<double>& prices = table.column<0>();
+    template <typename... Ts>
+    static CsvTable<Ts...> loadColumns(const std::string& filename,
+                                       const std::array<std::string_view, sizeof...(Ts)>& columnNames,
+                                       const CsvOptions& options = {}) {
+      return loadCsvColumns<Ts...>(filename, columnNames, options);
+    }
+
+    // Decodes every record into a struct bound with MG_CSV_STRUCT; header columns are matched to the
+    // struct fields once, by name, and may come in any order
+    template <typename T>
+    static std::vector<T> loadStructs(const std::string& filename, const CsvOptions& options = {}) {
+      return CsvStruct::load<T>(filename, options);
+    }
+
+    // Streams the file and hands the decoded structs out in batches of up to batchSize
+    template <typename T>
+    static void forEachBatch(const std::string& filename, size_t batchSize,
+                             const std::function<void(std::vector<T>& batch)>& callback,
+                             const CsvOptions& options = {}) {
+      CsvStruct::forEachBatch<T>(filename, batchSize, callback, options);
+    }
+
+    // Calls onRow for the records with fromTs <= time < toTs of a file sorted by time and indexed
+    // with CsvTimeIndex::build, and returns how many there were. Parsing starts at the last indexed
+    // record before fromTs and stops at the first record at or past toTs. A file changed since it was
+    // indexed is indexed again first.
+    //
+    //   CsvTimeIndex::build("trades.csv", "time");
+    //   CsvLoader::readRange("trades.csv", from, from + 3600000, [&](const CsvRow& row) { ... });
+    static size_t readRange(const std::string& filename, int64_t fromTs, int64_t toTs,
+                            const std::function<void(const CsvRow&)>& onRow, const CsvOptions& options = {}) {
+      return CsvTimeIndex::load(filename, options).readRange(fromTs, toTs, onRow);
+    }
+
     template <typename T>
     std::vector<T> getColumn(const std::string& columnName) const {
       try {
@@ -79,6 +168,18 @@ namespace mgutils {
     }
 
   private:
+    // gzip and zstd files are decompressed in full on the pipeline thread and parsed from memory
+    static std::unique_ptr<rapidcsv::Document> openDocument(const std::string& filename,
+                                                            const rapidcsv::LabelParams& labels,
+                                                            const rapidcsv::SeparatorParams& separator) {
+      if (csv::detectCompression(filename) == csv::CsvCompression::None)
+        return std::make_unique<rapidcsv::Document>(filename, labels, separator);
+
+      csv::CsvTextBuffer text(csv::readAll(filename));
+      std::istream stream(&text);
+      return std::make_unique<rapidcsv::Document>(stream, labels, separator);
+    }
+
     std::unique_ptr<rapidcsv::Document> _document;
   };
 
@@ -6,6 +6,8 @@
 #define MGUTILS_EXCEPTIONS_H
 
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include "Logger.h"
 
 namespace mgutils
@@ -41,6 +43,34 @@ namespace mgutils
     using Exception::Exception;
   };
 
+  // A document that does not match its JSON schema; the paths are JSON pointers, the schema path a URI fragment
+  class JsonValidationException : public JsonParseException{
+  public:
+    JsonValidationException(const std::string& message, std::string instancePath, std::string schemaPath, std::string keyword)
+        : JsonParseException(message),
+          _instancePath(std::move(instancePath)),
+          _schemaPath(std::move(schemaPath)),
+          _keyword(std::move(keyword))
+    {}
+
+    // Location of the offending value, e.g. "/bids/3/0" ("" for the root)
+    const std::string& instancePath() const { return _instancePath; }
+    // Location of the failing rule, e.g. "#/properties/bids/items"
+    const std::string& schemaPath() const { return _schemaPath; }
+    // The failing keyword, e.g. "type", "required" or "minimum"
+    const std::string& keyword() const { return _keyword; }
+
+  private:
+    std::string _instancePath;
+    std::string _schemaPath;
+    std::string _keyword;
+  };
+
+  class JsonPatchException : public Exception{
+  public:
+    using Exception::Exception;
+  };
+
   class CsvWriteException : public Exception{
   public:
     using Exception::Exception;
@@ -2,8 +2,17 @@
 #define MGUTILS_JSON_H
 
 #include <memory>
+#include "StringPool.h"
 #include "JsonValue.h"
 #include "JsonDocument.h"
+#include "JsonPath.h"
+#include "JsonPatch.h"
+#include "JsonSchema.h"
+#include "JsonWriter.h"
+#include "JsonBuilder.h"
+#include "FrozenJson.h"
+#include "LazyJson.h"
+#include "JsonIncrementalParser.h"
 
 namespace mgutils
 {
@@ -13,12 +22,33 @@ namespace mgutils
     ARRAY
   };
 
+  struct JsonMappedFileOptions
+  {
+    // Parse in place over a private copy-on-write mapping of the file.
+    // Strings in the document point into the mapping, which the document keeps alive. Values copied
+    // or released into another document take their own copies of them.
+    bool inSitu = false;
+  };
+
   class Json
   {
   public:
     static std::shared_ptr<JsonDocument> createDocument(JsonRootType type = JsonRootType::OBJECT);
     static std::shared_ptr<JsonDocument> parse(const std::string& json);
+    static std::shared_ptr<JsonDocument> parse(const char* json, size_t length);
+    // Keys and short string values are interned in pool and referenced, not copied, by the document,
+    // which keeps the pool alive. Look keys up with strings interned from the same pool to compare
+    // them by pointer. Values copied or released into another document copy their pooled strings.
+    // A null pool parses normally.
+    static std::shared_ptr<JsonDocument> parse(const std::string& json, const std::shared_ptr<StringPool>& pool);
+    static std::shared_ptr<JsonDocument> parse(const char* json, size_t length, const std::shared_ptr<StringPool>& pool);
     static std::shared_ptr<JsonDocument> parseFile(const std::string& filePath);
+    static std::shared_ptr<JsonDocument> parseMappedFile(const std::string& filePath, const JsonMappedFileOptions& options = {});
+    // Decode MessagePack / CBOR into a document built in its pooled allocator
+    static std::shared_ptr<JsonDocument> parseMsgPack(const uint8_t* data, size_t size);
+    static std::shared_ptr<JsonDocument> parseMsgPack(const std::vector<uint8_t>& data);
+    static std::shared_ptr<JsonDocument> parseCbor(const uint8_t* data, size_t size);
+    static std::shared_ptr<JsonDocument> parseCbor(const std::vector<uint8_t>& data);
     static bool save(const std::string& strJson, const std::string& file);
   };
 }
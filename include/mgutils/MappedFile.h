@@ -0,0 +1,110 @@
+#ifndef MGUTILS_MAPPEDFILE_H
+#define MGUTILS_MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Exceptions.h"
+
+namespace mgutils
+{
+  // Read-only view of a whole file through mmap.
+  // CopyOnWrite maps the file privately so the bytes can be modified in memory without touching the file.
+  // With nullTerminated the mapping is followed by at least one zero byte, even when the
+  // file size is an exact multiple of the page size.
+  class MappedFile
+  {
+  public:
+    enum class Mode
+    {
+      ReadOnly,
+      CopyOnWrite
+    };
+
+    explicit MappedFile(const std::string& path, Mode mode = Mode::ReadOnly, bool nullTerminated = false):
+        _path(path)
+    {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        throw FilesException("Failed to open file: " + path);
+      }
+
+      struct stat st{};
+      if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw FilesException("Failed to stat file: " + path);
+      }
+
+      _size = static_cast<size_t>(st.st_size);
+      int prot = PROT_READ | (mode == Mode::CopyOnWrite ? PROT_WRITE : 0);
+
+      if (nullTerminated) {
+        // Reserve zeroed anonymous pages for size + 1 bytes and map the file over the front of them
+        _mappedLength = _size + 1;
+        void* base = ::mmap(nullptr, _mappedLength, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+          ::close(fd);
+          throw FilesException("Failed to map file: " + path);
+        }
+
+        if (_size > 0 && ::mmap(base, _size, prot, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+          ::munmap(base, _mappedLength);
+          ::close(fd);
+          throw FilesException("Failed to map file: " + path);
+        }
+        _data = static_cast<char*>(base);
+      }
+      else if (_size > 0) {
+        _mappedLength = _size;
+        void* base = ::mmap(nullptr, _mappedLength, prot, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+          ::close(fd);
+          throw FilesException("Failed to map file: " + path);
+        }
+        _data = static_cast<char*>(base);
+      }
+
+      ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+      if (_data)
+        ::munmap(_data, _mappedLength);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return _data; }
+    char* data() { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const std::string& path() const { return _path; }
+
+    // Hint the kernel that the mapping will be read front to back
+    void adviseSequential() const
+    {
+      if (_data)
+        ::madvise(_data, _mappedLength, MADV_SEQUENTIAL);
+    }
+
+    // Hint the kernel that the mapping will be read at random offsets
+    void adviseRandom() const
+    {
+      if (_data)
+        ::madvise(_data, _mappedLength, MADV_RANDOM);
+    }
+
+  private:
+    std::string _path;
+    char* _data = nullptr;
+    size_t _size = 0;
+    size_t _mappedLength = 0;
+  };
+}
+
+#endif //MGUTILS_MAPPEDFILE_H
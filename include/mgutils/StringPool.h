@@ -0,0 +1,114 @@
+#ifndef MGUTILS_STRINGPOOL_H
+#define MGUTILS_STRINGPOOL_H
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace mgutils
+{
+  // Thread-safe interning arena: equal strings map to one NUL-terminated copy whose address never
+  // changes for the lifetime of the pool, so interned strings can be compared by pointer.
+  // Only strings up to maxLength are interned and the pool stops growing at maxEntries; entries are
+  // never evicted, so it is meant for recurring keys and symbols, not arbitrary payloads.
+  class StringPool
+  {
+  public:
+    explicit StringPool(size_t maxLength = 64, size_t maxEntries = 1 << 20, size_t blockSize = 64 * 1024):
+        _maxLength(maxLength), _maxEntries(maxEntries), _blockSize(std::max(blockSize, maxLength + 1))
+    {}
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Process wide pool for callers that do not manage their own
+    static const std::shared_ptr<StringPool>& global()
+    {
+      static const std::shared_ptr<StringPool> pool = std::make_shared<StringPool>();
+      return pool;
+    }
+
+    // The pooled copy of str, or nullopt when str is too long or the pool is full
+    std::optional<std::string_view> intern(std::string_view str)
+    {
+      if (str.size() > _maxLength)
+        return std::nullopt;
+
+      {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        auto it = _strings.find(str);
+        if (it != _strings.end())
+          return *it;
+      }
+
+      std::unique_lock<std::shared_mutex> lock(_mutex);
+      auto it = _strings.find(str);
+      if (it != _strings.end())
+        return *it;
+      if (_strings.size() >= _maxEntries)
+        return std::nullopt;
+
+      std::string_view pooled(store(str), str.size());
+      _strings.insert(pooled);
+      return pooled;
+    }
+
+    // Looks str up without inserting it
+    std::optional<std::string_view> find(std::string_view str) const
+    {
+      std::shared_lock<std::shared_mutex> lock(_mutex);
+      auto it = _strings.find(str);
+      if (it != _strings.end())
+        return *it;
+      return std::nullopt;
+    }
+
+    size_t size() const
+    {
+      std::shared_lock<std::shared_mutex> lock(_mutex);
+      return _strings.size();
+    }
+
+    // Bytes reserved by the arena
+    size_t capacity() const
+    {
+      std::shared_lock<std::shared_mutex> lock(_mutex);
+      return _blocks.size() * _blockSize;
+    }
+
+    size_t maxLength() const { return _maxLength; }
+
+  private:
+    // Called with the exclusive lock held
+    const char* store(std::string_view str)
+    {
+      if (_blocks.empty() || _used + str.size() + 1 > _blockSize) {
+        _blocks.emplace_back(new char[_blockSize]);
+        _used = 0;
+      }
+
+      char* copy = _blocks.back().get() + _used;
+      std::memcpy(copy, str.data(), str.size());
+      copy[str.size()] = '\0';
+      _used += str.size() + 1;
+      return copy;
+    }
+
+    const size_t _maxLength;
+    const size_t _maxEntries;
+    const size_t _blockSize;
+
+    mutable std::shared_mutex _mutex;
+    std::unordered_set<std::string_view> _strings;
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    size_t _used = 0;
+  };
+}
+
+#endif //MGUTILS_STRINGPOOL_H
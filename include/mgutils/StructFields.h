@@ -0,0 +1,111 @@
+#ifndef MGUTILS_STRUCTFIELDS_H
+#define MGUTILS_STRUCTFIELDS_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+namespace mgutils
+{
+  // Compile-time description of one bound struct member: its external name and member pointer
+  template <typename Owner, typename T>
+  struct StructField
+  {
+    using OwnerType = Owner;
+    using ValueType = T;
+
+    std::string_view name;
+    T Owner::* member;
+  };
+
+  template <typename Owner, typename T>
+  constexpr StructField<Owner, T> makeStructField(std::string_view name, T Owner::* member)
+  {
+    return {name, member};
+  }
+
+  // Calls f(field) for every field of a field tuple, in declaration order
+  template <typename Fields, typename F>
+  constexpr void forEachStructField(const Fields& fields, F&& f)
+  {
+    std::apply([&f](const auto&... field) { (f(field), ...); }, fields);
+  }
+
+  template <typename Fields, typename F, size_t... Is>
+  constexpr bool visitStructFieldImpl(const Fields& fields, size_t index, F&& f, std::index_sequence<Is...>)
+  {
+    return ((index == Is ? (f(std::get<Is>(fields)), true) : false) || ...);
+  }
+
+  // Calls f(field) for the field at a runtime index, returns false if the index is out of range
+  template <typename Fields, typename F>
+  constexpr bool visitStructField(const Fields& fields, size_t index, F&& f)
+  {
+    return visitStructFieldImpl(fields, index, std::forward<F>(f),
+                                std::make_index_sequence<std::tuple_size_v<Fields>>{});
+  }
+
+  template <typename Fields, size_t... Is>
+  constexpr auto structFieldNamesImpl(const Fields& fields, std::index_sequence<Is...>)
+  {
+    return std::array<std::string_view, sizeof...(Is)>{std::get<Is>(fields).name...};
+  }
+
+  // External names of a field tuple as an array, in declaration order
+  template <typename Fields>
+  constexpr auto structFieldNames(const Fields& fields)
+  {
+    return structFieldNamesImpl(fields, std::make_index_sequence<std::tuple_size_v<Fields>>{});
+  }
+}
+
+// Builds a StructField for Type::field named after the member
+#define MGUTILS_STRUCT_FIELD(Type, field) ::mgutils::makeStructField(#field, &Type::field)
+
+// Tuple of StructField for the listed members of Type (up to 32)
+#define MGUTILS_STRUCT_FIELDS(Type, ...) std::make_tuple(MGUTILS_PP_FOR_EACH(MGUTILS_STRUCT_FIELD, Type, __VA_ARGS__))
+
+#define MGUTILS_PP_NARGS(...) MGUTILS_PP_NARGS_IMPL(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define MGUTILS_PP_NARGS_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+
+#define MGUTILS_PP_CAT(a, b) MGUTILS_PP_CAT_IMPL(a, b)
+#define MGUTILS_PP_CAT_IMPL(a, b) a##b
+
+// MGUTILS_PP_FOR_EACH(m, arg, x1, x2, ...) expands to m(arg, x1), m(arg, x2), ...
+#define MGUTILS_PP_FOR_EACH(m, arg, ...) MGUTILS_PP_CAT(MGUTILS_PP_FE_, MGUTILS_PP_NARGS(__VA_ARGS__))(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_1(m, arg, x) m(arg, x)
+#define MGUTILS_PP_FE_2(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_1(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_3(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_2(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_4(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_3(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_5(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_4(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_6(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_5(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_7(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_6(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_8(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_7(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_9(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_8(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_10(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_9(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_11(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_10(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_12(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_11(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_13(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_12(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_14(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_13(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_15(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_14(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_16(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_15(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_17(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_16(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_18(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_17(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_19(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_18(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_20(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_19(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_21(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_20(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_22(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_21(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_23(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_22(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_24(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_23(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_25(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_24(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_26(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_25(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_27(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_26(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_28(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_27(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_29(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_28(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_30(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_29(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_31(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_30(m, arg, __VA_ARGS__)
+#define MGUTILS_PP_FE_32(m, arg, x, ...) m(arg, x), MGUTILS_PP_FE_31(m, arg, __VA_ARGS__)
+
+#endif //MGUTILS_STRUCTFIELDS_H
@@ -0,0 +1,195 @@
+#ifndef MGUTILS_CSVCOLUMNCACHE_H
+#define MGUTILS_CSVCOLUMNCACHE_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "MappedFile.h"
+#include "CsvTokenizer.h"
+
+namespace mgutils
+{
+  namespace csv
+  {
+    // Size and modification time of a source file, the key a sidecar is valid for
+    struct CsvSourceStamp
+    {
+      uint64_t size = 0;
+      int64_t mtimeNs = 0;
+
+      // Throws FilesException when the file cannot be stat'ed
+      static CsvSourceStamp of(const std::string& path);
+
+      bool operator==(const CsvSourceStamp& other) const { return size == other.size && mtimeNs == other.mtimeNs; }
+    };
+
+    // Type tag stored with each cached column: kind in the high nibble, element size in the low one
+    enum class CsvColumnType : uint8_t
+    {
+      Signed = 0x10,
+      Unsigned = 0x20,
+      Floating = 0x30,
+      Bool = 0x40,
+      Char = 0x50,
+      String = 0x60
+    };
+
+    template <typename T>
+    constexpr uint8_t columnTypeTag()
+    {
+      if constexpr (std::is_enum_v<T>)
+        return columnTypeTag<std::underlying_type_t<T>>();
+      else if constexpr (std::is_same_v<T, std::string>)
+        return static_cast<uint8_t>(CsvColumnType::String);
+      else if constexpr (std::is_same_v<T, bool>)
+        return static_cast<uint8_t>(CsvColumnType::Bool) | 1;
+      else if constexpr (std::is_same_v<T, char>)
+        return static_cast<uint8_t>(CsvColumnType::Char) | 1;
+      else if constexpr (std::is_floating_point_v<T>)
+        return static_cast<uint8_t>(CsvColumnType::Floating) | sizeof(T);
+      else if constexpr (std::is_signed_v<T>)
+        return static_cast<uint8_t>(CsvColumnType::Signed) | sizeof(T);
+      else
+        return static_cast<uint8_t>(CsvColumnType::Unsigned) | sizeof(T);
+    }
+
+    // Column data as stored in a sidecar. Fixed size types are the raw array, bools one byte each and
+    // strings rowCount + 1 uint64 offsets followed by the characters. The bytes either live in storage
+    // or, when external is set, in memory owned by the caller (a column vector or another sidecar).
+    struct CsvColumnBlock
+    {
+      std::string name;
+      uint8_t type;
+      std::string_view external;
+      std::string storage;
+
+      std::string_view bytes() const { return external.data() ? external : std::string_view(storage); }
+    };
+
+    // Binary columnar sidecar of a CSV file ("<file>.mgcol"): a header with the source's size and
+    // mtime, the dialect and row count, a directory of columns, then each column as a 64 byte aligned
+    // block in native byte order. A sidecar is only used while the source still has the recorded size
+    // and mtime; otherwise it is ignored and rewritten on the next load.
+    class CsvColumnCache
+    {
+    public:
+      static std::string sidecarPath(const std::string& source) { return source + ".mgcol"; }
+
+      // The sidecar of source when it exists, is well formed and matches stamp and options; null otherwise
+      static std::unique_ptr<CsvColumnCache> open(const std::string& source, const CsvSourceStamp& stamp,
+                                                  const CsvOptions& options);
+
+      // Writes the sidecar through a temporary file renamed over the old one, so readers never see
+      // half a file. Throws CsvWriteException.
+      static void write(const std::string& source, const CsvSourceStamp& stamp, const CsvOptions& options,
+                        size_t rowCount, const std::vector<CsvColumnBlock>& columns);
+
+      size_t rowCount() const { return _rowCount; }
+
+      // Block of the named column when it was cached with the same type, nullptr otherwise
+      const char* find(std::string_view name, uint8_t type, size_t& bytes) const;
+
+      // Fills out from a cached column; false when the column is missing or has another type
+      template <typename T>
+      bool read(std::string_view name, std::vector<T>& out) const
+      {
+        size_t bytes = 0;
+        const char* block = find(name, columnTypeTag<T>(), bytes);
+        if (!block)
+          return false;
+
+        if constexpr (std::is_same_v<T, std::string>) {
+          if (bytes < (_rowCount + 1) * sizeof(uint64_t))
+            return false;
+          const char* chars = block + (_rowCount + 1) * sizeof(uint64_t);
+          const size_t charBytes = bytes - (_rowCount + 1) * sizeof(uint64_t);
+
+          out.clear();
+          out.reserve(_rowCount);
+          uint64_t begin = 0;
+          std::memcpy(&begin, block, sizeof(begin));
+          for (size_t i = 0; i < _rowCount; ++i)
+          {
+            uint64_t end;
+            std::memcpy(&end, block + (i + 1) * sizeof(uint64_t), sizeof(end));
+            if (end < begin || end > charBytes)
+              return false;
+            out.emplace_back(chars + begin, end - begin);
+            begin = end;
+          }
+        } else if constexpr (std::is_same_v<T, bool>) {
+          if (bytes != _rowCount)
+            return false;
+          out.resize(_rowCount);
+          for (size_t i = 0; i < _rowCount; ++i)
+            out[i] = block[i] != 0;
+        } else {
+          if (bytes != _rowCount * sizeof(T))
+            return false;
+          out.resize(_rowCount);
+          if (bytes > 0)
+            std::memcpy(out.data(), block, bytes);
+        }
+        return true;
+      }
+
+      // Every cached column, pointing into this sidecar's mapping
+      std::vector<CsvColumnBlock> blocks() const;
+
+      // Block for a column; fixed size columns are referenced rather than copied, so column has to
+      // outlive the block
+      template <typename T>
+      static CsvColumnBlock encode(std::string name, const std::vector<T>& column)
+      {
+        CsvColumnBlock block{std::move(name), columnTypeTag<T>(), {}, {}};
+        if constexpr (std::is_same_v<T, std::string>) {
+          size_t chars = 0;
+          for (const auto& value : column)
+            chars += value.size();
+          block.storage.resize((column.size() + 1) * sizeof(uint64_t) + chars);
+
+          char* offsets = block.storage.data();
+          char* data = offsets + (column.size() + 1) * sizeof(uint64_t);
+          uint64_t offset = 0;
+          std::memcpy(offsets, &offset, sizeof(offset));
+          for (size_t i = 0; i < column.size(); ++i)
+          {
+            std::memcpy(data + offset, column[i].data(), column[i].size());
+            offset += column[i].size();
+            std::memcpy(offsets + (i + 1) * sizeof(uint64_t), &offset, sizeof(offset));
+          }
+        } else if constexpr (std::is_same_v<T, bool>) {
+          block.storage.resize(column.size());
+          for (size_t i = 0; i < column.size(); ++i)
+            block.storage[i] = column[i] ? 1 : 0;
+        } else {
+          block.external = std::string_view(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+          if (!block.external.data())
+            block.external = std::string_view("", 0);
+        }
+        return block;
+      }
+
+    private:
+      struct Entry
+      {
+        std::string_view name;
+        uint8_t type;
+        uint64_t offset;
+        uint64_t bytes;
+      };
+
+      explicit CsvColumnCache(const std::string& path): _file(path) {}
+
+      MappedFile _file;
+      size_t _rowCount = 0;
+      std::vector<Entry> _entries;
+    };
+  }
+}
+
+#endif //MGUTILS_CSVCOLUMNCACHE_H
@@ -0,0 +1,270 @@
+#ifndef MGUTILS_CSVCONVERT_H
+#define MGUTILS_CSVCONVERT_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "Exceptions.h"
+
+namespace mgutils
+{
+  namespace csv
+  {
+    // Slow path for text the fast path declines (exponents, long mantissas, inf, nan)
+    inline bool parseDoubleSlow(std::string_view text, double& out)
+    {
+#if defined(__cpp_lib_to_chars)
+      const char* begin = text.data();
+      const char* end = begin + text.size();
+      // from_chars takes no '+', and a '+' dropped before another sign would let "+-5" through
+      if (begin != end && *begin == '+') {
+        if (end - begin < 2 || begin[1] == '-' || begin[1] == '+')
+          return false;
+        ++begin;
+      }
+      double value;
+      auto result = std::from_chars(begin, end, value);
+      if (result.ec != std::errc() || result.ptr != end)
+        return false;
+      out = value;
+      return true;
+#else
+      // Standard libraries without floating point from_chars; strtod needs a terminated copy
+      char buffer[64];
+      std::string heap;
+      const char* terminated;
+      if (text.size() < sizeof(buffer)) {
+        text.copy(buffer, text.size());
+        buffer[text.size()] = '\0';
+        terminated = buffer;
+      } else {
+        heap.assign(text);
+        terminated = heap.c_str();
+      }
+
+      if (text.empty() || text.front() == ' ' || text.front() == '\t')
+        return false;
+      char* parsed = nullptr;
+      double value = std::strtod(terminated, &parsed);
+      if (parsed != terminated + text.size())
+        return false;
+      out = value;
+      return true;
+#endif
+    }
+
+    // Decimal text to double. Plain decimals with at most 15 significant digits are computed as
+    // mantissa * 10^exponent, which is exact in double precision (Clinger's fast path); anything else
+    // falls back to the correctly rounded library parser.
+    inline bool parseDouble(std::string_view text, double& out)
+    {
+      static constexpr double powersOf10[] = {
+          1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+          1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+      const char* p = text.data();
+      const char* end = p + text.size();
+
+      bool negative = false;
+      if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+      }
+
+      uint64_t mantissa = 0;
+      int digits = 0;
+      int exponent = 0;
+      bool any = false;
+
+      for (; p != end && static_cast<unsigned char>(*p - '0') < 10; ++p, any = true)
+      {
+        if (mantissa == 0 && *p == '0')
+          continue;
+        if (++digits > 15)
+          return parseDoubleSlow(text, out);
+        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+      }
+
+      if (p != end && *p == '.') {
+        for (++p; p != end && static_cast<unsigned char>(*p - '0') < 10; ++p, any = true)
+        {
+          --exponent;
+          if (mantissa == 0 && *p == '0')
+            continue;
+          if (++digits > 15)
+            return parseDoubleSlow(text, out);
+          mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        }
+      }
+
+      if (p != end || !any)
+        return parseDoubleSlow(text, out);
+      if (exponent < -22)
+        return parseDoubleSlow(text, out);
+
+      double value = static_cast<double>(mantissa);
+      value = exponent < 0 ? value / powersOf10[-exponent] : value;
+      out = negative ? -value : value;
+      return true;
+    }
+
+    template <typename T>
+    inline bool parseInteger(std::string_view text, T& out)
+    {
+      const char* begin = text.data();
+      const char* end = begin + text.size();
+      // from_chars takes no '+'; it is only dropped before a digit, so "+-5" stays malformed
+      if (begin != end && *begin == '+') {
+        if (end - begin < 2 || static_cast<unsigned char>(begin[1] - '0') >= 10)
+          return false;
+        ++begin;
+      }
+      T value;
+      auto result = std::from_chars(begin, end, value);
+      if (result.ec != std::errc() || result.ptr != end || begin == end)
+        return false;
+      out = value;
+      return true;
+    }
+
+    inline bool equalsIgnoreCase(std::string_view text, std::string_view lower)
+    {
+      if (text.size() != lower.size())
+        return false;
+      for (size_t i = 0; i < text.size(); ++i)
+      {
+        char c = text[i];
+        if (c >= 'A' && c <= 'Z')
+          c = static_cast<char>(c - 'A' + 'a');
+        if (c != lower[i])
+          return false;
+      }
+      return true;
+    }
+
+    template <typename T>
+    inline constexpr bool unsupportedCellType = false;
+
+    // Converts a cell without locale or allocation; the whole cell has to be consumed.
+    // Supports std::string_view (pointing into the reader's buffer), std::string, bool (true/false,
+    // any case, or 1/0), char (a one character cell), integers, floating point and enums (through
+    // their underlying integer). out is only written on success.
+    template <typename T>
+    inline bool parse(std::string_view text, T& out)
+    {
+      if constexpr (std::is_same_v<T, std::string_view>) {
+        out = text;
+        return true;
+      } else if constexpr (std::is_same_v<T, std::string>) {
+        out.assign(text.data(), text.size());
+        return true;
+      } else if constexpr (std::is_same_v<T, bool>) {
+        if (text == "1" || equalsIgnoreCase(text, "true"))
+          out = true;
+        else if (text == "0" || equalsIgnoreCase(text, "false"))
+          out = false;
+        else
+          return false;
+        return true;
+      } else if constexpr (std::is_same_v<T, char>) {
+        if (text.size() != 1)
+          return false;
+        out = text.front();
+        return true;
+      } else if constexpr (std::is_enum_v<T>) {
+        std::underlying_type_t<T> raw;
+        if (!parse(text, raw))
+          return false;
+        out = static_cast<T>(raw);
+        return true;
+      } else if constexpr (std::is_floating_point_v<T>) {
+        double value;
+        if (!parseDouble(text, value))
+          return false;
+        out = static_cast<T>(value);
+        return true;
+      } else if constexpr (std::is_integral_v<T>) {
+        return parseInteger(text, out);
+      } else {
+        static_assert(unsupportedCellType<T>, "Unsupported type for a CSV cell");
+        return false;
+      }
+    }
+
+    // Longest text formatDouble produces
+    constexpr size_t MAX_DOUBLE_LENGTH = 32;
+
+    // Double to the shortest text that reads back to the same value, into out (MAX_DOUBLE_LENGTH bytes).
+    // Prices and amounts usually carry a few decimals, so the value is first tried as m / 10^k for the
+    // smallest k up to 9: when that division gives back the value exactly, the digits of m with a point
+    // are printed, which parseDouble turns into the same division. Other values go through to_chars.
+    // Returns the length written.
+    inline size_t formatDouble(double value, char* out)
+    {
+      static constexpr double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+      constexpr int MAX_DECIMALS = 9;
+
+      const double magnitude = std::fabs(value);
+      if (magnitude < 1e9) {
+        for (int k = 0; k <= MAX_DECIMALS; ++k)
+        {
+          const double scaled = magnitude * powersOf10[k];
+          if (scaled >= 9007199254740992.0)
+            break;
+          const uint64_t mantissa = static_cast<uint64_t>(scaled + 0.5);
+          if (static_cast<double>(mantissa) / powersOf10[k] != magnitude)
+            continue;
+
+          char digits[24];
+          const size_t count = std::to_chars(digits, digits + sizeof(digits), mantissa).ptr - digits;
+          char* p = out;
+          if (std::signbit(value))
+            *p++ = '-';
+          if (count <= static_cast<size_t>(k)) {
+            *p++ = '0';
+            *p++ = '.';
+            for (size_t z = count; z < static_cast<size_t>(k); ++z)
+              *p++ = '0';
+            std::memcpy(p, digits, count);
+            p += count;
+          } else {
+            const size_t integral = count - k;
+            std::memcpy(p, digits, integral);
+            p += integral;
+            if (k > 0) {
+              *p++ = '.';
+              std::memcpy(p, digits + integral, k);
+              p += k;
+            }
+          }
+          return static_cast<size_t>(p - out);
+        }
+      }
+
+#if defined(__cpp_lib_to_chars)
+      return std::to_chars(out, out + MAX_DOUBLE_LENGTH, value).ptr - out;
+#else
+      return static_cast<size_t>(std::snprintf(out, MAX_DOUBLE_LENGTH, "%.17g", value));
+#endif
+    }
+
+    // Throws CsvUsageException when the cell does not hold a T
+    template <typename T>
+    inline T convert(std::string_view text)
+    {
+      T value{};
+      if (!parse(text, value))
+        throw CsvUsageException("Failed to convert CSV cell '" + std::string(text) + "'");
+      return value;
+    }
+  }
+}
+
+#endif //MGUTILS_CSVCONVERT_H
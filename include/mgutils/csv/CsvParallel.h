@@ -0,0 +1,115 @@
+#ifndef MGUTILS_CSVPARALLEL_H
+#define MGUTILS_CSVPARALLEL_H
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "JobPool.h"
+#include "MappedFile.h"
+#include "CsvRow.h"
+#include "CsvScanner.h"
+#include "CsvSource.h"
+
+namespace mgutils
+{
+  namespace csv
+  {
+    // Byte range holding whole records
+    struct CsvChunk
+    {
+      size_t begin;
+      size_t end;
+    };
+
+    // Splits [begin, end) of data, which must start at a record boundary, into at most count chunks
+    // that each start at a record boundary. A newline only ends a record outside quotes, and whether a
+    // byte is inside quotes depends on everything before it, so boundaries are found in two passes:
+    // each range is scanned in parallel once, speculating on both possible quote states at its start,
+    // and the true states then follow from the quote parity of the ranges before it.
+    // Assumes quotes only appear in quoted fields, as RFC 4180 requires.
+    std::vector<CsvChunk> splitRecords(const char* data, size_t begin, size_t end, size_t count, char quote,
+                                       JobPool& pool);
+
+    // Maps every record of a CSV file through handler on parallel chunks and returns the results in
+    // file order. Records are tokenized in place in a private mapping of the file, or for a compressed
+    // file in its decompressed text: a compressed stream cannot be split, so it is decoded up front.
+    template <typename Handler>
+    auto parallelMap(const std::string& filename, Handler& handler, size_t threads, const CsvOptions& options)
+        -> std::vector<std::invoke_result_t<Handler&, const CsvRow&>>
+    {
+      using Result = std::invoke_result_t<Handler&, const CsvRow&>;
+      static_assert(!std::is_void_v<Result>, "parallelLoad handlers return the value kept for each row");
+
+      // Chunks below this size are not worth a task
+      constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+      std::unique_ptr<MappedFile> file;
+      std::vector<char> text;
+      char* data;
+      size_t size;
+      if (detectCompression(filename) == CsvCompression::None) {
+        file = std::make_unique<MappedFile>(filename, MappedFile::Mode::CopyOnWrite);
+        data = file->data();
+        size = file->size();
+      } else {
+        text = readAll(filename);
+        data = text.data();
+        size = text.size();
+      }
+
+      CsvTokenizer tokenizer(options);
+      std::vector<CsvField> fields;
+
+      // The header, and any blank lines before it, stay with the caller's thread
+      size_t begin = 0;
+      if (options.hasHeader) {
+        while (begin < size)
+        {
+          begin += tokenizer.next(data + begin, size - begin, true, fields);
+          if (!fields.empty())
+            break;
+        }
+      }
+
+      if (threads == 0)
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+      const size_t count = std::max<size_t>(1, std::min(threads, (size - begin) / MIN_CHUNK_SIZE));
+
+      JobPool pool;
+      const std::vector<CsvChunk> chunks = splitRecords(data, begin, size, count, options.quote, pool);
+      std::vector<std::vector<Result>> results(chunks.size());
+      const CsvScanner scanner(options);
+
+      for (size_t i = 0; i < chunks.size(); ++i)
+      {
+        pool.addJob([&, i]() {
+          std::vector<Result>& out = results[i];
+          scanner.forEachRecord(data, chunks[i].begin, chunks[i].end,
+                                [&](size_t start, const CsvField* record, size_t count) {
+                                  out.push_back(handler(CsvRow(data + start, record, count)));
+                                });
+        });
+      }
+      pool.wait();
+
+      size_t total = 0;
+      for (const auto& chunk : results)
+        total += chunk.size();
+
+      std::vector<Result> merged;
+      merged.reserve(total);
+      for (auto& chunk : results)
+      {
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(merged));
+        std::vector<Result>().swap(chunk);
+      }
+      return merged;
+    }
+  }
+}
+
+#endif //MGUTILS_CSVPARALLEL_H
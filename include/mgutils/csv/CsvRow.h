@@ -0,0 +1,67 @@
+#ifndef MGUTILS_CSVROW_H
+#define MGUTILS_CSVROW_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include "CsvConvert.h"
+#include "CsvTokenizer.h"
+#include "Exceptions.h"
+
+namespace mgutils
+{
+  // Non-owning view of one CSV record. Cells are string_views into the reader's buffer: they stay
+  // valid as long as the MappedCsvReader that produced them, or until a streaming reader moves on.
+  class CsvRow
+  {
+  public:
+    CsvRow() = default;
+    CsvRow(const char* data, const csv::CsvField* fields, size_t count):
+        _data(data),
+        _fields(fields),
+        _count(count)
+    {}
+
+    size_t size() const { return _count; }
+    bool empty() const { return _count == 0; }
+
+    // Unchecked
+    std::string_view operator[](size_t column) const
+    {
+      const csv::CsvField& field = _fields[column];
+      return std::string_view(_data + field.begin, field.end - field.begin);
+    }
+
+    // Throws CsvUsageException when the record has no such column
+    std::string_view at(size_t column) const
+    {
+      if (column >= _count)
+        throw CsvUsageException("CSV column " + std::to_string(column) + " out of range (" +
+                                std::to_string(_count) + " columns)");
+      return (*this)[column];
+    }
+
+    // Throws CsvUsageException when the column is missing or does not hold a T
+    template <typename T>
+    T get(size_t column) const
+    {
+      return csv::convert<T>(at(column));
+    }
+
+    template <typename T>
+    std::optional<T> tryGet(size_t column) const
+    {
+      T value;
+      if (column >= _count || !csv::parse((*this)[column], value))
+        return std::nullopt;
+      return value;
+    }
+
+  private:
+    const char* _data = nullptr;
+    const csv::CsvField* _fields = nullptr;
+    size_t _count = 0;
+  };
+}
+
+#endif //MGUTILS_CSVROW_H
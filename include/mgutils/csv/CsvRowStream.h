@@ -0,0 +1,107 @@
+#ifndef MGUTILS_CSVROWSTREAM_H
+#define MGUTILS_CSVROWSTREAM_H
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CsvRow.h"
+#include "CsvSource.h"
+#include "CsvTokenizer.h"
+
+namespace mgutils
+{
+  // Reads a CSV file front to back in fixed-size blocks, one record at a time.
+  // Memory stays at one block, or the longest record when that is larger, whatever the file size.
+  // gzip and zstd files are recognized by their magic bytes and decompressed on a pipeline thread
+  // while the records are parsed (see csv::CsvByteSource).
+  // The current row is a view into the block: it is invalidated by the next call to next(), so copy
+  // out whatever has to outlive the iteration.
+  //
+  //   for (const CsvRow& row : CsvLoader::rows("trades.csv"))
+  //     volume += row.get<double>(2);
+  class CsvRowStream
+  {
+  public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    class iterator
+    {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = CsvRow;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const CsvRow*;
+      using reference = const CsvRow&;
+
+      iterator() = default;
+
+      reference operator*() const { return _stream->row(); }
+      pointer operator->() const { return &_stream->row(); }
+
+      iterator& operator++()
+      {
+        if (!_stream->next())
+          _stream = nullptr;
+        return *this;
+      }
+
+      bool operator==(const iterator& other) const { return _stream == other._stream; }
+      bool operator!=(const iterator& other) const { return _stream != other._stream; }
+
+    private:
+      friend class CsvRowStream;
+      explicit iterator(CsvRowStream* stream): _stream(stream) {}
+
+      CsvRowStream* _stream = nullptr;
+    };
+
+    // Throws FilesException when the file cannot be opened and CsvReadException for malformed CSV or
+    // corrupt compressed input.
+    // With a header the first record is read right away.
+    explicit CsvRowStream(const std::string& filename, const CsvOptions& options = {},
+                          size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~CsvRowStream();
+
+    CsvRowStream(CsvRowStream&& other) noexcept;
+    CsvRowStream& operator=(CsvRowStream&& other) noexcept;
+    CsvRowStream(const CsvRowStream&) = delete;
+    CsvRowStream& operator=(const CsvRowStream&) = delete;
+
+    // Empty without a header row
+    const std::vector<std::string>& columnNames() const { return _columnNames; }
+    // Throws CsvUsageException for an unknown column
+    size_t columnIndex(std::string_view columnName) const;
+
+    // Moves to the next record; false at the end of the file
+    bool next();
+    const CsvRow& row() const { return _row; }
+    // Records read so far, header excluded
+    size_t rowCount() const { return _rowCount; }
+
+    // Single pass: begin() reads the first record
+    iterator begin() { return next() ? iterator(this) : iterator(); }
+    iterator end() { return iterator(); }
+
+  private:
+    bool nextRecord();
+    // Keeps the unread bytes and reads more after them; false when nothing could be added
+    bool refill();
+    void close();
+
+    std::unique_ptr<csv::CsvByteSource> _source;
+    bool _eof = false;
+    std::vector<char> _buffer;
+    size_t _begin = 0;
+    size_t _end = 0;
+
+    csv::CsvTokenizer _tokenizer;
+    std::vector<csv::CsvField> _fields;
+    std::vector<std::string> _columnNames;
+    CsvRow _row;
+    size_t _rowCount = 0;
+  };
+}
+
+#endif //MGUTILS_CSVROWSTREAM_H
@@ -0,0 +1,307 @@
+#ifndef MGUTILS_CSVSCANNER_H
+#define MGUTILS_CSVSCANNER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "CsvTokenizer.h"
+
+namespace mgutils
+{
+  namespace csv
+  {
+    // Structural characters of one 64 byte block: bit i is set when byte i is that character
+    struct CsvBlockMasks
+    {
+      uint64_t delimiter;
+      uint64_t quote;
+      uint64_t newline;
+    };
+
+    enum class CsvScanKernel
+    {
+      Scalar,
+      Sse42,
+      Avx2
+    };
+
+    // Fastest kernel the CPU supports, detected once. Scalar on anything but x86.
+    CsvScanKernel bestScanKernel();
+    bool scanKernelSupported(CsvScanKernel kernel);
+    const char* scanKernelName(CsvScanKernel kernel);
+
+    // Bit i of the result is the XOR of bits 0..i. Applied to a quote mask it marks the bytes inside
+    // quotes, the opening quote included and the closing one excluded.
+    inline uint64_t prefixXor(uint64_t bits)
+    {
+      bits ^= bits << 1;
+      bits ^= bits << 2;
+      bits ^= bits << 4;
+      bits ^= bits << 8;
+      bits ^= bits << 16;
+      bits ^= bits << 32;
+      return bits;
+    }
+
+    inline unsigned lowestBit(uint64_t bits)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+      unsigned index = 0;
+      while (!(bits & 1)) {
+        bits >>= 1;
+        ++index;
+      }
+      return index;
+#endif
+    }
+
+    // Records in [begin, end) from the average line length of a few windows spread over the range, so
+    // a long header or lines that grow along the file do not skew it. Used to size indexes and columns
+    // before parsing.
+    inline size_t estimateRecords(const char* data, size_t begin, size_t end)
+    {
+      constexpr size_t WINDOWS = 4;
+      constexpr size_t WINDOW_LINES = 16;
+      size_t lines = 0;
+      size_t bytes = 0;
+      for (size_t window = 0; window < WINDOWS && begin < end; ++window)
+      {
+        size_t pos = begin + (end - begin) / WINDOWS * window;
+        if (window > 0) {
+          // Start the window on a line boundary
+          const void* newline = std::memchr(data + pos, '\n', end - pos);
+          if (!newline)
+            break;
+          pos = static_cast<const char*>(newline) - data + 1;
+        }
+
+        const size_t from = pos;
+        for (size_t line = 0; line < WINDOW_LINES && pos < end; ++line, ++lines)
+        {
+          const void* newline = std::memchr(data + pos, '\n', end - pos);
+          pos = newline ? static_cast<const char*>(newline) - data + 1 : end;
+        }
+        bytes += pos - from;
+      }
+      return lines == 0 ? 0 : (end - begin) / std::max<size_t>(1, bytes / lines) + 1;
+    }
+
+    // Vectorized record splitter for whole buffers (mapped files). Each 64 byte block is classified
+    // into delimiter, quote and newline bitmasks by an SSE4.2 or AVX2 kernel picked at runtime, or a
+    // scalar one. The prefix XOR of the quote mask, carried from block to block, gives the quoted
+    // bytes, so delimiters and newlines inside quotes drop out with one AND and the remaining
+    // structural bits are visited with count-trailing-zeros instead of a test per byte.
+    //
+    // Records come out exactly as CsvTokenizer splits them. A record the fast path does not handle
+    // (a quote inside an unquoted field, a bare CR, a malformed quoted field) is handed to the
+    // tokenizer, which also reports the errors, and the block scan resumes after it.
+    class CsvScanner
+    {
+    public:
+      static constexpr size_t BLOCK_SIZE = 64;
+
+      // Throws CsvUsageException for a kernel the CPU does not support
+      explicit CsvScanner(const CsvOptions& options = {}, CsvScanKernel kernel = bestScanKernel());
+
+      CsvScanKernel kernel() const { return _kernel; }
+
+      // Classifies up to maxBlocks blocks of data into out and returns how many it did. A last block
+      // shorter than 64 bytes is classified as if padded with zeros.
+      size_t classify(const char* data, size_t size, CsvBlockMasks* out, size_t maxBlocks) const;
+
+      // Splits the records of data[begin, end), which must start at a record boundary, and calls
+      // onRecord(recordStart, fields, count) for each, with fields relative to recordStart. Blank lines
+      // are skipped and doubled quotes are collapsed in place. Throws CsvReadException like CsvTokenizer.
+      template <typename OnRecord>
+      void forEachRecord(char* data, size_t begin, size_t end, OnRecord&& onRecord) const
+      {
+        while (begin < end)
+          begin = tokenize(data, scan(data, begin, end, onRecord), end, onRecord);
+      }
+
+    private:
+      // Block scan of data[begin, end). Returns end once every record is out, or the start of the first
+      // record it cannot take.
+      template <typename OnRecord>
+      size_t scan(char* data, size_t begin, size_t end, OnRecord& onRecord) const
+      {
+        constexpr size_t BATCH = 64;
+        CsvBlockMasks masks[BATCH];
+
+        // Fields go through a plain pointer: a vector push_back per field costs more than finding it
+        std::vector<CsvField> storage(16);
+        CsvField* fields = storage.data();
+        size_t capacity = storage.size();
+        size_t count = 0;
+        std::vector<uint32_t> escaped;
+
+        size_t recordStart = begin;
+        size_t fieldStart = begin;
+        uint32_t quotes = 0; // quotes seen in the current field; 0 for an unquoted field
+        uint64_t carry = 0;  // all ones when the previous block ended inside quotes
+
+        size_t base = begin;
+        while (base < end)
+        {
+          const size_t blocks = classify(data + base, end - base, masks, BATCH);
+          for (size_t b = 0; b < blocks; ++b, base += BLOCK_SIZE)
+          {
+            const uint64_t quoteBits = masks[b].quote;
+            const uint64_t newlineBits = masks[b].newline;
+            const uint64_t quoted = prefixXor(quoteBits) ^ carry;
+            carry = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+
+            uint64_t events = ((masks[b].delimiter | newlineBits) & ~quoted) | quoteBits;
+            if ((quoteBits | carry | quotes) == 0) {
+              // The common block: no quotes in it or open before it, so every event is a field end
+              while (events)
+              {
+                const unsigned bit = lowestBit(events);
+                const size_t pos = base + bit;
+                events &= events - 1;
+
+                if (count == capacity) {
+                  fields = grow(storage);
+                  capacity = storage.size();
+                }
+                if (!(newlineBits >> bit & 1)) {
+                  fields[count++] = makeField(recordStart, fieldStart, pos, 0);
+                  fieldStart = pos + 1;
+                  continue;
+                }
+
+                const size_t fieldEnd = pos > fieldStart && data[pos - 1] == '\r' ? pos - 1 : pos;
+                fields[count++] = makeField(recordStart, fieldStart, fieldEnd, 0);
+                if (data[recordStart] == '\r' && fieldEnd != recordStart)
+                  return recordStart;
+                emit(data, recordStart, fields, count, escaped, onRecord);
+                count = 0;
+                recordStart = fieldStart = pos + 1;
+              }
+              continue;
+            }
+
+            while (events)
+            {
+              const unsigned bit = lowestBit(events);
+              const size_t pos = base + bit;
+              events &= events - 1;
+
+              if (quoteBits >> bit & 1) {
+                if (pos == fieldStart) {
+                  quotes = 1;
+                } else if (quotes == 0) {
+                  return recordStart;
+                } else if (++quotes % 2 == 0) {
+                  // Either the closing quote or the first of a doubled one
+                  const char next = pos + 1 < end ? data[pos + 1] : '\n';
+                  if (next == '\r' ? pos + 2 < end && data[pos + 2] != '\n'
+                                   : next != _quote && next != _delimiter && next != '\n')
+                    return recordStart;
+                }
+                continue;
+              }
+
+              const bool newline = newlineBits >> bit & 1;
+              const size_t fieldEnd = newline && pos > fieldStart && data[pos - 1] == '\r' ? pos - 1 : pos;
+              if (count == capacity) {
+                fields = grow(storage);
+                capacity = storage.size();
+              }
+              if (quotes > 2)
+                escaped.push_back(static_cast<uint32_t>(count));
+              fields[count++] = makeField(recordStart, fieldStart, fieldEnd, quotes);
+              fieldStart = pos + 1;
+              quotes = 0;
+              if (!newline)
+                continue;
+
+              if (data[recordStart] == '\r' && fieldEnd != recordStart)
+                return recordStart;
+              emit(data, recordStart, fields, count, escaped, onRecord);
+              count = 0;
+              recordStart = fieldStart;
+            }
+          }
+        }
+
+        if (carry)
+          return recordStart;
+        if (recordStart < end) {
+          const size_t fieldEnd = end > fieldStart && data[end - 1] == '\r' ? end - 1 : end;
+          if (data[recordStart] == '\r' && fieldEnd != recordStart)
+            return recordStart;
+          if (count == capacity)
+            fields = grow(storage);
+          if (quotes > 2)
+            escaped.push_back(static_cast<uint32_t>(count));
+          fields[count++] = makeField(recordStart, fieldStart, fieldEnd, quotes);
+          emit(data, recordStart, fields, count, escaped, onRecord);
+        }
+        return end;
+      }
+
+      // A quoted field is known to start and end with its quotes
+      static CsvField makeField(size_t recordStart, size_t fieldStart, size_t fieldEnd, uint32_t quotes)
+      {
+        const size_t trim = quotes > 0 ? 1 : 0;
+        return {static_cast<uint32_t>(fieldStart + trim - recordStart),
+                static_cast<uint32_t>(fieldEnd - trim - recordStart)};
+      }
+
+      static CsvField* grow(std::vector<CsvField>& storage)
+      {
+        storage.resize(storage.size() * 2);
+        return storage.data();
+      }
+
+      template <typename OnRecord>
+      void emit(char* data, size_t recordStart, CsvField* fields, size_t count,
+                std::vector<uint32_t>& escaped, OnRecord& onRecord) const
+      {
+        // A blank line is a single empty unquoted field; a quoted empty one starts at 1
+        if (count == 1 && fields[0].begin == 0 && fields[0].end == 0)
+          return;
+        if (!escaped.empty()) {
+          for (uint32_t index : escaped)
+            collapseQuotes(data + recordStart, fields[index], _quote);
+          escaped.clear();
+        }
+        onRecord(recordStart, static_cast<const CsvField*>(fields), count);
+      }
+
+      // Byte at a time from the record at pos to the first one starting after a newline, where the block
+      // scan can pick up again; returns that record's start
+      template <typename OnRecord>
+      size_t tokenize(char* data, size_t pos, size_t end, OnRecord& onRecord) const
+      {
+        CsvTokenizer tokenizer(_options);
+        std::vector<CsvField> fields;
+        while (pos < end)
+        {
+          const size_t start = pos;
+          pos += tokenizer.next(data + pos, end - pos, true, fields);
+          if (!fields.empty())
+            onRecord(start, static_cast<const CsvField*>(fields.data()), fields.size());
+          if (data[pos - 1] == '\n')
+            break;
+        }
+        return pos;
+      }
+
+      using ClassifyBlocks = void (*)(const char* data, size_t blocks, char delimiter, char quote,
+                                      CsvBlockMasks* out);
+
+      CsvOptions _options;
+      char _delimiter;
+      char _quote;
+      CsvScanKernel _kernel;
+      ClassifyBlocks _classify;
+    };
+  }
+}
+
+#endif //MGUTILS_CSVSCANNER_H
@@ -0,0 +1,86 @@
+#ifndef MGUTILS_CSVSOURCE_H
+#define MGUTILS_CSVSOURCE_H
+
+#include <ios>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mgutils
+{
+  namespace csv
+  {
+    enum class CsvCompression
+    {
+      None,
+      Gzip,
+      Zstd
+    };
+
+    // Compression of a file from its magic bytes, whatever its extension.
+    // Throws FilesException when the file cannot be opened.
+    CsvCompression detectCompression(const std::string& path);
+
+    // Sequential bytes of a CSV file. Compressed files are decompressed on a pipeline thread that
+    // stays a few chunks ahead of the reader through a bounded queue, so decompression and parsing
+    // overlap and nothing is written to disk. gzip (multi-member too) needs mgutils built with
+    // MGUTILS_WITH_ZLIB, zstd with MGUTILS_WITH_ZSTD.
+    class CsvByteSource
+    {
+    public:
+      static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+      // Throws FilesException when the file cannot be opened and CsvReadException for a compression
+      // this build cannot read
+      static std::unique_ptr<CsvByteSource> open(const std::string& path, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+      virtual ~CsvByteSource() = default;
+
+      // Copies up to size bytes into out and returns how many; 0 only at the end of the input.
+      // Throws FilesException for read errors and CsvReadException for corrupt compressed data.
+      virtual size_t read(char* out, size_t size) = 0;
+    };
+
+    // Whole decompressed content of path, for the readers that need it in memory at once
+    std::vector<char> readAll(const std::string& path);
+
+    // Read-only, seekable stream buffer over text in memory, for readers that take a std::istream and
+    // seek in it (rapidcsv measures the stream before parsing it)
+    class CsvTextBuffer : public std::streambuf
+    {
+    public:
+      explicit CsvTextBuffer(std::vector<char> text):
+          _text(std::move(text))
+      {
+        setg(_text.data(), _text.data(), _text.data() + _text.size());
+      }
+
+    protected:
+      pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override
+      {
+        const off_type size = egptr() - eback();
+        off_type target = offset;
+        if (direction == std::ios_base::cur)
+          target += gptr() - eback();
+        else if (direction == std::ios_base::end)
+          target += size;
+        if (target < 0 || target > size)
+          return pos_type(off_type(-1));
+        setg(eback(), eback() + target, egptr());
+        return pos_type(target);
+      }
+
+      pos_type seekpos(pos_type position, std::ios_base::openmode which) override
+      {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+      }
+
+    private:
+      std::vector<char> _text;
+    };
+  }
+}
+
+#endif //MGUTILS_CSVSOURCE_H
@@ -0,0 +1,147 @@
+#ifndef MGUTILS_CSVSTRUCT_H
+#define MGUTILS_CSVSTRUCT_H
+
+#include <array>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "StructFields.h"
+#include "CsvConvert.h"
+#include "CsvRow.h"
+#include "CsvRowStream.h"
+#include "Exceptions.h"
+
+// Binds the listed members of Type to CSV columns of the same name.
+// Must be used in the namespace of Type so CsvStruct can find the binding through ADL.
+// Supported member types: std::string, bool, char (a one character cell), integers, floating point and enums.
+#define MG_CSV_STRUCT(Type, ...)                                        \
+  inline constexpr auto mgCsvFields(const Type*)                        \
+  {                                                                     \
+    return MGUTILS_STRUCT_FIELDS(Type, __VA_ARGS__);                    \
+  }
+
+namespace mgutils
+{
+  template <typename T>
+  struct CsvStructTraits
+  {
+    static constexpr auto fields = mgCsvFields(static_cast<const T*>(nullptr));
+    static constexpr size_t size = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+    static constexpr std::array<std::string_view, size> names = structFieldNames(fields);
+  };
+
+  // Column of every bound field of T within one header, resolved once per file so that decoding a
+  // row is a fixed sequence of indexed conversions.
+  // Empty cells leave their member untouched, keeping its default (e.g. NaN prices).
+  template <typename T>
+  class CsvStructMapping
+  {
+  public:
+    static constexpr size_t FIELD_COUNT = CsvStructTraits<T>::size;
+
+    // Fields in declaration order, for files without a header
+    CsvStructMapping()
+    {
+      for (size_t i = 0; i < FIELD_COUNT; ++i)
+        _columns[i] = i;
+    }
+
+    // Throws CsvUsageException when a field has no column in the header
+    explicit CsvStructMapping(const std::vector<std::string>& header)
+    {
+      for (size_t i = 0; i < FIELD_COUNT; ++i)
+      {
+        const std::string_view name = CsvStructTraits<T>::names[i];
+        size_t column = 0;
+        while (column < header.size() && header[column] != name)
+          ++column;
+        if (column == header.size())
+          throw CsvUsageException("CSV header has no column for field " + std::string(name));
+        _columns[i] = column;
+      }
+    }
+
+    size_t column(size_t field) const { return _columns[field]; }
+
+    // Throws CsvUsageException when the row is too short or a cell does not convert
+    void decode(const CsvRow& row, T& object) const
+    {
+      decode(row, object, std::make_index_sequence<FIELD_COUNT>{});
+    }
+
+  private:
+    template <size_t... Is>
+    void decode(const CsvRow& row, T& object, std::index_sequence<Is...>) const
+    {
+      (decodeField(row, object, std::get<Is>(CsvStructTraits<T>::fields), _columns[Is]), ...);
+    }
+
+    template <typename Field>
+    static void decodeField(const CsvRow& row, T& object, const Field& field, size_t column)
+    {
+      const std::string_view text = row.at(column);
+      if (text.empty())
+        return;
+      if (!csv::parse(text, object.*(field.member)))
+        throw CsvUsageException("Failed to convert CSV cell '" + std::string(text) + "' for field " +
+                                std::string(field.name));
+    }
+
+    std::array<size_t, FIELD_COUNT> _columns{};
+  };
+
+  class CsvStruct
+  {
+  public:
+    // Decodes every record of the file into a T bound with MG_CSV_STRUCT
+    template <typename T>
+    static std::vector<T> load(const std::string& filename, const CsvOptions& options = {})
+    {
+      std::vector<T> out;
+      CsvRowStream rows(filename, options);
+      const CsvStructMapping<T> mapping = mappingFor<T>(rows, options);
+      for (const CsvRow& row : rows)
+        mapping.decode(row, out.emplace_back());
+      return out;
+    }
+
+    // Streams the file and hands out batches of up to batchSize decoded objects. The batch vector is
+    // reused between calls, so memory stays at one batch whatever the file size.
+    template <typename T>
+    static void forEachBatch(const std::string& filename, size_t batchSize,
+                             const std::function<void(std::vector<T>& batch)>& callback,
+                             const CsvOptions& options = {})
+    {
+      if (batchSize == 0)
+        throw CsvUsageException("CSV batch size must be positive");
+
+      CsvRowStream rows(filename, options);
+      const CsvStructMapping<T> mapping = mappingFor<T>(rows, options);
+
+      std::vector<T> batch;
+      batch.reserve(batchSize);
+      for (const CsvRow& row : rows)
+      {
+        mapping.decode(row, batch.emplace_back());
+        if (batch.size() == batchSize) {
+          callback(batch);
+          batch.clear();
+        }
+      }
+      if (!batch.empty())
+        callback(batch);
+    }
+
+  private:
+    template <typename T>
+    static CsvStructMapping<T> mappingFor(const CsvRowStream& rows, const CsvOptions& options)
+    {
+      return options.hasHeader ? CsvStructMapping<T>(rows.columnNames()) : CsvStructMapping<T>();
+    }
+  };
+}
+
+#endif //MGUTILS_CSVSTRUCT_H
@@ -0,0 +1,222 @@
+#ifndef MGUTILS_CSVTABLE_H
+#define MGUTILS_CSVTABLE_H
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "MappedFile.h"
+#include "CsvColumnCache.h"
+#include "CsvConvert.h"
+#include "CsvRow.h"
+#include "CsvRowStream.h"
+#include "CsvScanner.h"
+#include "Exceptions.h"
+
+namespace mgutils
+{
+  // Struct of arrays: one contiguous vector per loaded column, all of the same length
+  template <typename... Ts>
+  class CsvTable
+  {
+  public:
+    static constexpr size_t COLUMN_COUNT = sizeof...(Ts);
+
+    template <size_t I>
+    using ColumnType = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    size_t size() const { return std::get<0>(_columns).size(); }
+    bool empty() const { return size() == 0; }
+
+    const std::array<std::string, COLUMN_COUNT>& names() const { return _names; }
+
+    template <size_t I>
+    const std::vector<ColumnType<I>>& column() const { return std::get<I>(_columns); }
+    template <size_t I>
+    std::vector<ColumnType<I>>& column() { return std::get<I>(_columns); }
+
+    std::tuple<std::vector<Ts>...>& columns() { return _columns; }
+    const std::tuple<std::vector<Ts>...>& columns() const { return _columns; }
+
+  private:
+    template <typename... Us>
+    friend CsvTable<Us...> loadCsvColumns(const std::string&, const std::array<std::string_view, sizeof...(Us)>&,
+                                          const CsvOptions&);
+
+    std::array<std::string, COLUMN_COUNT> _names;
+    std::tuple<std::vector<Ts>...> _columns;
+  };
+
+  namespace csv
+  {
+    template <typename T>
+    void parseColumnCell(std::string_view text, std::vector<T>& column, std::string_view name, size_t row)
+    {
+      T value;
+      if (!parse(text, value))
+        throw CsvUsageException("Failed to convert CSV cell '" + std::string(text) + "' in column " +
+                                std::string(name) + ", row " + std::to_string(row));
+      column.push_back(std::move(value));
+    }
+
+    // Converts the projected fields of one record into the back of each column
+    template <typename... Ts, size_t... I>
+    void parseProjection(const CsvRow& record, const std::array<size_t, sizeof...(Ts)>& indices,
+                         const std::array<std::string_view, sizeof...(Ts)>& names, size_t row,
+                         std::tuple<std::vector<Ts>...>& columns, std::index_sequence<I...>)
+    {
+      for (size_t index : indices)
+      {
+        if (index >= record.size())
+          throw CsvUsageException("CSV row " + std::to_string(row) + " has " + std::to_string(record.size()) +
+                                  " fields, column " + std::to_string(index) + " is missing");
+      }
+
+      (parseColumnCell(record[indices[I]], std::get<I>(columns), names[I], row), ...);
+    }
+
+    template <size_t N>
+    std::array<size_t, N> projectionIndices(const std::vector<std::string_view>& header,
+                                            const std::array<std::string_view, N>& names)
+    {
+      std::array<size_t, N> indices{};
+      for (size_t i = 0; i < N; ++i)
+      {
+        auto it = std::find(header.begin(), header.end(), names[i]);
+        if (it == header.end())
+          throw CsvUsageException("CSV column not found: " + std::string(names[i]));
+        indices[i] = static_cast<size_t>(it - header.begin());
+      }
+      return indices;
+    }
+  }
+
+  namespace csv
+  {
+    template <typename... Ts, size_t... I>
+    bool readCachedColumns(const CsvColumnCache& cache, const std::array<std::string_view, sizeof...(Ts)>& names,
+                           std::tuple<std::vector<Ts>...>& columns, std::index_sequence<I...>)
+    {
+      return (cache.read(names[I], std::get<I>(columns)) && ...);
+    }
+
+    // Writes the loaded columns to the sidecar, keeping the columns a still valid sidecar already had
+    template <typename... Ts, size_t... I>
+    void writeCachedColumns(const std::string& filename, const CsvSourceStamp& stamp, const CsvOptions& options,
+                            const CsvColumnCache* previous, const std::array<std::string_view, sizeof...(Ts)>& names,
+                            const std::tuple<std::vector<Ts>...>& columns, size_t rowCount, std::index_sequence<I...>)
+    {
+      std::vector<CsvColumnBlock> blocks;
+      (blocks.push_back(CsvColumnCache::encode(std::string(names[I]), std::get<I>(columns))), ...);
+
+      if (previous && previous->rowCount() == rowCount) {
+        for (auto& block : previous->blocks())
+        {
+          if (std::find(names.begin(), names.end(), block.name) == names.end())
+            blocks.push_back(std::move(block));
+        }
+      }
+
+      try {
+        CsvColumnCache::write(filename, stamp, options, rowCount, blocks);
+      } catch (const CsvWriteException&) {
+        // The columns are loaded; a cache that cannot be written only costs the next load a parse
+      }
+    }
+
+    template <typename... Ts>
+    void parseCsvColumns(char* data, size_t size, const std::array<std::string_view, sizeof...(Ts)>& names,
+                         const CsvOptions& options, std::tuple<std::vector<Ts>...>& columns)
+    {
+      CsvTokenizer tokenizer(options);
+      std::vector<CsvField> fields;
+
+      std::vector<std::string_view> header;
+      size_t pos = 0;
+      while (pos < size && header.empty())
+      {
+        const size_t start = pos;
+        pos += tokenizer.next(data + pos, size - pos, true, fields);
+        for (const auto& field : fields)
+          header.emplace_back(data + start + field.begin, field.end - field.begin);
+      }
+
+      const auto indices = projectionIndices(header, names);
+      const size_t estimate = estimateRecords(data, pos, size);
+      std::apply([estimate](auto&... column) { (column.reserve(estimate + estimate / 32), ...); }, columns);
+
+      size_t row = 0;
+      CsvScanner(options).forEachRecord(data, pos, size, [&](size_t start, const CsvField* record, size_t count) {
+        parseProjection<Ts...>(CsvRow(data + start, record, count), indices, names, row++, columns,
+                               std::index_sequence_for<Ts...>{});
+      });
+    }
+
+    // Compressed input: records come from the decompression pipeline as they are decoded
+    template <typename... Ts>
+    void streamCsvColumns(const std::string& filename, const std::array<std::string_view, sizeof...(Ts)>& names,
+                          const CsvOptions& options, std::tuple<std::vector<Ts>...>& columns)
+    {
+      CsvRowStream stream(filename, options);
+      const std::vector<std::string_view> header(stream.columnNames().begin(), stream.columnNames().end());
+      const auto indices = projectionIndices(header, names);
+
+      size_t row = 0;
+      while (stream.next())
+        parseProjection<Ts...>(stream.row(), indices, names, row++, columns, std::index_sequence_for<Ts...>{});
+    }
+  }
+
+  // Loads the named columns of a CSV file with a header into a CsvTable, in one pass over a private
+  // mapping of the file. Fields outside the projection are only delimited, never converted, and the
+  // vectors are sized up front from the length of the first lines.
+  // With options.columnCache the columns come from the file's sidecar when it is current, and are
+  // written to it otherwise.
+  // Throws CsvUsageException for an unknown column or a cell that does not convert.
+  template <typename... Ts>
+  CsvTable<Ts...> loadCsvColumns(const std::string& filename, const std::array<std::string_view, sizeof...(Ts)>& names,
+                                 const CsvOptions& options)
+  {
+    static_assert(sizeof...(Ts) > 0, "loadColumns needs at least one column");
+    static_assert(!(std::is_same_v<Ts, std::string_view> || ...),
+                  "loadColumns owns its data; use std::string, or MappedCsvReader for views");
+
+    if (!options.hasHeader)
+      throw CsvUsageException("Loading CSV columns by name needs a header row");
+
+    CsvTable<Ts...> table;
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+      table._names[i] = std::string(names[i]);
+
+    csv::CsvSourceStamp stamp;
+    std::unique_ptr<csv::CsvColumnCache> cache;
+    if (options.columnCache) {
+      // Taken before parsing, so a file that changes meanwhile leaves a sidecar that no longer matches
+      stamp = csv::CsvSourceStamp::of(filename);
+      cache = csv::CsvColumnCache::open(filename, stamp, options);
+      if (cache && csv::readCachedColumns<Ts...>(*cache, names, table._columns, std::index_sequence_for<Ts...>{}))
+        return table;
+    }
+
+    table._columns = {};
+    if (csv::detectCompression(filename) == csv::CsvCompression::None) {
+      MappedFile file(filename, MappedFile::Mode::CopyOnWrite);
+      file.adviseSequential();
+      csv::parseCsvColumns<Ts...>(file.data(), file.size(), names, options, table._columns);
+    } else {
+      csv::streamCsvColumns<Ts...>(filename, names, options, table._columns);
+    }
+
+    if (options.columnCache)
+      csv::writeCachedColumns<Ts...>(filename, stamp, options, cache.get(), names, table._columns, table.size(),
+                                     std::index_sequence_for<Ts...>{});
+    return table;
+  }
+}
+
+#endif //MGUTILS_CSVTABLE_H
@@ -0,0 +1,87 @@
+#ifndef MGUTILS_CSVTIMEINDEX_H
+#define MGUTILS_CSVTIMEINDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CsvColumnCache.h"
+#include "CsvRow.h"
+#include "CsvTokenizer.h"
+
+namespace mgutils
+{
+  // Sparse index of a CSV file sorted by a time column: the time and byte offset of every
+  // everyNRows-th record. A range read looks up the last indexed record before its start, parses from
+  // there and stops at the first record past its end, so an hour of a day-long file costs an hour of
+  // parsing plus at most one stride.
+  //
+  // The index is kept in a "<file>.mgidx" sidecar stamped with the file's size and mtime, like the
+  // column cache. Times are integers as written (epoch milliseconds, usually), or dates read with
+  // parseDateTimeWithFormat when a format is given, which also gives milliseconds.
+  //
+  //   CsvTimeIndex::build("trades.csv", "time", 4096);
+  //   CsvLoader::readRange("trades.csv", hourStart, hourStart + 3600000, [&](const CsvRow& row) { ... });
+  class CsvTimeIndex
+  {
+  public:
+    struct Entry
+    {
+      int64_t time;
+      uint64_t offset;
+    };
+
+    static constexpr size_t DEFAULT_STRIDE = 4096;
+
+    static std::string sidecarPath(const std::string& source) { return source + ".mgidx"; }
+
+    // Scans the file once, indexes every everyNRows-th record and writes the sidecar (a sidecar that
+    // cannot be written only costs the next load a scan). Sorting is checked on the indexed records.
+    // Throws CsvUsageException for an unknown column, a time that does not parse, a file out of order
+    // or a compressed file, which cannot be read from an offset.
+    static CsvTimeIndex build(const std::string& path, const std::string& timeColumn,
+                              size_t everyNRows = DEFAULT_STRIDE, const std::string& timeFormat = {},
+                              const CsvOptions& options = {});
+
+    // Index from the sidecar of path. A sidecar the file has changed under since is rebuilt with the
+    // column, format and stride it records. Throws CsvUsageException when path was never indexed.
+    static CsvTimeIndex load(const std::string& path, const CsvOptions& options = {});
+
+    const std::string& path() const { return _path; }
+    const std::string& timeColumn() const { return _timeColumn; }
+    const std::string& timeFormat() const { return _timeFormat; }
+    size_t stride() const { return _stride; }
+    // Records after the header
+    size_t rowCount() const { return _rowCount; }
+    const std::vector<Entry>& entries() const { return _entries; }
+
+    // Position in entries() of the last indexed record before time; every record at or after time
+    // comes after it
+    size_t seek(int64_t time) const;
+
+    // Time of a cell of the indexed column. Throws CsvUsageException when it does not parse.
+    int64_t parseTime(std::string_view text) const;
+
+    // Calls onRow for every record with fromTime <= time < toTime, in file order, and returns how many
+    // there were. Throws CsvUsageException when the file changed since it was indexed.
+    size_t readRange(int64_t fromTime, int64_t toTime, const std::function<void(const CsvRow&)>& onRow) const;
+
+  private:
+    CsvTimeIndex() = default;
+
+    void write() const;
+
+    std::string _path;
+    std::string _timeColumn;
+    std::string _timeFormat;
+    CsvOptions _options;
+    csv::CsvSourceStamp _stamp;
+    size_t _stride = DEFAULT_STRIDE;
+    size_t _column = 0;
+    size_t _rowCount = 0;
+    std::vector<Entry> _entries;
+  };
+}
+
+#endif //MGUTILS_CSVTIMEINDEX_H
@@ -0,0 +1,166 @@
+#ifndef MGUTILS_CSVTOKENIZER_H
+#define MGUTILS_CSVTOKENIZER_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Exceptions.h"
+
+namespace mgutils
+{
+  // Dialect shared by the CSV readers
+  struct CsvOptions
+  {
+    char delimiter = ',';
+    char quote = '"';
+    // First record holds the column names
+    bool hasHeader = true;
+    // loadColumns keeps the parsed columns in a binary "<file>.mgcol" sidecar and, while the file keeps
+    // its size and mtime, reads them from there instead of parsing
+    bool columnCache = false;
+  };
+
+  namespace csv
+  {
+    // Field position relative to the start of its record
+    struct CsvField
+    {
+      uint32_t begin;
+      uint32_t end;
+    };
+
+    // Collapses the doubled quotes of a quoted field in place and shortens it to match
+    inline void collapseQuotes(char* record, CsvField& field, char quote)
+    {
+      uint32_t write = field.begin;
+      for (uint32_t read = field.begin; read < field.end; ++read, ++write)
+      {
+        record[write] = record[read];
+        if (record[read] == quote)
+          ++read;
+      }
+      field.end = write;
+    }
+
+    // Splits records in the RFC 4180 dialect: fields separated by the delimiter, optionally enclosed
+    // in quotes with doubled quotes as escapes, records ended by LF or CRLF. Blank lines are records
+    // without fields. Escaped quotes are collapsed in place once the whole record has been seen, so a
+    // record reported as incomplete is left untouched and can be tokenized again after a refill.
+    class CsvTokenizer
+    {
+    public:
+      explicit CsvTokenizer(const CsvOptions& options = {}):
+          _delimiter(options.delimiter),
+          _quote(options.quote)
+      {}
+
+      // Tokenizes the record at data into fields and returns the bytes it takes, terminator included.
+      // Returns 0 when the record runs past size and atEnd is false, meaning more input is needed.
+      // Throws CsvReadException for a quoted field that is never closed or is followed by text.
+      size_t next(char* data, size_t size, bool atEnd, std::vector<CsvField>& fields)
+      {
+        fields.clear();
+        _escaped.clear();
+
+        size_t pos = 0;
+        if (size == 0)
+          return 0;
+        if (data[0] == '\n')
+          return 1;
+        if (data[0] == '\r') {
+          if (size > 1)
+            return data[1] == '\n' ? 2 : 1;
+          return atEnd ? 1 : 0;
+        }
+
+        while (true)
+        {
+          const size_t begin = pos;
+
+          if (pos < size && data[pos] == _quote) {
+            size_t read = pos + 1;
+            bool escaped = false;
+            while (true)
+            {
+              const void* found = std::memchr(data + read, _quote, size - read);
+              if (!found) {
+                if (!atEnd)
+                  return 0;
+                throw CsvReadException("Unterminated quoted CSV field");
+              }
+              read = static_cast<const char*>(found) - data;
+              if (read + 1 == size && !atEnd)
+                return 0; // the next byte decides between an escape and the closing quote
+              if (read + 1 < size && data[read + 1] == _quote) {
+                escaped = true;
+                read += 2;
+                continue;
+              }
+              break;
+            }
+
+            if (escaped)
+              _escaped.push_back(static_cast<uint32_t>(fields.size()));
+            fields.push_back({static_cast<uint32_t>(begin + 1), static_cast<uint32_t>(read)});
+            pos = read + 1;
+
+            if (pos >= size) {
+              if (!atEnd)
+                return 0;
+              return finish(data, fields, pos);
+            }
+
+            const char c = data[pos];
+            if (c == _delimiter) {
+              ++pos;
+              continue;
+            }
+            if (c == '\n')
+              return finish(data, fields, pos + 1);
+            if (c == '\r') {
+              if (pos + 1 < size)
+                return finish(data, fields, data[pos + 1] == '\n' ? pos + 2 : pos + 1);
+              if (!atEnd)
+                return 0;
+              return finish(data, fields, pos + 1);
+            }
+            throw CsvReadException("Unexpected character after a quoted CSV field");
+          }
+
+          while (pos < size && data[pos] != _delimiter && data[pos] != '\n')
+            ++pos;
+
+          if (pos < size && data[pos] == _delimiter) {
+            fields.push_back({static_cast<uint32_t>(begin), static_cast<uint32_t>(pos)});
+            ++pos;
+            continue;
+          }
+
+          if (pos >= size && !atEnd)
+            return 0;
+
+          size_t end = pos;
+          if (end > begin && data[end - 1] == '\r')
+            --end;
+          fields.push_back({static_cast<uint32_t>(begin), static_cast<uint32_t>(end)});
+          return finish(data, fields, pos < size ? pos + 1 : pos);
+        }
+      }
+
+    private:
+      // Collapses doubled quotes of the fields that have them, now that the record is complete
+      size_t finish(char* data, std::vector<CsvField>& fields, size_t consumed) const
+      {
+        for (uint32_t index : _escaped)
+          collapseQuotes(data, fields[index], _quote);
+        return consumed;
+      }
+
+      char _delimiter;
+      char _quote;
+      std::vector<uint32_t> _escaped;
+    };
+  }
+}
+
+#endif //MGUTILS_CSVTOKENIZER_H
@@ -0,0 +1,180 @@
+#ifndef MGUTILS_CSVWRITER_H
+#define MGUTILS_CSVWRITER_H
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "CsvStruct.h"
+
+namespace mgutils
+{
+  struct CsvWriterOptions
+  {
+    enum class Quoting
+    {
+      Minimal, // only fields holding the delimiter, a quote or a line break
+      All,     // every text field; numbers are never quoted
+      None
+    };
+
+    char delimiter = ',';
+    char quote = '"';
+    Quoting quoting = Quoting::Minimal;
+    // Bytes collected before they are handed to the OS
+    size_t bufferSize = 1 << 20;
+    // Also flush when this much time passed since the last flush; checked as rows are written
+    std::chrono::milliseconds flushInterval{0};
+    // Write on a background thread: a full buffer is swapped with a second one and the producer goes on
+    bool background = false;
+    // Append to an existing file instead of truncating it
+    bool append = true;
+  };
+
+  // Buffered CSV writer for append-heavy persistence. Fields are formatted straight into a large
+  // buffer, numbers with std::to_chars or a short decimal path, and the buffer reaches the file with one write() when it is
+  // full, when the flush interval expires, on flush() and on destruction.
+  // In background mode the producer only formats into one buffer while the other is being written.
+  // A writer belongs to a single producer thread.
+  //
+  //   CsvWriter writer("trades.csv");
+  //   writer.writeHeader<models::Trade>();
+  //   writer.append(trade);
+  //   writer.writeRow("binance", "BTCUSDT", 61234.5, 0.01, 'B', 1718000000000);
+  class CsvWriter
+  {
+  public:
+    // Throws CsvWriteException when the file cannot be opened
+    explicit CsvWriter(const std::string& filename, const CsvWriterOptions& options = {});
+    // Flushes what is left; write errors at this point are only logged
+    ~CsvWriter();
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    CsvWriter& field(std::string_view text);
+    CsvWriter& field(const char* text) { return field(std::string_view(text)); }
+    CsvWriter& field(const std::string& text) { return field(std::string_view(text)); }
+    // '\0' is written as an empty field
+    CsvWriter& field(char value);
+    CsvWriter& field(bool value);
+
+    // Numbers are written with the shortest text that reads back to the same value; NaN as "nan", which
+    // the CSV readers parse back to NaN
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    CsvWriter& field(T value)
+    {
+      separate();
+      char* out = reserve(MAX_NUMBER_LENGTH);
+      if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(value)) {
+          std::memcpy(out, "nan", 3);
+          _size += 3;
+        } else {
+          _size += csv::formatDouble(static_cast<double>(value), out);
+        }
+      } else {
+        _size += std::to_chars(out, out + MAX_NUMBER_LENGTH, value).ptr - out;
+      }
+      return *this;
+    }
+
+    template <typename T, std::enable_if_t<std::is_enum_v<T>, int> = 0>
+    CsvWriter& field(T value)
+    {
+      return field(static_cast<std::underlying_type_t<T>>(value));
+    }
+
+    // Ends the current record
+    CsvWriter& endRow();
+
+    template <typename... Ts>
+    CsvWriter& writeRow(const Ts&... values)
+    {
+      (field(values), ...);
+      return endRow();
+    }
+
+    // Column names of a struct bound with MG_CSV_STRUCT
+    template <typename T>
+    CsvWriter& writeHeader()
+    {
+      for (std::string_view name : CsvStructTraits<T>::names)
+        field(name);
+      return endRow();
+    }
+
+    // One record with the bound fields of a MG_CSV_STRUCT type, e.g. models::Trade
+    template <typename T>
+    CsvWriter& append(const T& object)
+    {
+      forEachStructField(CsvStructTraits<T>::fields, [&](const auto& bound) { field(object.*(bound.member)); });
+      return endRow();
+    }
+
+    // Hands the buffered bytes to the OS, waiting for the background thread when there is one.
+    // Throws CsvWriteException, also for a failure of an earlier background write.
+    void flush();
+
+    size_t rowCount() const { return _rowCount; }
+
+  private:
+    static constexpr size_t MAX_NUMBER_LENGTH = csv::MAX_DOUBLE_LENGTH;
+
+    void separate()
+    {
+      if (_fieldCount++ > 0) {
+        *reserve(1) = _options.delimiter;
+        ++_size;
+      }
+    }
+
+    // Room for count more bytes at the end of the buffer, committing the buffer first when needed
+    char* reserve(size_t count)
+    {
+      if (_size + count > _buffer.size()) {
+        commit();
+        if (count > _buffer.size())
+          _buffer.resize(count);
+      }
+      return _buffer.data() + _size;
+    }
+
+    void put(const char* data, size_t count);
+    bool needsQuotes(std::string_view text) const;
+
+    // Moves the buffer towards the file: written directly, or swapped to the background thread
+    void commit();
+    void writeAll(const char* data, size_t count);
+    void backgroundLoop();
+
+    std::string _path;
+    CsvWriterOptions _options;
+    int _fd = -1;
+
+    std::vector<char> _buffer;
+    size_t _size = 0;
+    size_t _fieldCount = 0;
+    size_t _rowCount = 0;
+    std::chrono::steady_clock::time_point _lastFlush;
+
+    // Background mode: _pending is owned by the thread while _pendingSize > 0
+    std::vector<char> _pending;
+    size_t _pendingSize = 0;
+    bool _stopping = false;
+    std::exception_ptr _error;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::thread _thread;
+  };
+}
+
+#endif //MGUTILS_CSVWRITER_H
@@ -0,0 +1,98 @@
+#ifndef MGUTILS_MAPPEDCSVREADER_H
+#define MGUTILS_MAPPEDCSVREADER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+#include "CsvRow.h"
+#include "CsvScanner.h"
+
+namespace mgutils
+{
+  // Zero-copy CSV reader over a memory-mapped file.
+  // Construction makes one vectorized pass over the file (CsvScanner) recording where each record and
+  // field starts; nothing is converted or copied, so the reader costs 8 bytes per record plus 8 bytes
+  // per field on top of the page cache. Cells are string_views into the mapping, converted on demand
+  // with from_chars.
+  // The file is mapped copy-on-write: fields with escaped quotes are unescaped in place, which only
+  // copies the pages that hold them.
+  // Every record must have as many fields as the first one.
+  //
+  //   MappedCsvReader reader("trades.csv");
+  //   size_t price = reader.columnIndex("price");
+  //   for (size_t i = 0; i < reader.rowCount(); ++i)
+  //     total += reader.row(i).get<double>(price);
+  class MappedCsvReader
+  {
+  public:
+    // Throws FilesException when the file cannot be mapped, CsvReadException for malformed CSV and
+    // CsvUsageException for a compressed file, which has no records to point into
+    explicit MappedCsvReader(const std::string& filename, char delimiter = ',');
+    MappedCsvReader(const std::string& filename, const CsvOptions& options);
+
+    MappedCsvReader(const MappedCsvReader&) = delete;
+    MappedCsvReader& operator=(const MappedCsvReader&) = delete;
+
+    // Records after the header
+    size_t rowCount() const { return _rowOffsets.size(); }
+    size_t columnCount() const { return _columnCount; }
+    // Empty without a header row
+    const std::vector<std::string>& columnNames() const { return _columnNames; }
+
+    // Throws CsvUsageException for an unknown column
+    size_t columnIndex(std::string_view columnName) const;
+
+    // Throws CsvUsageException for an out of range row
+    CsvRow row(size_t rowIndex) const;
+
+    template <typename T>
+    T getCell(size_t columnIndex, size_t rowIndex) const
+    {
+      return row(rowIndex).get<T>(columnIndex);
+    }
+
+    template <typename T>
+    T getCell(const std::string& columnName, size_t rowIndex) const
+    {
+      return getCell<T>(columnIndex(columnName), rowIndex);
+    }
+
+    template <typename T>
+    std::vector<T> getColumn(size_t columnIndex) const
+    {
+      if (columnIndex >= _columnCount)
+        throw CsvUsageException("CSV column " + std::to_string(columnIndex) + " out of range");
+
+      std::vector<T> values;
+      values.reserve(rowCount());
+      for (size_t i = 0; i < rowCount(); ++i)
+        values.push_back(rowAt(i).get<T>(columnIndex));
+      return values;
+    }
+
+    template <typename T>
+    std::vector<T> getColumn(const std::string& columnName) const
+    {
+      return getColumn<T>(columnIndex(columnName));
+    }
+
+  private:
+    CsvRow rowAt(size_t rowIndex) const
+    {
+      return CsvRow(_file.data() + _rowOffsets[rowIndex], _fields.data() + rowIndex * _columnCount, _columnCount);
+    }
+
+    void index(const CsvOptions& options);
+
+    MappedFile _file;
+    size_t _columnCount = 0;
+    std::vector<std::string> _columnNames;
+    std::vector<uint64_t> _rowOffsets;
+    // _columnCount fields per record, relative to the record offset
+    std::vector<csv::CsvField> _fields;
+  };
+}
+
+#endif //MGUTILS_MAPPEDCSVREADER_H
@@ -0,0 +1,49 @@
+#ifndef MGUTILS_FROZENJSON_H
+#define MGUTILS_FROZENJSON_H
+
+#include "rapidjson/document.h"
+#include <memory>
+#include <string>
+#include "JsonView.h"
+
+namespace mgutils
+{
+  // Immutable snapshot of a JsonDocument, created with JsonDocument::freeze().
+  // Nothing can modify it after construction, so any number of threads may read it through views
+  // concurrently with no locking and no copies.
+  //
+  // A compact snapshot is deep-copied into one contiguous buffer sized up front, and the members of
+  // every object are sorted by key so lookups through its views are binary searches. Member order
+  // therefore differs from the source document; with duplicate keys, which one a lookup finds is unspecified.
+  class FrozenJson
+  {
+  public:
+    FrozenJson(const FrozenJson&) = delete;
+    FrozenJson& operator=(const FrozenJson&) = delete;
+
+    JsonView view() const { return JsonView(_root, _compact); }
+
+    bool isCompact() const { return _compact; }
+
+    // Bytes taken from the snapshot's allocator
+    size_t memoryUsage() const { return _allocator.Size(); }
+
+    std::string toString(bool pretty = false) const { return view().toString(pretty); }
+
+    friend class JsonDocument;
+
+  private:
+    FrozenJson(const rapidjson::Value& source, bool compact);
+
+    static size_t storageBound(const rapidjson::Value& value);
+    static void sortMembers(rapidjson::Value& value);
+
+    bool _compact;
+    size_t _capacity;
+    std::unique_ptr<char[]> _buffer;
+    rapidjson::MemoryPoolAllocator<> _allocator;
+    rapidjson::Value _root;
+  };
+}
+
+#endif //MGUTILS_FROZENJSON_H
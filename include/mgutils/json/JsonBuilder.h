@@ -0,0 +1,110 @@
+#ifndef MGUTILS_JSONBUILDER_H
+#define MGUTILS_JSONBUILDER_H
+
+#include "rapidjson/document.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "JsonValue.h"
+
+namespace mgutils
+{
+  class JsonDocument;
+
+  namespace json
+  {
+    // Scalar or string converted to a rapidjson value; strings are copied into allocator
+    template <typename T>
+    rapidjson::Value makeValue(const T& value, rapidjson::Document::AllocatorType& allocator)
+    {
+      if constexpr (std::is_same_v<T, bool>) {
+        return rapidjson::Value(value);
+      } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
+        return rapidjson::Value(rapidjson::kNullType);
+      } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        return rapidjson::Value(static_cast<int64_t>(value));
+      } else if constexpr (std::is_integral_v<T>) {
+        return rapidjson::Value(static_cast<uint64_t>(value));
+      } else if constexpr (std::is_floating_point_v<T>) {
+        return rapidjson::Value(static_cast<double>(value));
+      } else {
+        static_assert(std::is_convertible_v<const T&, std::string_view>, "Invalid type for JSON builder");
+        std::string_view str(value);
+        return rapidjson::Value(str.data(), static_cast<rapidjson::SizeType>(str.size()), allocator);
+      }
+    }
+  }
+
+  class ArrayBuilder;
+
+  // Builds an object directly in a document's allocator, with no intermediate copies.
+  // reserve pre-sizes the member table; with uniqueKeys the caller promises no key is added twice,
+  // so add() appends without looking the key up first.
+  //
+  //   auto level = ObjectBuilder(doc, 2, true).add("px", 100.5).add("qty", 3).build();
+  class ObjectBuilder
+  {
+  public:
+    explicit ObjectBuilder(const std::shared_ptr<JsonDocument>& doc, size_t reserve = 0, bool uniqueKeys = false);
+
+    template <typename T>
+    ObjectBuilder& add(std::string_view key, const T& value)
+    {
+      rapidjson::Value member = json::makeValue(value, _allocator);
+      return addMember(key, member);
+    }
+
+    ObjectBuilder& add(std::string_view key, const char* value) { return add(key, std::string_view(value)); }
+    ObjectBuilder& add(std::string_view key, JsonValue&& value);
+    ObjectBuilder& add(std::string_view key, ObjectBuilder&& nested);
+    ObjectBuilder& add(std::string_view key, ArrayBuilder&& nested);
+
+    size_t size() const { return _value.MemberCount(); }
+
+    // Hands the object over without copying; the builder is left empty
+    JsonValue build();
+
+    friend class ArrayBuilder;
+
+  private:
+    ObjectBuilder& addMember(std::string_view key, rapidjson::Value& value);
+
+    rapidjson::Value _value;
+    rapidjson::Document::AllocatorType& _allocator;
+    bool _uniqueKeys;
+  };
+
+  // Builds an array directly in a document's allocator; reserve pre-sizes the element storage
+  class ArrayBuilder
+  {
+  public:
+    explicit ArrayBuilder(const std::shared_ptr<JsonDocument>& doc, size_t reserve = 0);
+
+    template <typename T>
+    ArrayBuilder& push(const T& value)
+    {
+      rapidjson::Value element = json::makeValue(value, _allocator);
+      _value.PushBack(element, _allocator);
+      return *this;
+    }
+
+    ArrayBuilder& push(const char* value) { return push(std::string_view(value)); }
+    ArrayBuilder& push(JsonValue&& value);
+    ArrayBuilder& push(ObjectBuilder&& nested);
+    ArrayBuilder& push(ArrayBuilder&& nested);
+
+    size_t size() const { return _value.Size(); }
+
+    // Hands the array over without copying; the builder is left empty
+    JsonValue build();
+
+    friend class ObjectBuilder;
+
+  private:
+    rapidjson::Value _value;
+    rapidjson::Document::AllocatorType& _allocator;
+  };
+}
+
+#endif //MGUTILS_JSONBUILDER_H
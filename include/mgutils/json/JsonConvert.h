@@ -0,0 +1,197 @@
+#ifndef MGUTILS_JSONCONVERT_H
+#define MGUTILS_JSONCONVERT_H
+
+#include "rapidjson/document.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace mgutils
+{
+  // Outcome of a bulk extraction: how many elements were written and the first element that failed
+  struct JsonExtractResult
+  {
+    size_t count = 0;
+    std::optional<size_t> badIndex;
+
+    explicit operator bool() const { return !badIndex.has_value(); }
+  };
+
+  namespace json
+  {
+    // Reads a JSON number into T. Integer types never go through double and are range checked;
+    // returns false when the value is not a number of a compatible kind.
+    template <typename T>
+    inline bool readNumber(const rapidjson::Value& value, T& out)
+    {
+      static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "readNumber needs a numeric type");
+
+      if constexpr (std::is_floating_point_v<T>) {
+        if (!value.IsNumber())
+          return false;
+        out = static_cast<T>(value.GetDouble());
+        return true;
+      } else if constexpr (std::is_signed_v<T>) {
+        if (!value.IsInt64())
+          return false;
+        int64_t v = value.GetInt64();
+        if (v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max())
+          return false;
+        out = static_cast<T>(v);
+        return true;
+      } else {
+        if (!value.IsUint64())
+          return false;
+        uint64_t v = value.GetUint64();
+        if (v > std::numeric_limits<T>::max())
+          return false;
+        out = static_cast<T>(v);
+        return true;
+      }
+    }
+
+    template <typename T>
+    inline constexpr bool unsupportedType = false;
+
+    // Reads a value into T: bool, any integer width, floating point, enums (through their underlying
+    // integer), std::string_view pointing into the DOM, or std::string. Integers never go through double.
+    // out is only written on success.
+    template <typename T>
+    inline bool read(const rapidjson::Value& value, T& out)
+    {
+      if constexpr (std::is_same_v<T, bool>) {
+        if (!value.IsBool())
+          return false;
+        out = value.GetBool();
+        return true;
+      } else if constexpr (std::is_enum_v<T>) {
+        std::underlying_type_t<T> raw;
+        if (!readNumber(value, raw))
+          return false;
+        out = static_cast<T>(raw);
+        return true;
+      } else if constexpr (std::is_arithmetic_v<T>) {
+        return readNumber(value, out);
+      } else if constexpr (std::is_same_v<T, std::string_view>) {
+        if (!value.IsString())
+          return false;
+        out = std::string_view(value.GetString(), value.GetStringLength());
+        return true;
+      } else if constexpr (std::is_same_v<T, std::string>) {
+        if (!value.IsString())
+          return false;
+        out.assign(value.GetString(), value.GetStringLength());
+        return true;
+      } else {
+        static_assert(unsupportedType<T>, "Unsupported type for JSON read");
+        return false;
+      }
+    }
+
+    // Copies an array of numbers into out, reusing its capacity.
+    // Stops at the first incompatible element, leaving out with the elements read before it.
+    template <typename T>
+    JsonExtractResult extractNumbers(const rapidjson::Value& array, std::vector<T>& out)
+    {
+      const rapidjson::SizeType count = array.Size();
+      out.resize(count);
+
+      T* data = out.data();
+      auto it = array.Begin();
+      for (rapidjson::SizeType i = 0; i < count; ++i, ++it)
+      {
+        if (!readNumber(*it, data[i])) {
+          out.resize(i);
+          return {i, i};
+        }
+      }
+
+      return {count, std::nullopt};
+    }
+
+    // Member lookup that first tries the position the key had in the previous object.
+    // Arrays of uniform objects usually keep the same member order, making the lookup O(1).
+    inline const rapidjson::Value* findMemberHinted(const rapidjson::Value& object, std::string_view name, rapidjson::SizeType& hint)
+    {
+      if (hint < object.MemberCount())
+      {
+        const auto& member = *(object.MemberBegin() + hint);
+        if (member.name.GetStringLength() == name.size() && std::memcmp(member.name.GetString(), name.data(), name.size()) == 0)
+          return &member.value;
+      }
+
+      rapidjson::SizeType position = 0;
+      for (auto it = object.MemberBegin(); it != object.MemberEnd(); ++it, ++position)
+      {
+        if (it->name.GetStringLength() == name.size() && std::memcmp(it->name.GetString(), name.data(), name.size()) == 0) {
+          hint = position;
+          return &it->value;
+        }
+      }
+
+      return nullptr;
+    }
+
+    // Byte-wise key order used by frozen documents, whose object members are kept sorted
+    inline bool keyLess(const rapidjson::Value& name, std::string_view key)
+    {
+      const size_t length = name.GetStringLength();
+      const int order = std::memcmp(name.GetString(), key.data(), std::min<size_t>(length, key.size()));
+      return order < 0 || (order == 0 && length < key.size());
+    }
+
+    // Binary search over an object whose members are sorted with keyLess
+    inline const rapidjson::Value* findMemberSorted(const rapidjson::Value& object, std::string_view name)
+    {
+      auto it = std::lower_bound(object.MemberBegin(), object.MemberEnd(), name,
+                                 [](const auto& member, std::string_view key) { return keyLess(member.name, key); });
+      if (it != object.MemberEnd() && it->name.GetStringLength() == name.size() &&
+          std::memcmp(it->name.GetString(), name.data(), name.size()) == 0)
+        return &it->value;
+      return nullptr;
+    }
+
+    template <typename T>
+    inline bool readColumnCell(const rapidjson::Value& object, std::string_view name, rapidjson::SizeType& hint, T& out)
+    {
+      const rapidjson::Value* value = findMemberHinted(object, name, hint);
+      return value && readNumber(*value, out);
+    }
+
+    // Splits an array of uniform objects into one contiguous column per field (struct of arrays),
+    // e.g. [{"px":1,"qty":2},...] with fields {"px","qty"} fills a px column and a qty column.
+    template <typename... Ts>
+    JsonExtractResult extractColumns(const rapidjson::Value& array,
+                                     const std::array<std::string_view, sizeof...(Ts)>& fields,
+                                     std::vector<Ts>&... columns)
+    {
+      const rapidjson::SizeType count = array.Size();
+      (columns.resize(count), ...);
+
+      std::array<rapidjson::SizeType, sizeof...(Ts)> hints{};
+      auto it = array.Begin();
+      for (rapidjson::SizeType i = 0; i < count; ++i, ++it)
+      {
+        bool ok = it->IsObject();
+        size_t column = 0;
+        ((ok = ok && readColumnCell(*it, fields[column], hints[column], columns[i]), ++column), ...);
+
+        if (!ok) {
+          (columns.resize(i), ...);
+          return {i, i};
+        }
+      }
+
+      return {count, std::nullopt};
+    }
+  }
+}
+
+#endif //MGUTILS_JSONCONVERT_H
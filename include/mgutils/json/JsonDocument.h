@@ -10,28 +10,56 @@
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
+#include <cstdint>
 #include <fstream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 #include <type_traits>
+#include "JsonView.h"
 
 namespace mgutils
 {
   class JsonValue; // Forward declaration
+  class FrozenJson;
+  class JsonPatch;
 
   class JsonDocument: public std::enable_shared_from_this<JsonDocument>
   {
   public:
     JsonValue getRoot();  // To get the root object
+    JsonView view() const; // Read-only view of the root, without copying
+    // Immutable snapshot safe for concurrent readers; compact packs it into one allocation with sorted keys
+    std::shared_ptr<const FrozenJson> freeze(bool compact = true) const;
+    // Replaces the root, stealing the value when it was built in this document's allocator
+    void setRoot(JsonValue&& root);
     rapidjson::Document::AllocatorType& getAllocator();
     // Serialization
     std::string toString(bool pretty = false) const;
-    bool save(const std::string& file);
+    // Appends the serialized document to out, reusing its capacity
+    void serializeTo(std::string& out, bool pretty = false) const;
+    // Writes the serialized document to a file descriptor through chunked vectored writes
+    bool serializeTo(int fd, bool pretty = false) const;
+    bool save(const std::string& file, bool pretty = false);
+    // Binary encodings walking the DOM directly; the overloads taking a vector append to it
+    std::vector<uint8_t> toMsgPack() const;
+    void toMsgPack(std::vector<uint8_t>& out) const;
+    std::vector<uint8_t> toCbor() const;
+    void toCbor(std::vector<uint8_t>& out) const;
+    // JSON Patch (RFC 6902) applied in place; all or nothing, throws JsonPatchException on failure
+    void applyPatch(const JsonPatch& patch);
+    // JSON Merge Patch (RFC 7396) applied in place
+    void applyMergePatch(const JsonView& patch);
+    // Patch turning this document into target
+    JsonPatch diff(const JsonDocument& target) const;
     bool isArray();
     bool isObject();
 
     friend class Json;
+    friend class JsonPatch;
+    friend class JsonSchema;
+    friend class JsonIncrementalParser;
 
   private:
     JsonDocument();
@@ -39,6 +67,8 @@ namespace mgutils
     void setArray();
     rapidjson::Document _document;
     rapidjson::Document::AllocatorType& _allocator;
+    // Keeps alive any external buffer the document references (e.g. an in-situ file mapping)
+    std::shared_ptr<const void> _source;
   };
 
 
@@ -0,0 +1,87 @@
+#ifndef MGUTILS_JSONINCREMENTALPARSER_H
+#define MGUTILS_JSONINCREMENTALPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mgutils
+{
+  class JsonDocument;
+  class StringPool;
+
+  // Parser for top level objects and arrays arriving in fragments (e.g. websocket frames).
+  // feed() scans each chunk for document boundaries and parses the documents lying entirely inside it
+  // straight from the chunk. A document cut by the end of a chunk is handed to a resumable tokenizer
+  // instead, which emits SAX events into the document under construction and keeps only the state of
+  // the token it stopped in (nesting, a partial string, number or literal), so the next chunk carries
+  // on where the last one ended and no byte is tokenized twice.
+  //
+  //   JsonIncrementalParser parser([](std::shared_ptr<JsonDocument> doc) { ... });
+  //   parser.feed(frame.data(), frame.size());
+  class JsonIncrementalParser
+  {
+  public:
+    using OnDocumentCallback = std::function<void(std::shared_ptr<JsonDocument>)>;
+
+    // With a pool, keys and short strings of every emitted document are interned in it
+    explicit JsonIncrementalParser(OnDocumentCallback onDocument, std::shared_ptr<StringPool> pool = nullptr);
+
+    // Returns the number of documents emitted. Throws JsonParseException on malformed input or a
+    // top level scalar, after resetting; the remainder of that chunk is dropped.
+    size_t feed(const char* data, size_t size);
+    size_t feed(std::string_view chunk) { return feed(chunk.data(), chunk.size()); }
+
+    // Drops any partially received document
+    void reset();
+
+    // True when no partial document is pending
+    bool idle() const { return !_document; }
+    // Bytes held for a token cut by a chunk boundary (the decoded part of a string, a partial number)
+    size_t buffered() const { return _token.size(); }
+
+  private:
+    // What the tokenizer accepts next, outside of a token
+    enum class Expect : uint8_t { Value, ValueOrEnd, Key, KeyOrEnd, Colon, CommaOrEnd };
+    // Token the tokenizer is inside of
+    enum class Token : uint8_t { None, String, Key, Number, Literal };
+
+    struct Container
+    {
+      bool object;
+      uint32_t count;
+    };
+
+    size_t scan(const char* data, size_t begin, size_t size, size_t& emitted);
+    size_t resume(const char* data, size_t size);
+    size_t string(const char* data, size_t begin, size_t size);
+    void value(char c);
+    void codepoint(uint32_t codepoint);
+    void endString();
+    void endNumber();
+    void close(bool object);
+    void finish();
+    std::shared_ptr<JsonDocument> parse(const char* data, size_t size);
+    [[noreturn]] void fail(const std::string& reason);
+
+    OnDocumentCallback _onDocument;
+    std::shared_ptr<StringPool> _pool;
+
+    // Document spanning chunks, built by the tokenizer; null between documents
+    std::shared_ptr<JsonDocument> _document;
+    std::vector<Container> _containers;
+    std::string _token;
+    Expect _expect = Expect::Value;
+    Token _inside = Token::None;
+    const char* _literal = nullptr; // rest of true/false/null still to match
+    uint8_t _escape = 0;            // 1 after a backslash, 2 to 5 while reading the digits of \u
+    uint32_t _unicode = 0;
+    uint32_t _highSurrogate = 0;
+  };
+}
+
+#endif //MGUTILS_JSONINCREMENTALPARSER_H
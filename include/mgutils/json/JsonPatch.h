@@ -0,0 +1,107 @@
+#ifndef MGUTILS_JSONPATCH_H
+#define MGUTILS_JSONPATCH_H
+
+#include "rapidjson/document.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "JsonPath.h"
+#include "JsonView.h"
+
+namespace mgutils
+{
+  class JsonDocument;
+
+  // Compiled JSON Patch (RFC 6902): the operations array with every path pre-compiled.
+  // Applying a patch edits the target document in place and is all or nothing: when an operation
+  // fails, the operations already applied are undone before JsonPatchException is thrown.
+  // Patch pointers are plain RFC 6901 pointers, so "*" names a member rather than a wildcard.
+  // A compiled patch is immutable and can be shared between threads and applied to many documents.
+  class JsonPatch
+  {
+  public:
+    // Throws JsonUsageException when operations is not a well-formed patch
+    static JsonPatch compile(const JsonView& operations);
+    // Throws JsonParseException for malformed JSON and JsonUsageException for a malformed patch
+    static JsonPatch parse(const std::string& json);
+
+    // Patch turning from into to. Objects are compared member by member and array elements are
+    // aligned on their longest common subsequence, so each changed, inserted or removed value costs
+    // one operation. Moves are not detected; a moved element shows up as a remove and an add.
+    static JsonPatch diff(const JsonView& from, const JsonView& to);
+
+    // Merge patch (RFC 7396) applied in place: null removes a member, objects merge recursively and
+    // any other value replaces the target
+    static void applyMerge(JsonDocument& document, const JsonView& mergePatch);
+
+    void apply(JsonDocument& document) const;
+
+    size_t size() const { return _operations.size(); }
+    bool empty() const { return _operations.empty(); }
+
+    // The operations as a JSON array
+    JsonView view() const { return JsonView(*_document); }
+    std::string toString(bool pretty = false) const { return view().toString(pretty); }
+
+  private:
+    enum class Op : uint8_t
+    {
+      Add,
+      Remove,
+      Replace,
+      Move,
+      Copy,
+      Test
+    };
+
+    struct Operation
+    {
+      Op op;
+      JsonPath path;
+      JsonPath from;
+      const rapidjson::Value* value; // points into _document
+    };
+
+    // Inverse of one applied edit, replayed backwards to roll a failed patch back.
+    // Erase and Restore leave the value they take out in a carry slot that a following Insert
+    // can consume, which is how a move is undone.
+    struct Undo
+    {
+      enum class Kind : uint8_t
+      {
+        Erase,
+        Insert,
+        Restore
+      };
+
+      Kind kind;
+      const JsonPath* path;
+      uint32_t position;   // array index or member position within the parent
+      bool carry;          // Insert takes the carried value instead of value
+      rapidjson::Value value;
+    };
+
+    using Allocator = rapidjson::Document::AllocatorType;
+
+    JsonPatch() = default;
+
+    // Compiles the operations held by document, which the patch then owns
+    static JsonPatch fromDocument(std::shared_ptr<rapidjson::Document> document);
+
+    static void applyOperation(rapidjson::Value& root, const Operation& operation, Allocator& allocator,
+                               std::vector<Undo>& undo);
+    static void rollback(rapidjson::Value& root, std::vector<Undo>& undo, Allocator& allocator);
+
+    static rapidjson::Value* resolve(rapidjson::Value& root, const JsonPath& path);
+    static rapidjson::Value& parentOf(rapidjson::Value& root, const JsonPath& path);
+    static void add(rapidjson::Value& root, const JsonPath& path, rapidjson::Value& value, Allocator& allocator,
+                    std::vector<Undo>& undo);
+    static rapidjson::Value take(rapidjson::Value& root, const JsonPath& path, bool carry, std::vector<Undo>& undo);
+
+    std::shared_ptr<const rapidjson::Document> _document;
+    std::vector<Operation> _operations;
+  };
+}
+
+#endif //MGUTILS_JSONPATCH_H
@@ -0,0 +1,61 @@
+#ifndef MGUTILS_JSONPATH_H
+#define MGUTILS_JSONPATH_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "JsonView.h"
+
+namespace mgutils
+{
+  class JsonDocument;
+
+  // Pre-compiled JSON Pointer (RFC 6901), e.g. "/data/0/bids".
+  // Tokens are unescaped and array indices parsed once at compile time.
+  // A "*" token is a wildcard matching every element of an array or every member of an object.
+  // A compiled path is immutable and can be shared between threads and reused across documents.
+  class JsonPath
+  {
+  public:
+    // Throws JsonUsageException for a malformed pointer
+    static JsonPath compile(const std::string& pointer);
+
+    // First value matching the path, or nullopt when nothing matches
+    std::optional<JsonView> evaluate(const JsonDocument& document) const;
+    std::optional<JsonView> evaluate(const JsonView& root) const;
+
+    // Clears out and fills it with every value matching the path, returns the number of matches
+    size_t evaluateAll(const JsonDocument& document, std::vector<JsonView>& out) const;
+    size_t evaluateAll(const JsonView& root, std::vector<JsonView>& out) const;
+
+    bool hasWildcard() const { return _hasWildcard; }
+    size_t depth() const { return _tokens.size(); }
+    const std::string& pointer() const { return _pointer; }
+
+    friend class JsonPatch;
+
+  private:
+    struct Token
+    {
+      std::string key;
+      // Parsed array index, or NO_INDEX when the token is not a valid array index
+      uint32_t index;
+      bool wildcard;
+      bool append; // "-", the position past the last array element
+    };
+
+    static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+    JsonPath() = default;
+
+    static const rapidjson::Value* step(const rapidjson::Value& value, const Token& token, bool sortedKeys);
+    void collect(const rapidjson::Value& value, size_t tokenIndex, bool sortedKeys, std::vector<JsonView>& out) const;
+
+    std::string _pointer;
+    std::vector<Token> _tokens;
+    bool _hasWildcard = false;
+  };
+}
+
+#endif //MGUTILS_JSONPATH_H
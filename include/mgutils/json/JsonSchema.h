@@ -0,0 +1,49 @@
+#ifndef MGUTILS_JSONSCHEMA_H
+#define MGUTILS_JSONSCHEMA_H
+
+#include "rapidjson/document.h"
+#include "rapidjson/schema.h"
+#include <memory>
+#include <string>
+#include "JsonView.h"
+
+namespace mgutils
+{
+  class JsonDocument;
+
+  // Compiled JSON Schema (draft-04, as supported by rapidjson).
+  // parse() validates while it reads the text, in the same single SAX pass that builds the DOM, so an
+  // invalid message is rejected as soon as the offending value is seen and no document is returned.
+  // The compiled schema is immutable and can be shared between threads.
+  //
+  //   auto schema = JsonSchema::compile(R"({"type":"object","required":["s","p"]})");
+  //   auto doc = schema->parse(message); // throws JsonValidationException naming the failing path
+  class JsonSchema
+  {
+  public:
+    JsonSchema(const JsonSchema&) = delete;
+    JsonSchema& operator=(const JsonSchema&) = delete;
+
+    // Throws JsonUsageException when schema is not an object
+    static std::shared_ptr<const JsonSchema> compile(const JsonView& schema);
+    // Throws JsonParseException when schema is not valid JSON
+    static std::shared_ptr<const JsonSchema> compile(const std::string& schema);
+
+    // Throws JsonParseException for malformed JSON and JsonValidationException when it breaks the schema
+    std::shared_ptr<JsonDocument> parse(const std::string& json) const;
+    std::shared_ptr<JsonDocument> parse(const char* json, size_t length) const;
+
+    // Validates an existing value; throws JsonValidationException
+    void validate(const JsonView& value) const;
+    bool isValid(const JsonView& value) const;
+
+  private:
+    explicit JsonSchema(const rapidjson::Value& schema);
+
+    // rapidjson schemas may refer back to their source, so it lives as long as the compiled schema
+    rapidjson::Document _source;
+    rapidjson::SchemaDocument _schema;
+  };
+}
+
+#endif //MGUTILS_JSONSCHEMA_H
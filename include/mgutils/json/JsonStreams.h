@@ -0,0 +1,28 @@
+#ifndef MGUTILS_JSONSTREAMS_H
+#define MGUTILS_JSONSTREAMS_H
+
+#include <string>
+
+namespace mgutils
+{
+  // rapidjson output stream appending straight to a caller owned std::string.
+  // Serializing into a reused string allocates nothing once its capacity is warm.
+  class JsonStringStream
+  {
+  public:
+    typedef char Ch;
+
+    explicit JsonStringStream(std::string& out): _out(&out) {}
+
+    void Put(char c) { _out->push_back(c); }
+    void Flush() {}
+
+    std::string& string() { return *_out; }
+    const std::string& string() const { return *_out; }
+
+  private:
+    std::string* _out;
+  };
+}
+
+#endif //MGUTILS_JSONSTREAMS_H
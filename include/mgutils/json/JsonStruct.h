@@ -0,0 +1,466 @@
+#ifndef MGUTILS_JSONSTRUCT_H
+#define MGUTILS_JSONSTRUCT_H
+
+#include "rapidjson/encodedstream.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+#include "rapidjson/writer.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "StructFields.h"
+#include "JsonStreams.h"
+#include "Exceptions.h"
+
+// Binds the listed members of Type to JSON object keys of the same name.
+// Must be used in the namespace of Type so JsonStruct can find the binding through ADL.
+// Supported member types: std::string, bool, char (as a one character string), integers, floating point and enums.
+#define MG_JSON_STRUCT(Type, ...)                                       \
+  inline constexpr auto mgJsonFields(const Type*)                       \
+  {                                                                     \
+    return MGUTILS_STRUCT_FIELDS(Type, __VA_ARGS__);                    \
+  }
+
+namespace mgutils
+{
+  constexpr uint32_t jsonKeyHash(std::string_view key, uint32_t seed)
+  {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : key) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 16777619u;
+    }
+    return hash ^ (hash >> 16);
+  }
+
+  // Collision free key -> field index table, found at compile time by searching for a hash seed
+  template <size_t N>
+  struct JsonKeyTable
+  {
+    static_assert(N > 0 && N < 255, "A JSON struct binding needs between 1 and 254 fields");
+
+    static constexpr size_t slotCount()
+    {
+      size_t slots = 1;
+      while (slots < N * 4)
+        slots <<= 1;
+      return slots;
+    }
+
+    static constexpr uint8_t EMPTY = 0xFF;
+
+    uint32_t seed = 0;
+    std::array<uint8_t, slotCount()> slots{};
+    std::array<std::string_view, N> names{};
+
+    // Field index for a key or -1 when the key is not bound
+    int find(const char* key, size_t length) const
+    {
+      std::string_view name(key, length);
+      uint8_t index = slots[jsonKeyHash(name, seed) & (slotCount() - 1)];
+      if (index == EMPTY || names[index] != name)
+        return -1;
+      return index;
+    }
+  };
+
+  template <size_t N>
+  constexpr JsonKeyTable<N> makeJsonKeyTable(const std::array<std::string_view, N>& names)
+  {
+    JsonKeyTable<N> table{};
+    table.names = names;
+
+    for (uint32_t seed = 0; seed < 65536; ++seed)
+    {
+      for (auto& slot : table.slots)
+        slot = JsonKeyTable<N>::EMPTY;
+
+      bool collision = false;
+      for (size_t i = 0; i < N && !collision; ++i)
+      {
+        auto& slot = table.slots[jsonKeyHash(names[i], seed) & (JsonKeyTable<N>::slotCount() - 1)];
+        if (slot != JsonKeyTable<N>::EMPTY)
+          collision = true;
+        else
+          slot = static_cast<uint8_t>(i);
+      }
+
+      if (!collision) {
+        table.seed = seed;
+        return table;
+      }
+    }
+
+    // Only reachable with duplicated names; fails the constant evaluation
+    throw std::logic_error("Duplicated key in JSON struct binding");
+  }
+
+  template <typename T>
+  struct JsonStructTraits
+  {
+    static constexpr auto fields = mgJsonFields(static_cast<const T*>(nullptr));
+    static constexpr size_t size = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+    static constexpr JsonKeyTable<size> keys = makeJsonKeyTable(structFieldNames(fields));
+  };
+
+  namespace json_struct
+  {
+    template <typename T>
+    bool assignSigned(T& out, int64_t value)
+    {
+      if constexpr (std::is_enum_v<T>) {
+        std::underlying_type_t<T> underlying{};
+        if (!assignSigned(underlying, value))
+          return false;
+        out = static_cast<T>(underlying);
+        return true;
+      } else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>) {
+        return false;
+      } else if constexpr (std::is_floating_point_v<T>) {
+        out = static_cast<T>(value);
+        return true;
+      } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+          return false;
+        out = static_cast<T>(value);
+        return true;
+      } else if constexpr (std::is_integral_v<T>) {
+        if (value < 0 || static_cast<uint64_t>(value) > std::numeric_limits<T>::max())
+          return false;
+        out = static_cast<T>(value);
+        return true;
+      } else {
+        return false;
+      }
+    }
+
+    template <typename T>
+    bool assignUnsigned(T& out, uint64_t value)
+    {
+      if constexpr (std::is_enum_v<T>) {
+        std::underlying_type_t<T> underlying{};
+        if (!assignUnsigned(underlying, value))
+          return false;
+        out = static_cast<T>(underlying);
+        return true;
+      } else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>) {
+        return false;
+      } else if constexpr (std::is_floating_point_v<T>) {
+        out = static_cast<T>(value);
+        return true;
+      } else if constexpr (std::is_integral_v<T>) {
+        if (value > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+          return false;
+        out = static_cast<T>(value);
+        return true;
+      } else {
+        return false;
+      }
+    }
+
+    template <typename T>
+    bool assignDouble(T& out, double value)
+    {
+      if constexpr (std::is_floating_point_v<T>) {
+        out = static_cast<T>(value);
+        return true;
+      } else {
+        return false;
+      }
+    }
+
+    template <typename T>
+    bool assignBool(T& out, bool value)
+    {
+      if constexpr (std::is_same_v<T, bool>) {
+        out = value;
+        return true;
+      } else {
+        return false;
+      }
+    }
+
+    template <typename T>
+    bool assignString(T& out, const char* str, size_t length)
+    {
+      if constexpr (std::is_same_v<T, std::string>) {
+        out.assign(str, length);
+        return true;
+      } else if constexpr (std::is_same_v<T, char>) {
+        if (length > 1)
+          return false;
+        out = length == 1 ? str[0] : '\0';
+        return true;
+      } else {
+        return false;
+      }
+    }
+
+    template <typename Writer, typename T>
+    void writeValue(Writer& writer, const T& value)
+    {
+      if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+        writer.String(value.data(), static_cast<rapidjson::SizeType>(value.size()));
+      } else if constexpr (std::is_same_v<T, char>) {
+        if (value == '\0')
+          writer.Null();
+        else
+          writer.String(&value, 1);
+      } else if constexpr (std::is_same_v<T, bool>) {
+        writer.Bool(value);
+      } else if constexpr (std::is_enum_v<T>) {
+        writeValue(writer, static_cast<std::underlying_type_t<T>>(value));
+      } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        writer.Int64(value);
+      } else if constexpr (std::is_integral_v<T>) {
+        writer.Uint64(value);
+      } else if constexpr (std::is_floating_point_v<T>) {
+        // NaN and infinity are not valid JSON, unset values are written as null
+        if (std::isfinite(value))
+          writer.Double(value);
+        else
+          writer.Null();
+      } else {
+        static_assert(sizeof(T) == 0, "Unsupported member type in JSON struct binding");
+      }
+    }
+
+    // SAX handler decoding a single object into T, or an array of objects into std::vector<T>.
+    // Unbound keys are skipped including nested containers; a bound key with an incompatible value stops the parse.
+    template <typename T>
+    class Handler: public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler<T>>
+    {
+    public:
+      using Traits = JsonStructTraits<T>;
+
+      explicit Handler(T& target): _single(&target), _fieldsDepth(1) {}
+      explicit Handler(std::vector<T>& targets): _list(&targets), _fieldsDepth(2) {}
+
+      bool Null() { return scalar([](auto&) { return true; }); }
+      bool Bool(bool b) { return scalar([b](auto& out) { return assignBool(out, b); }); }
+      bool Int(int i) { return scalar([i](auto& out) { return assignSigned(out, i); }); }
+      bool Uint(unsigned u) { return scalar([u](auto& out) { return assignUnsigned(out, u); }); }
+      bool Int64(int64_t i) { return scalar([i](auto& out) { return assignSigned(out, i); }); }
+      bool Uint64(uint64_t u) { return scalar([u](auto& out) { return assignUnsigned(out, u); }); }
+      bool Double(double d) { return scalar([d](auto& out) { return assignDouble(out, d); }); }
+
+      bool String(const char* str, rapidjson::SizeType length, bool)
+      {
+        return scalar([str, length](auto& out) { return assignString(out, str, length); });
+      }
+
+      bool Key(const char* str, rapidjson::SizeType length, bool)
+      {
+        if (_skipDepth == 0 && _depth == _fieldsDepth)
+          _field = Traits::keys.find(str, length);
+        return true;
+      }
+
+      bool StartObject()
+      {
+        if (_skipDepth != 0 || _depth == _fieldsDepth)
+          return startNested();
+
+        if (_depth == 0 && _single) {
+          _current = _single;
+        } else if (_depth == 1 && _list) {
+          _current = &_list->emplace_back();
+        } else {
+          _error = "Unexpected object";
+          return false;
+        }
+
+        ++_depth;
+        return true;
+      }
+
+      bool StartArray()
+      {
+        if (_skipDepth != 0 || _depth == _fieldsDepth)
+          return startNested();
+
+        if (_depth == 0 && _list) {
+          ++_depth;
+          return true;
+        }
+
+        _error = "Unexpected array";
+        return false;
+      }
+
+      bool EndObject(rapidjson::SizeType) { return end(); }
+      bool EndArray(rapidjson::SizeType) { return end(); }
+
+      const std::string& error() const { return _error; }
+
+    private:
+      template <typename Assign>
+      bool scalar(Assign&& assign)
+      {
+        if (_skipDepth != 0)
+          return true;
+
+        if (_depth != _fieldsDepth) {
+          _error = "Expected an object";
+          return false;
+        }
+
+        if (_field < 0)
+          return true;
+
+        bool assigned = false;
+        visitStructField(Traits::fields, static_cast<size_t>(_field), [&](const auto& field) {
+          assigned = assign(_current->*(field.member));
+        });
+
+        if (!assigned) {
+          _error = "Incompatible value for key '" + std::string(Traits::keys.names[_field]) + "'";
+          return false;
+        }
+
+        _field = -1;
+        return true;
+      }
+
+      bool startNested()
+      {
+        if (_skipDepth == 0)
+        {
+          if (_field >= 0) {
+            _error = "Incompatible value for key '" + std::string(Traits::keys.names[_field]) + "'";
+            return false;
+          }
+          _skipDepth = _depth + 1;
+        }
+
+        ++_depth;
+        return true;
+      }
+
+      bool end()
+      {
+        if (_skipDepth != 0 && _depth == _skipDepth)
+          _skipDepth = 0;
+
+        --_depth;
+        _field = -1;
+        return true;
+      }
+
+      T* _single = nullptr;
+      std::vector<T>* _list = nullptr;
+      T* _current = nullptr;
+      size_t _fieldsDepth;
+      size_t _depth = 0;
+      size_t _skipDepth = 0;
+      int _field = -1;
+      std::string _error;
+    };
+  }
+
+  // DOM-free JSON decoding and encoding of structs bound with MG_JSON_STRUCT
+  class JsonStruct
+  {
+  public:
+    template <typename T>
+    static void decode(const char* json, size_t length, T& out)
+    {
+      json_struct::Handler<T> handler(out);
+      parse(json, length, handler);
+    }
+
+    template <typename T>
+    static void decode(const std::string& json, T& out)
+    {
+      decode(json.data(), json.size(), out);
+    }
+
+    template <typename T>
+    static T decode(const std::string& json)
+    {
+      T out;
+      decode(json.data(), json.size(), out);
+      return out;
+    }
+
+    // Decodes a JSON array of objects, appending one element per object to out
+    template <typename T>
+    static void decodeArray(const char* json, size_t length, std::vector<T>& out)
+    {
+      json_struct::Handler<T> handler(out);
+      parse(json, length, handler);
+    }
+
+    template <typename T>
+    static void decodeArray(const std::string& json, std::vector<T>& out)
+    {
+      decodeArray(json.data(), json.size(), out);
+    }
+
+    // Writes object as a JSON object through any rapidjson writer
+    template <typename Writer, typename T>
+    static void write(Writer& writer, const T& object)
+    {
+      writer.StartObject();
+      forEachStructField(JsonStructTraits<T>::fields, [&](const auto& field) {
+        writer.Key(field.name.data(), static_cast<rapidjson::SizeType>(field.name.size()));
+        json_struct::writeValue(writer, object.*(field.member));
+      });
+      writer.EndObject();
+    }
+
+    // Appends the encoded object to out
+    template <typename T>
+    static void encodeTo(std::string& out, const T& object)
+    {
+      JsonStringStream stream(out);
+      rapidjson::Writer<JsonStringStream> writer(stream);
+      write(writer, object);
+    }
+
+    template <typename T>
+    static std::string encode(const T& object)
+    {
+      std::string out;
+      encodeTo(out, object);
+      return out;
+    }
+
+    template <typename T>
+    static std::string encodeArray(const std::vector<T>& objects)
+    {
+      std::string out;
+      JsonStringStream stream(out);
+      rapidjson::Writer<JsonStringStream> writer(stream);
+      writer.StartArray();
+      for (const auto& object : objects)
+        write(writer, object);
+      writer.EndArray();
+      return out;
+    }
+
+  private:
+    template <typename Handler>
+    static void parse(const char* json, size_t length, Handler& handler)
+    {
+      rapidjson::MemoryStream memoryStream(json, length);
+      rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> stream(memoryStream);
+      rapidjson::Reader reader;
+      rapidjson::ParseResult result = reader.Parse(stream, handler);
+
+      if (result.IsError())
+      {
+        std::string reason = handler.error().empty() ? rapidjson::GetParseError_En(result.Code()) : handler.error();
+        throw JsonParseException("Failed to decode JSON struct at offset " + std::to_string(result.Offset()) + ": " + reason);
+      }
+    }
+  };
+}
+
+#endif //MGUTILS_JSONSTRUCT_H
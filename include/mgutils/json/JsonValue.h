@@ -15,6 +15,8 @@
 #include <string>
 #include <vector>
 #include <type_traits>
+#include "JsonView.h"
+#include "JsonConvert.h"
 
 namespace mgutils
 {
@@ -60,8 +62,19 @@ namespace mgutils
     std::optional<bool> asBool() const;
     std::optional<float> asFloat() const;
     std::optional<double> asDouble() const;
-    std::optional<double> asUint() const;
-    std::optional<double> asUint64() const;
+    std::optional<unsigned> asUint() const;
+    std::optional<uint64_t> asUint64() const;
+
+    // Typed access with compile time dispatch: string_view, std::string, bool, any integer width,
+    // floating point and enums. A string_view points into this value and lives as long as it does.
+    template <typename T>
+    std::optional<T> get(std::string_view key) const { return view().get<T>(key); }
+
+    template <typename T>
+    std::optional<T> as() const { return view().as<T>(); }
+
+    template <typename T>
+    T getOr(std::string_view key, T fallback) const { return view().getOr<T>(key, std::move(fallback)); }
 
     bool isNull();
     bool isEmpty();
@@ -70,6 +83,35 @@ namespace mgutils
     std::vector<JsonValue> getArray(const std::string& key) const;
     std::vector<JsonValue> getArray() const;
 
+    // Copies the numeric array at key into out, reusing its capacity.
+    // Throws JsonUsageException if key is not an array; element errors are reported through the result.
+    template <typename T>
+    JsonExtractResult getNumbers(const std::string& key, std::vector<T>& out) const
+    {
+      return json::extractNumbers(arrayMember(key), out);
+    }
+
+    template <typename T>
+    JsonExtractResult asNumbers(std::vector<T>& out) const
+    {
+      return json::extractNumbers(asArray(), out);
+    }
+
+    // Splits the array of uniform objects at key into one column per field,
+    // e.g. getColumns("bids", {"px", "qty"}, prices, quantities)
+    template <typename... Ts>
+    JsonExtractResult getColumns(const std::string& key, const std::array<std::string_view, sizeof...(Ts)>& fields,
+                                 std::vector<Ts>&... columns) const
+    {
+      return json::extractColumns(arrayMember(key), fields, columns...);
+    }
+
+    template <typename... Ts>
+    JsonExtractResult asColumns(const std::array<std::string_view, sizeof...(Ts)>& fields, std::vector<Ts>&... columns) const
+    {
+      return json::extractColumns(asArray(), fields, columns...);
+    }
+
     template <typename T>
     JsonValue& set(const std::string& key, T& value)
     {
@@ -160,11 +202,32 @@ namespace mgutils
       }
     }
 
+    // Move-taking overloads: the source is stolen when it lives in the same document allocator and
+    // deep-copied otherwise; either way it is left null. The key is looked up once.
+    JsonValue& set(const std::string& key, JsonValue&& value);
+    JsonValue& set(const std::string& key, std::vector<JsonValue>&& values);
+
     size_t size() const;
 
+    // Read-only view of this value, without copying
+    JsonView view() const { return JsonView(_value); }
+
+    friend class JsonDocument;
+    friend class ObjectBuilder;
+    friend class ArrayBuilder;
+
   private:
 
     JsonValue(const rapidjson::Value& value, rapidjson::Document::AllocatorType& allocator);
+    JsonValue(rapidjson::Value&& value, rapidjson::Document::AllocatorType& allocator);
+
+    // Moves the value out when it already lives in target, otherwise deep-copies it into target
+    rapidjson::Value release(rapidjson::Document::AllocatorType& target);
+    JsonValue& setMember(const std::string& key, rapidjson::Value& value);
+    void appendValues(rapidjson::Value& array, std::vector<JsonValue>& values);
+
+    const rapidjson::Value& arrayMember(const std::string& key) const;
+    const rapidjson::Value& asArray() const;
 
     JsonValue& setBool(const std::string& key, bool boolValue);
     JsonValue& setInt(const std::string& key, int intValue);
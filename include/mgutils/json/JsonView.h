@@ -0,0 +1,153 @@
+#ifndef MGUTILS_JSONVIEW_H
+#define MGUTILS_JSONVIEW_H
+
+#include "rapidjson/document.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "JsonConvert.h"
+
+namespace mgutils
+{
+  // Read-only, non-owning view over a value inside a JsonDocument.
+  // Views are cheap to copy and never copy the underlying DOM; they are valid as long as the
+  // document they point into is alive and not modified.
+  class JsonView
+  {
+  public:
+    explicit JsonView(const rapidjson::Value& value): _value(&value) {}
+
+    bool isNull() const { return _value->IsNull(); }
+    bool isBool() const { return _value->IsBool(); }
+    bool isNumber() const { return _value->IsNumber(); }
+    bool isString() const { return _value->IsString(); }
+    bool isObject() const { return _value->IsObject(); }
+    bool isArray() const { return _value->IsArray(); }
+    bool isEmpty() const;
+
+    bool exists(std::string_view key) const { return member(key) != nullptr; }
+    bool hasBool(std::string_view key) const;
+    bool hasNumber(std::string_view key) const;
+    bool hasString(std::string_view key) const;
+    bool hasObject(std::string_view key) const;
+    bool hasArray(std::string_view key) const;
+
+    std::optional<std::string_view> getString(std::string_view key) const;
+    std::optional<int> getInt(std::string_view key) const;
+    std::optional<unsigned> getUint(std::string_view key) const;
+    std::optional<int64_t> getInt64(std::string_view key) const;
+    std::optional<uint64_t> getUint64(std::string_view key) const;
+    std::optional<bool> getBool(std::string_view key) const;
+    std::optional<double> getDouble(std::string_view key) const;
+
+    std::optional<std::string_view> asString() const;
+    std::optional<int> asInt() const;
+    std::optional<unsigned> asUint() const;
+    std::optional<int64_t> asInt64() const;
+    std::optional<uint64_t> asUint64() const;
+    std::optional<bool> asBool() const;
+    std::optional<double> asDouble() const;
+
+    // Typed access dispatched at compile time, see json::read for the supported types.
+    // A string_view points into the document.
+    template <typename T>
+    std::optional<T> get(std::string_view key) const
+    {
+      T out;
+      if (auto value = member(key); value && json::read(*value, out))
+        return out;
+      return std::nullopt;
+    }
+
+    template <typename T>
+    std::optional<T> as() const
+    {
+      T out;
+      if (json::read(*_value, out))
+        return out;
+      return std::nullopt;
+    }
+
+    // Returns fallback when the key is missing or holds another type
+    template <typename T>
+    T getOr(std::string_view key, T fallback) const
+    {
+      if (auto value = member(key))
+        json::read(*value, fallback);
+      return fallback;
+    }
+
+    // Member of an object or element of an array, without copying
+    std::optional<JsonView> get(std::string_view key) const;
+    std::optional<JsonView> at(size_t index) const;
+
+    // Number of members of an object or elements of an array, 0 otherwise
+    size_t size() const;
+
+    // Calls f(JsonView) for every element of an array
+    template <typename F>
+    void forEach(F&& f) const
+    {
+      if (_value->IsArray())
+        for (const auto& element : _value->GetArray())
+          f(JsonView(element, _sortedKeys));
+    }
+
+    // Calls f(std::string_view key, JsonView value) for every member of an object
+    template <typename F>
+    void forEachMember(F&& f) const
+    {
+      if (_value->IsObject())
+        for (auto it = _value->MemberBegin(); it != _value->MemberEnd(); ++it)
+          f(std::string_view(it->name.GetString(), it->name.GetStringLength()), JsonView(it->value, _sortedKeys));
+    }
+
+    // Bulk numeric extraction, see JsonValue::getNumbers and JsonValue::getColumns.
+    // Throws JsonUsageException when the target is not an array.
+    template <typename T>
+    JsonExtractResult getNumbers(std::string_view key, std::vector<T>& out) const
+    {
+      return json::extractNumbers(arrayMember(key), out);
+    }
+
+    template <typename T>
+    JsonExtractResult asNumbers(std::vector<T>& out) const
+    {
+      return json::extractNumbers(asArray(), out);
+    }
+
+    template <typename... Ts>
+    JsonExtractResult getColumns(std::string_view key, const std::array<std::string_view, sizeof...(Ts)>& fields,
+                                 std::vector<Ts>&... columns) const
+    {
+      return json::extractColumns(arrayMember(key), fields, columns...);
+    }
+
+    template <typename... Ts>
+    JsonExtractResult asColumns(const std::array<std::string_view, sizeof...(Ts)>& fields, std::vector<Ts>&... columns) const
+    {
+      return json::extractColumns(asArray(), fields, columns...);
+    }
+
+    std::string toString(bool pretty = false) const;
+
+    friend class JsonPath;
+    friend class JsonPatch;
+    friend class JsonSchema;
+    friend class FrozenJson;
+
+  private:
+    // sortedKeys marks values of a frozen document, whose members can be binary searched
+    JsonView(const rapidjson::Value& value, bool sortedKeys): _value(&value), _sortedKeys(sortedKeys) {}
+
+    const rapidjson::Value* member(std::string_view key) const;
+    const rapidjson::Value& arrayMember(std::string_view key) const;
+    const rapidjson::Value& asArray() const;
+
+    const rapidjson::Value* _value;
+    bool _sortedKeys = false;
+  };
+}
+
+#endif //MGUTILS_JSONVIEW_H
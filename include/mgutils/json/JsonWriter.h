@@ -0,0 +1,93 @@
+#ifndef MGUTILS_JSONWRITER_H
+#define MGUTILS_JSONWRITER_H
+
+#include "rapidjson/writer.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "JsonStreams.h"
+#include "JsonStruct.h"
+
+namespace mgutils
+{
+  // Streaming JSON builder appending compact JSON to a caller owned string, without a JsonDocument.
+  // Keep one writer per thread and call reset() between messages to serialize with no allocations
+  // once the string and the writer's nesting stack have grown to size.
+  //
+  //   std::string out;
+  //   JsonWriter writer(out);
+  //   writer.startObject().field("symbol", "BTCUSDT").field("price", 65000.5).endObject();
+  class JsonWriter
+  {
+  public:
+    explicit JsonWriter(std::string& out): _stream(out), _writer(_stream) {}
+
+    // Clears the output string and starts a new top level value
+    void reset()
+    {
+      _stream.string().clear();
+      _writer.Reset(_stream);
+    }
+
+    JsonWriter& startObject() { _writer.StartObject(); return *this; }
+    JsonWriter& endObject() { _writer.EndObject(); return *this; }
+    JsonWriter& startArray() { _writer.StartArray(); return *this; }
+    JsonWriter& endArray() { _writer.EndArray(); return *this; }
+
+    JsonWriter& key(std::string_view name)
+    {
+      _writer.Key(name.data(), static_cast<rapidjson::SizeType>(name.size()));
+      return *this;
+    }
+
+    JsonWriter& null() { _writer.Null(); return *this; }
+
+    JsonWriter& value(std::nullptr_t) { return null(); }
+
+    JsonWriter& value(const char* str)
+    {
+      return value(std::string_view(str));
+    }
+
+    // Strings, bools, chars, enums and numbers; non finite floating point values are written as null
+    template <typename T>
+    JsonWriter& value(const T& v)
+    {
+      json_struct::writeValue(_writer, v);
+      return *this;
+    }
+
+    template <typename T>
+    JsonWriter& field(std::string_view name, const T& v)
+    {
+      key(name);
+      return value(v);
+    }
+
+    // Writes a struct bound with MG_JSON_STRUCT as an object
+    template <typename T>
+    JsonWriter& object(const T& bound)
+    {
+      JsonStruct::write(_writer, bound);
+      return *this;
+    }
+
+    // Inserts already serialized JSON as a value
+    JsonWriter& raw(std::string_view json, rapidjson::Type type = rapidjson::kObjectType)
+    {
+      _writer.RawValue(json.data(), json.size(), type);
+      return *this;
+    }
+
+    // True once a complete top level value has been written
+    bool isComplete() const { return _writer.IsComplete(); }
+
+    const std::string& str() const { return _stream.string(); }
+
+  private:
+    JsonStringStream _stream;
+    rapidjson::Writer<JsonStringStream> _writer;
+  };
+}
+
+#endif //MGUTILS_JSONWRITER_H
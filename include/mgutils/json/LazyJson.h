@@ -0,0 +1,147 @@
+#ifndef MGUTILS_LAZYJSON_H
+#define MGUTILS_LAZYJSON_H
+
+#include "rapidjson/document.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonView.h"
+
+namespace mgutils
+{
+  class LazyJson;
+
+  // Handle to a value of a LazyJson document, with the same getters as JsonValue.
+  // Numbers are decoded only when read, with the same rules as the DOM (getInt needs an int, etc).
+  // Handles are cheap to copy and valid as long as their LazyJson is alive.
+  class LazyValue
+  {
+  public:
+    bool hasBool(std::string_view key) const;
+    bool hasNumber(std::string_view key) const;
+    bool hasString(std::string_view key) const;
+    bool hasObject(std::string_view key) const;
+    bool hasArray(std::string_view key) const;
+    bool exists(std::string_view key) const { return member(key).has_value(); }
+
+    std::optional<std::string> getString(std::string_view key) const;
+    std::optional<int> getInt(std::string_view key) const;
+    std::optional<unsigned> getUint(std::string_view key) const;
+    std::optional<int64_t> getInt64(std::string_view key) const;
+    std::optional<uint64_t> getUint64(std::string_view key) const;
+    std::optional<bool> getBool(std::string_view key) const;
+    std::optional<float> getFloat(std::string_view key) const;
+    std::optional<double> getDouble(std::string_view key) const;
+
+    std::optional<std::string> asString() const;
+    std::optional<int> asInt() const;
+    std::optional<bool> asBool() const;
+    std::optional<float> asFloat() const;
+    std::optional<double> asDouble() const;
+    std::optional<unsigned> asUint() const;
+    std::optional<uint64_t> asUint64() const;
+
+    template <typename T>
+    std::optional<T> get(std::string_view key) const
+    {
+      if (auto index = member(key))
+        return LazyValue(*_json, *index).as<T>();
+      return std::nullopt;
+    }
+
+    template <typename T>
+    std::optional<T> as() const
+    {
+      rapidjson::Value value = scalar();
+      return JsonView(value).as<T>();
+    }
+
+    template <typename T>
+    T getOr(std::string_view key, T fallback) const
+    {
+      if (auto index = member(key)) {
+        rapidjson::Value value = LazyValue(*_json, *index).scalar();
+        json::read(value, fallback);
+      }
+      return fallback;
+    }
+
+    bool isNull() const;
+    bool isEmpty() const;
+
+    LazyValue getObject(std::string_view key) const;
+    std::vector<LazyValue> getArray(std::string_view key) const;
+    std::vector<LazyValue> getArray() const;
+
+    size_t size() const;
+
+    friend class LazyJson;
+
+  private:
+    LazyValue(const LazyJson& json, uint32_t index): _json(&json), _index(index) {}
+
+    // Tape index of the value stored under key
+    std::optional<uint32_t> member(std::string_view key) const;
+    // Scalars decoded into a rapidjson value (strings reference the document text); containers give null
+    rapidjson::Value scalar() const;
+
+    const LazyJson* _json;
+    uint32_t _index;
+  };
+
+  // On-demand JSON: parse() makes a single structural pass recording every token on a tape
+  // (offsets, lengths and subtree extents) and decodes nothing else. Lookups skip whole subtrees
+  // through the tape, and a value is converted only when a getter touches it, so reading a few
+  // fields of a large message costs far less than building a DOM.
+  //
+  // Structure, strings and number syntax are validated by the pass; strings with escapes are
+  // unescaped in place in the document's own copy of the text.
+  class LazyJson
+  {
+  public:
+    // Throws JsonParseException on malformed input
+    static std::shared_ptr<LazyJson> parse(std::string json);
+    static std::shared_ptr<LazyJson> parse(const char* json, size_t length);
+
+    LazyValue root() const { return LazyValue(*this, 0); }
+
+    size_t tokenCount() const { return _tape.size(); }
+
+    friend class LazyValue;
+
+  private:
+    enum class TokenType : uint8_t
+    {
+      Null,
+      False,
+      True,
+      Number,
+      String,
+      Object,
+      Array
+    };
+
+    struct Token
+    {
+      uint32_t begin;  // offset of the text (string contents exclude the quotes)
+      uint32_t length; // text length for scalars, number of members or elements for containers
+      uint32_t next;   // tape index just past this value and its children
+      TokenType type;
+    };
+
+    explicit LazyJson(std::string json);
+
+    void scan();
+    void scanString(size_t& pos);
+    void scanNumber(size_t& pos);
+    [[noreturn]] void fail(size_t pos, const std::string& reason) const;
+
+    std::string _text;
+    std::vector<Token> _tape;
+  };
+}
+
+#endif //MGUTILS_LAZYJSON_H
@@ -7,6 +7,8 @@
 
 #include <string>
 #include "Utils.h"
+#include "JsonStruct.h"
+#include "CsvStruct.h"
 
 namespace mgutils::models
 {
@@ -20,6 +22,9 @@ namespace mgutils::models
     int64_t time = INVALID_INT64;
   };
 
+  MG_JSON_STRUCT(Trade, source, symbol, price, amount, makerSide, time)
+  MG_CSV_STRUCT(Trade, source, symbol, price, amount, makerSide, time)
+
   enum Side
   {
     UNDEFINED = 'U',
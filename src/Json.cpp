@@ -1,11 +1,84 @@
 #include "Json.h"
 #include "JsonDocument.h"
 #include "Exceptions.h"
+#include "MappedFile.h"
 #include "rapidjson/filereadstream.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
 #include <cstdio>
 
 namespace mgutils
 {
+  namespace
+  {
+    // SAX filter between the reader and the document: strings found in (or added to) the pool are
+    // handed over as constant references instead of being copied into the document
+    template <typename Handler>
+    class InterningHandler
+    {
+    public:
+      typedef char Ch;
+
+      InterningHandler(Handler& handler, StringPool& pool): _handler(handler), _pool(pool) {}
+
+      bool Null() { return _handler.Null(); }
+      bool Bool(bool b) { return _handler.Bool(b); }
+      bool Int(int i) { return _handler.Int(i); }
+      bool Uint(unsigned u) { return _handler.Uint(u); }
+      bool Int64(int64_t i) { return _handler.Int64(i); }
+      bool Uint64(uint64_t u) { return _handler.Uint64(u); }
+      bool Double(double d) { return _handler.Double(d); }
+      bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { return _handler.RawNumber(str, length, copy); }
+      bool StartObject() { return _handler.StartObject(); }
+      bool EndObject(rapidjson::SizeType count) { return _handler.EndObject(count); }
+      bool StartArray() { return _handler.StartArray(); }
+      bool EndArray(rapidjson::SizeType count) { return _handler.EndArray(count); }
+
+      bool String(const Ch* str, rapidjson::SizeType length, bool copy)
+      {
+        if (auto pooled = _pool.intern(std::string_view(str, length)))
+          return _handler.String(pooled->data(), length, false);
+        return _handler.String(str, length, copy);
+      }
+
+      bool Key(const Ch* str, rapidjson::SizeType length, bool copy)
+      {
+        if (auto pooled = _pool.intern(std::string_view(str, length)))
+          return _handler.Key(pooled->data(), length, false);
+        return _handler.Key(str, length, copy);
+      }
+
+    private:
+      Handler& _handler;
+      StringPool& _pool;
+    };
+
+    // Generator for Document::Populate running the reader through the interning filter
+    class InterningParse
+    {
+    public:
+      InterningParse(const char* json, size_t length, StringPool& pool): _json(json), _length(length), _pool(pool) {}
+
+      template <typename Handler>
+      bool operator()(Handler& handler)
+      {
+        InterningHandler<Handler> filter(handler, _pool);
+        rapidjson::MemoryStream stream(_json, _length);
+        rapidjson::Reader reader;
+        _result = reader.Parse(stream, filter);
+        return !_result.IsError();
+      }
+
+      bool failed() const { return _result.IsError(); }
+
+    private:
+      const char* _json;
+      size_t _length;
+      StringPool& _pool;
+      rapidjson::ParseResult _result;
+    };
+  }
+
   std::shared_ptr<JsonDocument> Json::createDocument(JsonRootType type)
   {
     std::shared_ptr<JsonDocument> document(new JsonDocument());
@@ -28,17 +101,44 @@ namespace mgutils
   }
 
   std::shared_ptr<JsonDocument> Json::parse(const std::string& json)
+  {
+    return parse(json.data(), json.length());
+  }
+
+  std::shared_ptr<JsonDocument> Json::parse(const char* json, size_t length)
   {
     std::shared_ptr<JsonDocument> document(new JsonDocument());
-    document->_document.Parse(json.c_str(), json.length());
+    document->_document.Parse(json, length);
 
     if (document->_document.HasParseError()) {
-      throw JsonParseException("Failed to parse JSON content: " + json);
+      throw JsonParseException("Failed to parse JSON content: " + std::string(json, length));
     }
 
     return document;
   }
 
+  std::shared_ptr<JsonDocument> Json::parse(const std::string& json, const std::shared_ptr<StringPool>& pool)
+  {
+    return parse(json.data(), json.length(), pool);
+  }
+
+  std::shared_ptr<JsonDocument> Json::parse(const char* json, size_t length, const std::shared_ptr<StringPool>& pool)
+  {
+    if (!pool)
+      return parse(json, length);
+
+    std::shared_ptr<JsonDocument> document(new JsonDocument());
+    InterningParse generator(json, length, *pool);
+    document->_document.Populate(generator);
+
+    if (generator.failed()) {
+      throw JsonParseException("Failed to parse JSON content: " + std::string(json, length));
+    }
+
+    document->_source = pool;
+    return document;
+  }
+
   std::shared_ptr<JsonDocument> Json::parseFile(const std::string& filePath)
   {
     std::shared_ptr<JsonDocument> document(new JsonDocument());
@@ -60,6 +160,34 @@ namespace mgutils
     return document;
   }
 
+  std::shared_ptr<JsonDocument> Json::parseMappedFile(const std::string& filePath, const JsonMappedFileOptions& options)
+  {
+    std::shared_ptr<JsonDocument> document(new JsonDocument());
+
+    if (options.inSitu)
+    {
+      auto mapping = std::make_shared<MappedFile>(filePath, MappedFile::Mode::CopyOnWrite, true);
+      mapping->adviseSequential();
+      document->_document.ParseInsitu(mapping->data());
+      document->_source = mapping;
+    }
+    else
+    {
+      MappedFile mapping(filePath);
+      if (mapping.empty()) {
+        throw JsonParseException("Failed to parse JSON file: " + filePath);
+      }
+      mapping.adviseSequential();
+      document->_document.Parse(mapping.data(), mapping.size());
+    }
+
+    if (document->_document.HasParseError()) {
+      throw JsonParseException("Failed to parse JSON file: " + filePath);
+    }
+
+    return document;
+  }
+
   bool Json::save(const std::string& strJson, const std::string& file)
   {
     if(auto doc = parse(strJson))
@@ -0,0 +1,207 @@
+#include "CsvColumnCache.h"
+#include "Exceptions.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mgutils
+{
+  namespace csv
+  {
+    namespace
+    {
+      constexpr char MAGIC[8] = {'M', 'G', 'C', 'O', 'L', '\0', '\0', '\0'};
+      constexpr uint32_t VERSION = 1;
+      constexpr uint32_t ENDIAN_MARK = 0x01020304;
+      constexpr size_t ALIGNMENT = 64;
+
+      struct FileHeader
+      {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t sourceSize;
+        int64_t sourceMtimeNs;
+        uint64_t rowCount;
+        uint32_t columnCount;
+        char delimiter;
+        char quote;
+        uint8_t reserved[18];
+      };
+      static_assert(sizeof(FileHeader) == 64, "The sidecar header is one cache line");
+
+      // Followed by nameLength bytes of name
+      struct DirectoryEntry
+      {
+        uint64_t offset;
+        uint64_t bytes;
+        uint32_t nameLength;
+        uint8_t type;
+        uint8_t reserved[3];
+      };
+
+      size_t alignUp(size_t value)
+      {
+        return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+      }
+
+      void writeAll(int fd, const char* data, size_t count, const std::string& path)
+      {
+        while (count > 0)
+        {
+          ssize_t written = ::write(fd, data, count);
+          if (written < 0 && errno == EINTR)
+            continue;
+          if (written < 0)
+            throw CsvWriteException("Failed to write CSV column cache: " + path);
+          data += written;
+          count -= static_cast<size_t>(written);
+        }
+      }
+    }
+
+    CsvSourceStamp CsvSourceStamp::of(const std::string& path)
+    {
+      struct stat st{};
+      if (::stat(path.c_str(), &st) != 0)
+        throw FilesException("Failed to stat file: " + path);
+
+      CsvSourceStamp stamp;
+      stamp.size = static_cast<uint64_t>(st.st_size);
+#if defined(__APPLE__)
+      stamp.mtimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+      stamp.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+      return stamp;
+    }
+
+    std::unique_ptr<CsvColumnCache> CsvColumnCache::open(const std::string& source, const CsvSourceStamp& stamp,
+                                                         const CsvOptions& options)
+    {
+      // A missing sidecar is the normal first load, not an error worth reporting
+      const std::string path = sidecarPath(source);
+      struct stat st{};
+      if (::stat(path.c_str(), &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader))
+        return nullptr;
+
+      std::unique_ptr<CsvColumnCache> cache(new CsvColumnCache(path));
+      const char* data = cache->_file.data();
+      const size_t size = cache->_file.size();
+      if (size < sizeof(FileHeader))
+        return nullptr;
+
+      FileHeader header;
+      std::memcpy(&header, data, sizeof(header));
+      if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+          header.byteOrder != ENDIAN_MARK || header.sourceSize != stamp.size ||
+          header.sourceMtimeNs != stamp.mtimeNs || header.delimiter != options.delimiter ||
+          header.quote != options.quote)
+        return nullptr;
+
+      cache->_rowCount = header.rowCount;
+      size_t pos = sizeof(FileHeader);
+      for (uint32_t i = 0; i < header.columnCount; ++i)
+      {
+        DirectoryEntry entry;
+        if (pos + sizeof(entry) > size)
+          return nullptr;
+        std::memcpy(&entry, data + pos, sizeof(entry));
+        pos += sizeof(entry);
+
+        if (entry.nameLength > size - pos || entry.offset > size || entry.bytes > size - entry.offset)
+          return nullptr;
+        cache->_entries.push_back({std::string_view(data + pos, entry.nameLength), entry.type, entry.offset, entry.bytes});
+        pos += entry.nameLength;
+      }
+
+      cache->_file.adviseSequential();
+      return cache;
+    }
+
+    void CsvColumnCache::write(const std::string& source, const CsvSourceStamp& stamp, const CsvOptions& options,
+                               size_t rowCount, const std::vector<CsvColumnBlock>& columns)
+    {
+      FileHeader header{};
+      std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+      header.version = VERSION;
+      header.byteOrder = ENDIAN_MARK;
+      header.sourceSize = stamp.size;
+      header.sourceMtimeNs = stamp.mtimeNs;
+      header.rowCount = rowCount;
+      header.columnCount = static_cast<uint32_t>(columns.size());
+      header.delimiter = options.delimiter;
+      header.quote = options.quote;
+
+      // Header and directory first, then the blocks at aligned offsets
+      std::string directory(reinterpret_cast<const char*>(&header), sizeof(header));
+      size_t offset = sizeof(header);
+      for (const auto& column : columns)
+        offset += sizeof(DirectoryEntry) + column.name.size();
+
+      for (const auto& column : columns)
+      {
+        offset = alignUp(offset);
+        DirectoryEntry entry{};
+        entry.offset = offset;
+        entry.bytes = column.bytes().size();
+        entry.nameLength = static_cast<uint32_t>(column.name.size());
+        entry.type = column.type;
+        directory.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        directory.append(column.name);
+        offset += column.bytes().size();
+      }
+
+      const std::string path = sidecarPath(source);
+      const std::string temporary = path + ".tmp" + std::to_string(::getpid());
+      int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0)
+        throw CsvWriteException("Failed to create CSV column cache: " + temporary);
+
+      try {
+        static const char padding[ALIGNMENT] = {};
+        writeAll(fd, directory.data(), directory.size(), temporary);
+        size_t written = directory.size();
+        for (const auto& column : columns)
+        {
+          writeAll(fd, padding, alignUp(written) - written, temporary);
+          written = alignUp(written);
+          const std::string_view bytes = column.bytes();
+          writeAll(fd, bytes.data(), bytes.size(), temporary);
+          written += bytes.size();
+        }
+      } catch (...) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw;
+      }
+
+      if (::close(fd) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        throw CsvWriteException("Failed to write CSV column cache: " + path);
+      }
+    }
+
+    std::vector<CsvColumnBlock> CsvColumnCache::blocks() const
+    {
+      std::vector<CsvColumnBlock> blocks;
+      for (const auto& entry : _entries)
+        blocks.push_back({std::string(entry.name), entry.type, std::string_view(_file.data() + entry.offset, entry.bytes), {}});
+      return blocks;
+    }
+
+    const char* CsvColumnCache::find(std::string_view name, uint8_t type, size_t& bytes) const
+    {
+      for (const auto& entry : _entries)
+      {
+        if (entry.name == name && entry.type == type) {
+          bytes = entry.bytes;
+          return _file.data() + entry.offset;
+        }
+      }
+      return nullptr;
+    }
+  }
+}
@@ -0,0 +1,88 @@
+#include "CsvParallel.h"
+#include <cstdint>
+
+namespace mgutils
+{
+  namespace csv
+  {
+    namespace
+    {
+      // What a range would contribute under each hypothesis about its starting quote state
+      struct RangeScan
+      {
+        bool oddQuotes = false;
+        // First record start after a newline outside quotes, for a range starting outside / inside quotes
+        size_t recordStart[2] = {SIZE_MAX, SIZE_MAX};
+      };
+
+      RangeScan scanRange(const CsvScanner& scanner, const char* data, size_t begin, size_t end)
+      {
+        constexpr size_t BATCH = 64;
+        CsvBlockMasks masks[BATCH];
+        RangeScan scan;
+        uint64_t carry = 0; // relative to the starting state
+
+        size_t base = begin;
+        while (base < end)
+        {
+          const size_t blocks = scanner.classify(data + base, end - base, masks, BATCH);
+          for (size_t b = 0; b < blocks; ++b, base += CsvScanner::BLOCK_SIZE)
+          {
+            const uint64_t quoted = prefixXor(masks[b].quote) ^ carry;
+            carry = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+
+            // A newline is outside quotes under the hypothesis that equals its relative state
+            const uint64_t outside[2] = {masks[b].newline & ~quoted, masks[b].newline & quoted};
+            for (int hypothesis = 0; hypothesis < 2; ++hypothesis)
+            {
+              if (scan.recordStart[hypothesis] == SIZE_MAX && outside[hypothesis])
+                scan.recordStart[hypothesis] = base + lowestBit(outside[hypothesis]) + 1;
+            }
+          }
+        }
+        scan.oddQuotes = carry != 0;
+        return scan;
+      }
+    }
+
+    std::vector<CsvChunk> splitRecords(const char* data, size_t begin, size_t end, size_t count, char quote,
+                                       JobPool& pool)
+    {
+      if (count <= 1 || end - begin < count)
+        return {CsvChunk{begin, end}};
+
+      // Pass 1: nominal ranges scanned concurrently
+      const size_t step = (end - begin) / count;
+      std::vector<RangeScan> scans(count);
+      CsvOptions options;
+      options.quote = quote;
+      const CsvScanner scanner(options);
+      for (size_t i = 0; i < count; ++i)
+      {
+        const size_t from = begin + i * step;
+        const size_t to = i + 1 == count ? end : from + step;
+        pool.addJob([&scans, &scanner, data, from, to, i]() { scans[i] = scanRange(scanner, data, from, to); });
+      }
+      pool.wait();
+
+      // Pass 2: the file starts outside quotes, so each range's state is the parity of the ones before it
+      std::vector<CsvChunk> chunks;
+      size_t chunkBegin = begin;
+      bool inQuotes = false;
+      for (size_t i = 0; i < count; ++i)
+      {
+        if (i > 0) {
+          const size_t start = scans[i].recordStart[inQuotes ? 1 : 0];
+          // A range without a record start joins the chunk before it
+          if (start != SIZE_MAX && start > chunkBegin && start < end) {
+            chunks.push_back({chunkBegin, start});
+            chunkBegin = start;
+          }
+        }
+        inQuotes ^= scans[i].oddQuotes;
+      }
+      chunks.push_back({chunkBegin, end});
+      return chunks;
+    }
+  }
+}
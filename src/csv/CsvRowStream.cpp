@@ -0,0 +1,131 @@
+#include "CsvRowStream.h"
+#include "Exceptions.h"
+#include <cstring>
+
+namespace mgutils
+{
+  CsvRowStream::CsvRowStream(const std::string& filename, const CsvOptions& options, size_t blockSize):
+      _source(csv::CsvByteSource::open(filename, blockSize)),
+      _buffer(blockSize > 0 ? blockSize : DEFAULT_BLOCK_SIZE),
+      _tokenizer(options)
+  {
+    if (options.hasHeader && nextRecord()) {
+      for (size_t i = 0; i < _row.size(); ++i)
+        _columnNames.emplace_back(_row[i]);
+      _row = CsvRow();
+    }
+  }
+
+  CsvRowStream::~CsvRowStream()
+  {
+    close();
+  }
+
+  CsvRowStream::CsvRowStream(CsvRowStream&& other) noexcept:
+      _source(std::move(other._source)),
+      _eof(other._eof),
+      _buffer(std::move(other._buffer)),
+      _begin(other._begin),
+      _end(other._end),
+      _tokenizer(std::move(other._tokenizer)),
+      _fields(std::move(other._fields)),
+      _columnNames(std::move(other._columnNames)),
+      _row(other._row),
+      _rowCount(other._rowCount)
+  {
+    other._row = CsvRow();
+  }
+
+  CsvRowStream& CsvRowStream::operator=(CsvRowStream&& other) noexcept
+  {
+    if (this != &other) {
+      close();
+      _source = std::move(other._source);
+      _eof = other._eof;
+      _buffer = std::move(other._buffer);
+      _begin = other._begin;
+      _end = other._end;
+      _tokenizer = std::move(other._tokenizer);
+      _fields = std::move(other._fields);
+      _columnNames = std::move(other._columnNames);
+      _row = other._row;
+      _rowCount = other._rowCount;
+      other._row = CsvRow();
+    }
+    return *this;
+  }
+
+  void CsvRowStream::close()
+  {
+    _source.reset();
+  }
+
+  size_t CsvRowStream::columnIndex(std::string_view columnName) const
+  {
+    for (size_t i = 0; i < _columnNames.size(); ++i)
+    {
+      if (_columnNames[i] == columnName)
+        return i;
+    }
+    throw CsvUsageException("CSV column not found: " + std::string(columnName));
+  }
+
+  bool CsvRowStream::next()
+  {
+    if (!nextRecord())
+      return false;
+    ++_rowCount;
+    return true;
+  }
+
+  bool CsvRowStream::nextRecord()
+  {
+    while (true)
+    {
+      const size_t consumed = _tokenizer.next(_buffer.data() + _begin, _end - _begin, _eof, _fields);
+      if (consumed == 0) {
+        if (_eof || !refill()) {
+          _row = CsvRow();
+          return false;
+        }
+        continue;
+      }
+
+      const size_t start = _begin;
+      _begin += consumed;
+      if (_fields.empty())
+        continue;
+
+      _row = CsvRow(_buffer.data() + start, _fields.data(), _fields.size());
+      return true;
+    }
+  }
+
+  bool CsvRowStream::refill()
+  {
+    if (!_source) {
+      _eof = true;
+      return _begin < _end;
+    }
+
+    // Slide the partial record to the front; grow only when it already fills the whole block
+    const size_t pending = _end - _begin;
+    if (_begin > 0) {
+      std::memmove(_buffer.data(), _buffer.data() + _begin, pending);
+      _begin = 0;
+      _end = pending;
+    }
+    if (_end == _buffer.size())
+      _buffer.resize(_buffer.size() * 2);
+
+    const size_t count = _source->read(_buffer.data() + _end, _buffer.size() - _end);
+    if (count == 0) {
+      // Tokenize what is left once more, now allowing a record without a final newline
+      _eof = true;
+      close();
+      return pending > 0;
+    }
+    _end += count;
+    return true;
+  }
+}
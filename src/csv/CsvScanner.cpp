@@ -0,0 +1,191 @@
+#include "CsvScanner.h"
+#include "Exceptions.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MGUTILS_CSV_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace mgutils
+{
+  namespace csv
+  {
+    namespace
+    {
+      // One bit per byte of word equal to the byte repeated in pattern, byte 0 in bit 0. The 0x80 of
+      // each zero byte of word ^ pattern is found without carries between bytes, then the eight flags
+      // are gathered into the top byte by one multiplication.
+      inline uint64_t matchWord(uint64_t word, uint64_t pattern)
+      {
+        constexpr uint64_t LOW7 = 0x7F7F7F7F7F7F7F7FULL;
+        const uint64_t x = word ^ pattern;
+        const uint64_t zeros = ~(((x & LOW7) + LOW7) | x | LOW7);
+        return ((zeros >> 7) * 0x0102040810204080ULL) >> 56;
+      }
+
+      // Eight bytes per step in a general purpose register, for CPUs without the vector kernels
+      void classifyScalar(const char* data, size_t blocks, char delimiter, char quote, CsvBlockMasks* out)
+      {
+        constexpr uint64_t ONES = 0x0101010101010101ULL;
+        const uint64_t delimiters = ONES * static_cast<unsigned char>(delimiter);
+        const uint64_t quotes = ONES * static_cast<unsigned char>(quote);
+        const uint64_t newlines = ONES * static_cast<unsigned char>('\n');
+
+        for (size_t b = 0; b < blocks; ++b, data += CsvScanner::BLOCK_SIZE)
+        {
+          CsvBlockMasks masks{0, 0, 0};
+          for (unsigned i = 0; i < CsvScanner::BLOCK_SIZE; i += 8)
+          {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            for (unsigned k = 0; k < 8; ++k)
+            {
+              const char c = data[i + k];
+              masks.delimiter |= static_cast<uint64_t>(c == delimiter) << (i + k);
+              masks.quote |= static_cast<uint64_t>(c == quote) << (i + k);
+              masks.newline |= static_cast<uint64_t>(c == '\n') << (i + k);
+            }
+#else
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            masks.delimiter |= matchWord(word, delimiters) << i;
+            masks.quote |= matchWord(word, quotes) << i;
+            masks.newline |= matchWord(word, newlines) << i;
+#endif
+          }
+          out[b] = masks;
+        }
+      }
+
+#ifdef MGUTILS_CSV_X86_KERNELS
+      // Four 16 byte compares per character and block
+      __attribute__((target("sse4.2"))) void classifySse42(const char* data, size_t blocks, char delimiter,
+                                                             char quote, CsvBlockMasks* out)
+      {
+        const __m128i delimiters = _mm_set1_epi8(delimiter);
+        const __m128i quotes = _mm_set1_epi8(quote);
+        const __m128i newlines = _mm_set1_epi8('\n');
+
+        for (size_t b = 0; b < blocks; ++b, data += CsvScanner::BLOCK_SIZE)
+        {
+          CsvBlockMasks masks{0, 0, 0};
+          for (unsigned i = 0; i < 4; ++i)
+          {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+            const unsigned shift = i * 16;
+            masks.delimiter |= static_cast<uint64_t>(static_cast<uint16_t>(
+                                   _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, delimiters))))
+                               << shift;
+            masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(
+                               _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quotes))))
+                           << shift;
+            masks.newline |= static_cast<uint64_t>(static_cast<uint16_t>(
+                                 _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newlines))))
+                             << shift;
+          }
+          out[b] = masks;
+        }
+      }
+
+      __attribute__((target("avx2"))) inline uint64_t matchAvx2(__m256i low, __m256i high, __m256i match)
+      {
+        const uint32_t lowBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, match)));
+        const uint32_t highBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, match)));
+        return static_cast<uint64_t>(lowBits) | static_cast<uint64_t>(highBits) << 32;
+      }
+
+      // Two 32 byte compares per character and block
+      __attribute__((target("avx2"))) void classifyAvx2(const char* data, size_t blocks, char delimiter, char quote,
+                                                         CsvBlockMasks* out)
+      {
+        const __m256i delimiters = _mm256_set1_epi8(delimiter);
+        const __m256i quotes = _mm256_set1_epi8(quote);
+        const __m256i newlines = _mm256_set1_epi8('\n');
+
+        for (size_t b = 0; b < blocks; ++b, data += CsvScanner::BLOCK_SIZE)
+        {
+          const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+          const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+          out[b] = {matchAvx2(low, high, delimiters), matchAvx2(low, high, quotes), matchAvx2(low, high, newlines)};
+        }
+      }
+#endif
+    }
+
+    CsvScanKernel bestScanKernel()
+    {
+#ifdef MGUTILS_CSV_X86_KERNELS
+      static const CsvScanKernel best = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+          return CsvScanKernel::Avx2;
+        if (__builtin_cpu_supports("sse4.2"))
+          return CsvScanKernel::Sse42;
+        return CsvScanKernel::Scalar;
+      }();
+      return best;
+#else
+      return CsvScanKernel::Scalar;
+#endif
+    }
+
+    bool scanKernelSupported(CsvScanKernel kernel)
+    {
+      switch (kernel)
+      {
+        case CsvScanKernel::Scalar:
+          return true;
+        case CsvScanKernel::Sse42:
+          return bestScanKernel() != CsvScanKernel::Scalar;
+        case CsvScanKernel::Avx2:
+          return bestScanKernel() == CsvScanKernel::Avx2;
+      }
+      return false;
+    }
+
+    const char* scanKernelName(CsvScanKernel kernel)
+    {
+      switch (kernel)
+      {
+        case CsvScanKernel::Scalar:
+          return "scalar";
+        case CsvScanKernel::Sse42:
+          return "sse4.2";
+        case CsvScanKernel::Avx2:
+          return "avx2";
+      }
+      return "unknown";
+    }
+
+    CsvScanner::CsvScanner(const CsvOptions& options, CsvScanKernel kernel):
+        _options(options),
+        _delimiter(options.delimiter),
+        _quote(options.quote),
+        _kernel(kernel),
+        _classify(classifyScalar)
+    {
+      if (!scanKernelSupported(kernel))
+        throw CsvUsageException(std::string("CSV scan kernel not supported by this CPU: ") + scanKernelName(kernel));
+
+#ifdef MGUTILS_CSV_X86_KERNELS
+      if (kernel == CsvScanKernel::Avx2)
+        _classify = classifyAvx2;
+      else if (kernel == CsvScanKernel::Sse42)
+        _classify = classifySse42;
+#endif
+    }
+
+    size_t CsvScanner::classify(const char* data, size_t size, CsvBlockMasks* out, size_t maxBlocks) const
+    {
+      const size_t whole = std::min(maxBlocks, size / BLOCK_SIZE);
+      _classify(data, whole, _delimiter, _quote, out);
+      if (whole == maxBlocks || whole * BLOCK_SIZE == size)
+        return whole;
+
+      // The tail is copied so the kernels never read past the end of the buffer
+      char tail[BLOCK_SIZE] = {};
+      std::memcpy(tail, data + whole * BLOCK_SIZE, size - whole * BLOCK_SIZE);
+      _classify(tail, 1, _delimiter, _quote, out + whole);
+      return whole + 1;
+    }
+  }
+}
@@ -0,0 +1,385 @@
+#include "CsvSource.h"
+#include "Exceptions.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+#ifdef MGUTILS_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef MGUTILS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace mgutils
+{
+  namespace csv
+  {
+    namespace
+    {
+      // File descriptor read front to back
+      class FileReader
+      {
+      public:
+        explicit FileReader(const std::string& path):
+            _path(path)
+        {
+          _fd = ::open(path.c_str(), O_RDONLY);
+          if (_fd < 0)
+            throw FilesException("Failed to open file: " + path);
+#if defined(POSIX_FADV_SEQUENTIAL)
+          ::posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        }
+
+        ~FileReader() { ::close(_fd); }
+
+        FileReader(const FileReader&) = delete;
+        FileReader& operator=(const FileReader&) = delete;
+
+        const std::string& path() const { return _path; }
+
+        size_t read(char* out, size_t size)
+        {
+          while (true)
+          {
+            ssize_t count = ::read(_fd, out, size);
+            if (count < 0 && errno == EINTR)
+              continue;
+            if (count < 0)
+              throw FilesException("Failed to read file: " + _path + " (" + std::strerror(errno) + ")");
+            return static_cast<size_t>(count);
+          }
+        }
+
+      private:
+        std::string _path;
+        int _fd = -1;
+      };
+
+      class PlainSource : public CsvByteSource
+      {
+      public:
+        explicit PlainSource(const std::string& path): _file(path) {}
+
+        size_t read(char* out, size_t size) override { return _file.read(out, size); }
+
+      private:
+        FileReader _file;
+      };
+
+      // Compressed bytes from a file in, plain bytes out; runs on the pipeline thread
+      class Decoder
+      {
+      public:
+        virtual ~Decoder() = default;
+
+        // Fills out with at least one byte, reading compressed input from file as needed; 0 at the end
+        virtual size_t decode(FileReader& file, char* out, size_t size) = 0;
+      };
+
+#ifdef MGUTILS_WITH_ZLIB
+      class GzipDecoder : public Decoder
+      {
+      public:
+        GzipDecoder():
+            _input(INPUT_SIZE)
+        {
+          std::memset(&_stream, 0, sizeof(_stream));
+          // 15 + 32: largest window, gzip or zlib header detected from the data
+          if (inflateInit2(&_stream, 15 + 32) != Z_OK)
+            throw CsvReadException("Failed to initialize gzip decompression");
+        }
+
+        ~GzipDecoder() override { inflateEnd(&_stream); }
+
+        size_t decode(FileReader& file, char* out, size_t size) override
+        {
+          _stream.next_out = reinterpret_cast<Bytef*>(out);
+          _stream.avail_out = static_cast<uInt>(std::min<size_t>(size, UINT32_MAX));
+          const uInt available = _stream.avail_out;
+
+          while (_stream.avail_out == available)
+          {
+            if (_stream.avail_in == 0 && !_inputDone) {
+              const size_t count = file.read(_input.data(), _input.size());
+              _inputDone = count == 0;
+              _stream.next_in = reinterpret_cast<Bytef*>(_input.data());
+              _stream.avail_in = static_cast<uInt>(count);
+            }
+            if (_stream.avail_in == 0 && _inputDone && !_memberOpen)
+              break;
+
+            const int result = inflate(&_stream, Z_NO_FLUSH);
+            if (result == Z_STREAM_END) {
+              // Concatenated members, as appending to a .gz produces, continue the same text
+              _memberOpen = false;
+              inflateReset(&_stream);
+              continue;
+            }
+            if (result == Z_BUF_ERROR && _stream.avail_in == 0 && _inputDone)
+              throw CsvReadException("Truncated gzip file: " + file.path());
+            if (result != Z_OK && result != Z_BUF_ERROR)
+              throw CsvReadException("Corrupt gzip file: " + file.path() + " (" +
+                                     (_stream.msg ? _stream.msg : "inflate failed") + ")");
+            _memberOpen = true;
+          }
+          return available - _stream.avail_out;
+        }
+
+      private:
+        static constexpr size_t INPUT_SIZE = 256 * 1024;
+
+        z_stream _stream;
+        std::vector<char> _input;
+        bool _inputDone = false;
+        bool _memberOpen = false;
+      };
+#endif
+
+#ifdef MGUTILS_WITH_ZSTD
+      class ZstdDecoder : public Decoder
+      {
+      public:
+        ZstdDecoder():
+            _stream(ZSTD_createDStream()),
+            _input(ZSTD_DStreamInSize())
+        {
+          if (!_stream || ZSTD_isError(ZSTD_initDStream(_stream))) {
+            ZSTD_freeDStream(_stream);
+            throw CsvReadException("Failed to initialize zstd decompression");
+          }
+        }
+
+        ~ZstdDecoder() override { ZSTD_freeDStream(_stream); }
+
+        size_t decode(FileReader& file, char* out, size_t size) override
+        {
+          ZSTD_outBuffer output{out, size, 0};
+          while (output.pos == 0)
+          {
+            if (_in.pos == _in.size && !_inputDone) {
+              const size_t count = file.read(_input.data(), _input.size());
+              _inputDone = count == 0;
+              _in = ZSTD_inBuffer{_input.data(), count, 0};
+            }
+            if (_in.pos == _in.size && _inputDone && !_frameOpen)
+              break;
+
+            // Frames follow each other in the same stream; 0 means the last one is complete
+            const size_t result = ZSTD_decompressStream(_stream, &output, &_in);
+            if (ZSTD_isError(result))
+              throw CsvReadException("Corrupt zstd file: " + file.path() + " (" + ZSTD_getErrorName(result) + ")");
+            _frameOpen = result != 0;
+            if (output.pos == 0 && _frameOpen && _in.pos == _in.size && _inputDone)
+              throw CsvReadException("Truncated zstd file: " + file.path());
+          }
+          return output.pos;
+        }
+
+      private:
+        ZSTD_DStream* _stream;
+        std::vector<char> _input;
+        ZSTD_inBuffer _in{nullptr, 0, 0};
+        bool _inputDone = false;
+        bool _frameOpen = false;
+      };
+#endif
+
+      // Decodes on its own thread into a bounded queue of chunks, which read() drains
+      class PipelineSource : public CsvByteSource
+      {
+      public:
+        PipelineSource(const std::string& path, std::unique_ptr<Decoder> decoder, size_t chunkSize):
+            _file(path),
+            _decoder(std::move(decoder)),
+            _chunkSize(chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE)
+        {
+          _thread = std::thread(&PipelineSource::run, this);
+        }
+
+        ~PipelineSource() override
+        {
+          {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+          }
+          _condition.notify_all();
+          _thread.join();
+        }
+
+        size_t read(char* out, size_t size) override
+        {
+          if (_offset == _current.size() && !nextChunk())
+            return 0;
+          const size_t count = std::min(size, _current.size() - _offset);
+          std::memcpy(out, _current.data() + _offset, count);
+          _offset += count;
+          return count;
+        }
+
+      private:
+        // Chunks decoded ahead of the reader
+        static constexpr size_t QUEUE_DEPTH = 4;
+
+        bool nextChunk()
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          if (_current.capacity() > 0)
+            _free.push_back(std::move(_current));
+          _current.clear();
+          _offset = 0;
+
+          _condition.wait(lock, [this] { return !_ready.empty() || _finished; });
+          if (_ready.empty()) {
+            if (_error)
+              std::rethrow_exception(std::exchange(_error, nullptr));
+            return false;
+          }
+          _current = std::move(_ready.front());
+          _ready.pop_front();
+          lock.unlock();
+          _condition.notify_all();
+          return true;
+        }
+
+        void run()
+        {
+          try {
+            while (true)
+            {
+              std::vector<char> chunk;
+              {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this] { return _ready.size() < QUEUE_DEPTH || _stopping; });
+                if (_stopping)
+                  return;
+                if (!_free.empty()) {
+                  chunk = std::move(_free.back());
+                  _free.pop_back();
+                }
+              }
+
+              chunk.resize(_chunkSize);
+              size_t filled = 0;
+              while (filled < chunk.size())
+              {
+                const size_t count = _decoder->decode(_file, chunk.data() + filled, chunk.size() - filled);
+                if (count == 0)
+                  break;
+                filled += count;
+              }
+              chunk.resize(filled);
+
+              const bool last = filled < _chunkSize;
+              {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (filled > 0)
+                  _ready.push_back(std::move(chunk));
+                _finished = last;
+              }
+              _condition.notify_all();
+              if (last)
+                return;
+            }
+          } catch (...) {
+            {
+              std::lock_guard<std::mutex> lock(_mutex);
+              _error = std::current_exception();
+              _finished = true;
+            }
+            _condition.notify_all();
+          }
+        }
+
+        FileReader _file;
+        std::unique_ptr<Decoder> _decoder;
+        size_t _chunkSize;
+
+        // Reader side
+        std::vector<char> _current;
+        size_t _offset = 0;
+
+        // Shared under _mutex
+        std::deque<std::vector<char>> _ready;
+        std::vector<std::vector<char>> _free;
+        bool _finished = false;
+        bool _stopping = false;
+        std::exception_ptr _error;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::thread _thread;
+      };
+    }
+
+    CsvCompression detectCompression(const std::string& path)
+    {
+      FileReader file(path);
+      unsigned char magic[4] = {};
+      size_t count = 0;
+      while (count < sizeof(magic))
+      {
+        const size_t read = file.read(reinterpret_cast<char*>(magic) + count, sizeof(magic) - count);
+        if (read == 0)
+          break;
+        count += read;
+      }
+
+      if (count >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        return CsvCompression::Gzip;
+      if (count == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        return CsvCompression::Zstd;
+      return CsvCompression::None;
+    }
+
+    std::unique_ptr<CsvByteSource> CsvByteSource::open(const std::string& path, [[maybe_unused]] size_t chunkSize)
+    {
+      switch (detectCompression(path))
+      {
+        case CsvCompression::Gzip:
+#ifdef MGUTILS_WITH_ZLIB
+          return std::make_unique<PipelineSource>(path, std::make_unique<GzipDecoder>(), chunkSize);
+#else
+          throw CsvReadException("Reading gzip compressed CSV needs mgutils built with MGUTILS_WITH_ZLIB: " + path);
+#endif
+        case CsvCompression::Zstd:
+#ifdef MGUTILS_WITH_ZSTD
+          return std::make_unique<PipelineSource>(path, std::make_unique<ZstdDecoder>(), chunkSize);
+#else
+          throw CsvReadException("Reading zstd compressed CSV needs mgutils built with MGUTILS_WITH_ZSTD: " + path);
+#endif
+        case CsvCompression::None:
+          break;
+      }
+      return std::make_unique<PlainSource>(path);
+    }
+
+    std::vector<char> readAll(const std::string& path)
+    {
+      auto source = CsvByteSource::open(path);
+      std::vector<char> text(CsvByteSource::DEFAULT_CHUNK_SIZE);
+      size_t size = 0;
+      while (true)
+      {
+        if (size == text.size())
+          text.resize(text.size() * 2);
+        const size_t count = source->read(text.data() + size, text.size() - size);
+        if (count == 0)
+          break;
+        size += count;
+      }
+      text.resize(size);
+      return text;
+    }
+  }
+}
@@ -0,0 +1,267 @@
+#include "CsvTimeIndex.h"
+#include "CsvScanner.h"
+#include "CsvSource.h"
+#include "Exceptions.h"
+#include "MappedFile.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mgutils
+{
+  namespace
+  {
+    constexpr char MAGIC[8] = {'M', 'G', 'I', 'D', 'X', '\0', '\0', '\0'};
+    constexpr uint32_t VERSION = 1;
+    constexpr uint32_t ENDIAN_MARK = 0x01020304;
+
+    // Followed by the column name, the time format and entryCount entries
+    struct FileHeader
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t byteOrder;
+      uint64_t sourceSize;
+      int64_t sourceMtimeNs;
+      uint64_t rowCount;
+      uint64_t stride;
+      uint64_t entryCount;
+      uint32_t column;
+      uint16_t columnNameLength;
+      uint16_t formatLength;
+      char delimiter;
+      char quote;
+      uint8_t reserved[6];
+    };
+    static_assert(sizeof(FileHeader) == 72, "Unexpected time index header layout");
+
+    // Offset just past the header record, which stays with the caller
+    size_t skipHeader(char* data, size_t size, const CsvOptions& options, std::vector<std::string_view>& header)
+    {
+      csv::CsvTokenizer tokenizer(options);
+      std::vector<csv::CsvField> fields;
+      size_t pos = 0;
+      while (pos < size && header.empty())
+      {
+        const size_t start = pos;
+        pos += tokenizer.next(data + pos, size - pos, true, fields);
+        for (const auto& field : fields)
+          header.emplace_back(data + start + field.begin, field.end - field.begin);
+      }
+      return pos;
+    }
+  }
+
+  CsvTimeIndex CsvTimeIndex::build(const std::string& path, const std::string& timeColumn, size_t everyNRows,
+                                   const std::string& timeFormat, const CsvOptions& options)
+  {
+    if (everyNRows == 0)
+      throw CsvUsageException("CSV time index stride must be positive");
+    if (!options.hasHeader)
+      throw CsvUsageException("Indexing a CSV time column by name needs a header row");
+    if (csv::detectCompression(path) != csv::CsvCompression::None)
+      throw CsvUsageException("CSV time index needs an uncompressed file: " + path);
+
+    CsvTimeIndex index;
+    index._path = path;
+    index._timeColumn = timeColumn;
+    index._timeFormat = timeFormat;
+    index._options = options;
+    index._stride = everyNRows;
+    // Taken before scanning, so a file that changes meanwhile leaves a sidecar that no longer matches
+    index._stamp = csv::CsvSourceStamp::of(path);
+
+    MappedFile file(path, MappedFile::Mode::CopyOnWrite);
+    file.adviseSequential();
+    char* data = file.data();
+    const size_t size = file.size();
+
+    std::vector<std::string_view> header;
+    const size_t begin = skipHeader(data, size, options, header);
+    auto it = std::find(header.begin(), header.end(), timeColumn);
+    if (it == header.end())
+      throw CsvUsageException("CSV column not found: " + timeColumn);
+    index._column = static_cast<size_t>(it - header.begin());
+
+    size_t row = 0;
+    csv::CsvScanner(options).forEachRecord(data, begin, size, [&](size_t start, const csv::CsvField* fields, size_t count) {
+      if (row++ % everyNRows != 0)
+        return;
+      const CsvRow record(data + start, fields, count);
+      const int64_t time = index.parseTime(record.at(index._column));
+      if (!index._entries.empty() && time < index._entries.back().time)
+        throw CsvUsageException("CSV file is not sorted by " + timeColumn + " at row " + std::to_string(row - 1) +
+                                ": " + path);
+      index._entries.push_back({time, static_cast<uint64_t>(start)});
+    });
+    index._rowCount = row;
+
+    try {
+      index.write();
+    } catch (const CsvWriteException&) {
+      // The index is built; a sidecar that cannot be written only costs the next load a scan
+    }
+    return index;
+  }
+
+  CsvTimeIndex CsvTimeIndex::load(const std::string& path, const CsvOptions& options)
+  {
+    const std::string sidecar = sidecarPath(path);
+    struct stat st{};
+    if (::stat(sidecar.c_str(), &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader))
+      throw CsvUsageException("CSV file has no time index, build one with CsvTimeIndex::build: " + path);
+
+    MappedFile file(sidecar);
+    const char* data = file.data();
+    const size_t size = file.size();
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.byteOrder != ENDIAN_MARK ||
+        sizeof(FileHeader) + header.columnNameLength + header.formatLength > size)
+      throw CsvUsageException("Unreadable CSV time index, rebuild it with CsvTimeIndex::build: " + sidecar);
+
+    const char* text = data + sizeof(FileHeader);
+    const std::string timeColumn(text, header.columnNameLength);
+    const std::string timeFormat(text + header.columnNameLength, header.formatLength);
+
+    const size_t entriesAt = sizeof(FileHeader) + header.columnNameLength + header.formatLength;
+    const csv::CsvSourceStamp stamp = csv::CsvSourceStamp::of(path);
+    if (header.sourceSize != stamp.size || header.sourceMtimeNs != stamp.mtimeNs ||
+        header.delimiter != options.delimiter || header.quote != options.quote ||
+        header.entryCount > (size - entriesAt) / sizeof(Entry))
+      return build(path, timeColumn, header.stride, timeFormat, options);
+
+    CsvTimeIndex index;
+    index._path = path;
+    index._timeColumn = timeColumn;
+    index._timeFormat = timeFormat;
+    index._options = options;
+    index._stamp = stamp;
+    index._stride = header.stride;
+    index._column = header.column;
+    index._rowCount = header.rowCount;
+    index._entries.resize(header.entryCount);
+    if (header.entryCount > 0)
+      std::memcpy(index._entries.data(), data + entriesAt, header.entryCount * sizeof(Entry));
+    return index;
+  }
+
+  size_t CsvTimeIndex::seek(int64_t time) const
+  {
+    // Records equal to time may come before the first indexed one that is
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), time,
+                               [](const Entry& entry, int64_t value) { return entry.time < value; });
+    return it == _entries.begin() ? 0 : static_cast<size_t>(it - _entries.begin()) - 1;
+  }
+
+  int64_t CsvTimeIndex::parseTime(std::string_view text) const
+  {
+    if (_timeFormat.empty()) {
+      int64_t time = 0;
+      if (!csv::parse(text, time))
+        throw CsvUsageException("Failed to convert CSV time '" + std::string(text) + "' in column " + _timeColumn);
+      return time;
+    }
+
+    try {
+      return parseDateTimeWithFormat(std::string(text), _timeFormat);
+    } catch (const std::exception& e) {
+      throw CsvUsageException("Failed to convert CSV time '" + std::string(text) + "' in column " + _timeColumn +
+                              " with format " + _timeFormat + " (" + e.what() + ")");
+    }
+  }
+
+  size_t CsvTimeIndex::readRange(int64_t fromTime, int64_t toTime,
+                                 const std::function<void(const CsvRow&)>& onRow) const
+  {
+    if (!(csv::CsvSourceStamp::of(_path) == _stamp))
+      throw CsvUsageException("CSV file changed since it was indexed: " + _path);
+    if (_entries.empty() || fromTime >= toTime)
+      return 0;
+
+    MappedFile file(_path, MappedFile::Mode::CopyOnWrite);
+    char* data = file.data();
+    const size_t size = file.size();
+    const csv::CsvScanner scanner(_options);
+
+    // Indexed offsets are record starts, so the file is parsed one stride at a time and the scan
+    // stops after the stride holding the first record past the range
+    size_t count = 0;
+    bool done = false;
+    for (size_t i = seek(fromTime); i < _entries.size() && !done; ++i)
+    {
+      const size_t end = i + 1 < _entries.size() ? _entries[i + 1].offset : size;
+      scanner.forEachRecord(data, _entries[i].offset, end, [&](size_t start, const csv::CsvField* fields, size_t fieldCount) {
+        if (done)
+          return;
+        const CsvRow row(data + start, fields, fieldCount);
+        const int64_t time = parseTime(row.at(_column));
+        if (time >= toTime) {
+          done = true;
+        } else if (time >= fromTime) {
+          onRow(row);
+          ++count;
+        }
+      });
+    }
+    return count;
+  }
+
+  void CsvTimeIndex::write() const
+  {
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = ENDIAN_MARK;
+    header.sourceSize = _stamp.size;
+    header.sourceMtimeNs = _stamp.mtimeNs;
+    header.rowCount = _rowCount;
+    header.stride = _stride;
+    header.entryCount = _entries.size();
+    header.column = static_cast<uint32_t>(_column);
+    header.columnNameLength = static_cast<uint16_t>(_timeColumn.size());
+    header.formatLength = static_cast<uint16_t>(_timeFormat.size());
+    header.delimiter = _options.delimiter;
+    header.quote = _options.quote;
+
+    std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes.append(_timeColumn, 0, header.columnNameLength);
+    bytes.append(_timeFormat, 0, header.formatLength);
+    bytes.append(reinterpret_cast<const char*>(_entries.data()), _entries.size() * sizeof(Entry));
+
+    // Through a temporary file renamed over the old one, so readers never see half an index
+    const std::string path = sidecarPath(_path);
+    const std::string temporary = path + ".tmp" + std::to_string(::getpid());
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw CsvWriteException("Failed to create CSV time index: " + temporary);
+
+    const char* out = bytes.data();
+    size_t remaining = bytes.size();
+    while (remaining > 0)
+    {
+      ssize_t written = ::write(fd, out, remaining);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written < 0) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw CsvWriteException("Failed to write CSV time index: " + temporary);
+      }
+      out += written;
+      remaining -= static_cast<size_t>(written);
+    }
+
+    if (::close(fd) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0) {
+      ::unlink(temporary.c_str());
+      throw CsvWriteException("Failed to write CSV time index: " + path);
+    }
+  }
+}
@@ -0,0 +1,201 @@
+#include "CsvWriter.h"
+#include "Exceptions.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+namespace mgutils
+{
+  CsvWriter::CsvWriter(const std::string& filename, const CsvWriterOptions& options):
+      _path(filename),
+      _options(options),
+      _buffer(options.bufferSize > MAX_NUMBER_LENGTH ? options.bufferSize : MAX_NUMBER_LENGTH),
+      _lastFlush(std::chrono::steady_clock::now())
+  {
+    _fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | (options.append ? O_APPEND : O_TRUNC), 0644);
+    if (_fd < 0)
+      throw CsvWriteException("Failed to open CSV file for writing: " + filename + " (" + std::strerror(errno) + ")");
+
+    if (_options.background) {
+      _pending.resize(_buffer.size());
+      _thread = std::thread(&CsvWriter::backgroundLoop, this);
+    }
+  }
+
+  CsvWriter::~CsvWriter()
+  {
+    try {
+      flush();
+    } catch (const std::exception&) {
+      // Already reported when the exception was created
+    }
+
+    if (_thread.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+      }
+      _condition.notify_all();
+      _thread.join();
+    }
+
+    if (_fd >= 0)
+      ::close(_fd);
+  }
+
+  CsvWriter& CsvWriter::field(std::string_view text)
+  {
+    separate();
+
+    if (_options.quoting == CsvWriterOptions::Quoting::All ||
+        (_options.quoting == CsvWriterOptions::Quoting::Minimal && needsQuotes(text))) {
+      const char quote = _options.quote;
+      put(&quote, 1);
+      size_t start = 0;
+      for (size_t i = 0; i < text.size(); ++i)
+      {
+        if (text[i] == quote) {
+          put(text.data() + start, i + 1 - start);
+          put(&quote, 1);
+          start = i + 1;
+        }
+      }
+      put(text.data() + start, text.size() - start);
+      put(&quote, 1);
+    } else {
+      put(text.data(), text.size());
+    }
+    return *this;
+  }
+
+  CsvWriter& CsvWriter::field(char value)
+  {
+    return value == '\0' ? field(std::string_view()) : field(std::string_view(&value, 1));
+  }
+
+  CsvWriter& CsvWriter::field(bool value)
+  {
+    return field(value ? std::string_view("true") : std::string_view("false"));
+  }
+
+  CsvWriter& CsvWriter::endRow()
+  {
+    *reserve(1) = '\n';
+    ++_size;
+    _fieldCount = 0;
+    ++_rowCount;
+
+    if (_options.flushInterval.count() > 0) {
+      auto now = std::chrono::steady_clock::now();
+      if (now - _lastFlush >= _options.flushInterval)
+        commit();
+    }
+    return *this;
+  }
+
+  bool CsvWriter::needsQuotes(std::string_view text) const
+  {
+    for (char c : text)
+    {
+      if (c == _options.delimiter || c == _options.quote || c == '\n' || c == '\r')
+        return true;
+    }
+    return false;
+  }
+
+  void CsvWriter::put(const char* data, size_t count)
+  {
+    while (count > 0)
+    {
+      if (_size == _buffer.size())
+        commit();
+      const size_t chunk = std::min(count, _buffer.size() - _size);
+      std::memcpy(_buffer.data() + _size, data, chunk);
+      _size += chunk;
+      data += chunk;
+      count -= chunk;
+    }
+  }
+
+  void CsvWriter::flush()
+  {
+    commit();
+
+    if (_thread.joinable()) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this] { return _pendingSize == 0; });
+      if (_error)
+        std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+  }
+
+  void CsvWriter::commit()
+  {
+    _lastFlush = std::chrono::steady_clock::now();
+    if (_size == 0)
+      return;
+
+    if (!_thread.joinable()) {
+      writeAll(_buffer.data(), _size);
+      _size = 0;
+      return;
+    }
+
+    // Wait until the previous buffer is on its way out, then swap
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [this] { return _pendingSize == 0; });
+    if (_error)
+      std::rethrow_exception(std::exchange(_error, nullptr));
+
+    if (_pending.size() < _buffer.size())
+      _pending.resize(_buffer.size());
+    _buffer.swap(_pending);
+    _pendingSize = _size;
+    _size = 0;
+    lock.unlock();
+    _condition.notify_all();
+  }
+
+  void CsvWriter::writeAll(const char* data, size_t count)
+  {
+    while (count > 0)
+    {
+      ssize_t written = ::write(_fd, data, count);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written < 0)
+        throw CsvWriteException("Failed to write CSV file: " + _path + " (" + std::strerror(errno) + ")");
+      data += written;
+      count -= static_cast<size_t>(written);
+    }
+  }
+
+  void CsvWriter::backgroundLoop()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+      _condition.wait(lock, [this] { return _pendingSize > 0 || _stopping; });
+      if (_pendingSize == 0)
+        return;
+
+      const size_t size = _pendingSize;
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        writeAll(_pending.data(), size);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+
+      if (error)
+        _error = error;
+      _pendingSize = 0;
+      _condition.notify_all();
+    }
+  }
+}
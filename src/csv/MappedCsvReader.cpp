@@ -0,0 +1,74 @@
+#include "MappedCsvReader.h"
+#include "CsvSource.h"
+#include "Exceptions.h"
+
+namespace mgutils
+{
+  MappedCsvReader::MappedCsvReader(const std::string& filename, char delimiter):
+      MappedCsvReader(filename, CsvOptions{delimiter})
+  {}
+
+  MappedCsvReader::MappedCsvReader(const std::string& filename, const CsvOptions& options):
+      _file(filename, MappedFile::Mode::CopyOnWrite)
+  {
+    if (csv::detectCompression(filename) != csv::CsvCompression::None)
+      throw CsvUsageException("MappedCsvReader needs an uncompressed file, read compressed CSV with "
+                              "CsvLoader::rows or loadColumns: " + filename);
+    _file.adviseSequential();
+    index(options);
+    _file.adviseRandom();
+  }
+
+  void MappedCsvReader::index(const CsvOptions& options)
+  {
+    const csv::CsvScanner scanner(options);
+    char* data = _file.data();
+    const size_t size = _file.size();
+    bool first = true;
+
+    scanner.forEachRecord(data, 0, size, [&](size_t start, const csv::CsvField* fields, size_t count) {
+      if (first) {
+        first = false;
+        _columnCount = count;
+
+        // Size the index from a sample of lines so it does not reallocate its way up; a short estimate
+        // still grows geometrically, and the index is never shrunk, which would copy it
+        const size_t estimate = csv::estimateRecords(data, start, size);
+        _rowOffsets.reserve(estimate);
+        _fields.reserve(estimate * _columnCount);
+
+        if (options.hasHeader) {
+          for (size_t i = 0; i < count; ++i)
+            _columnNames.emplace_back(data + start + fields[i].begin, fields[i].end - fields[i].begin);
+          return;
+        }
+      }
+
+      if (count != _columnCount)
+        throw CsvReadException("CSV record " + std::to_string(_rowOffsets.size() + 1) + " of " + _file.path() +
+                               " has " + std::to_string(count) + " fields, expected " +
+                               std::to_string(_columnCount));
+
+      _rowOffsets.push_back(start);
+      _fields.insert(_fields.end(), fields, fields + count);
+    });
+  }
+
+  size_t MappedCsvReader::columnIndex(std::string_view columnName) const
+  {
+    for (size_t i = 0; i < _columnNames.size(); ++i)
+    {
+      if (_columnNames[i] == columnName)
+        return i;
+    }
+    throw CsvUsageException("CSV column not found: " + std::string(columnName));
+  }
+
+  CsvRow MappedCsvReader::row(size_t rowIndex) const
+  {
+    if (rowIndex >= rowCount())
+      throw CsvUsageException("CSV row " + std::to_string(rowIndex) + " out of range (" +
+                              std::to_string(rowCount()) + " rows)");
+    return rowAt(rowIndex);
+  }
+}
@@ -0,0 +1,66 @@
+#include "FrozenJson.h"
+#include <algorithm>
+
+namespace mgutils
+{
+  namespace
+  {
+    // Room for the pool's own bookkeeping at the start of a user supplied buffer
+    constexpr size_t POOL_HEADER_BOUND = 256;
+
+    constexpr size_t align(size_t size)
+    {
+      return (size + 7) & ~size_t(7);
+    }
+  }
+
+  FrozenJson::FrozenJson(const rapidjson::Value& source, bool compact):
+      _compact(compact),
+      _capacity(compact ? storageBound(source) + POOL_HEADER_BOUND : 0),
+      _buffer(compact ? new char[_capacity] : nullptr),
+      _allocator(compact ? rapidjson::MemoryPoolAllocator<>(_buffer.get(), _capacity) : rapidjson::MemoryPoolAllocator<>()),
+      _root(source, _allocator, true)
+  {
+    if (_compact)
+      sortMembers(_root);
+  }
+
+  size_t FrozenJson::storageBound(const rapidjson::Value& value)
+  {
+    // Over-estimates: short strings are stored inline but are still counted here
+    if (value.IsString())
+      return align(value.GetStringLength() + 1);
+
+    size_t size = 0;
+    if (value.IsArray())
+    {
+      size += align(value.Size() * sizeof(rapidjson::Value));
+      for (const auto& element : value.GetArray())
+        size += storageBound(element);
+    }
+    else if (value.IsObject())
+    {
+      size += align(value.MemberCount() * sizeof(rapidjson::Value::Member));
+      for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it)
+        size += storageBound(it->name) + storageBound(it->value);
+    }
+    return size;
+  }
+
+  void FrozenJson::sortMembers(rapidjson::Value& value)
+  {
+    if (value.IsArray())
+    {
+      for (auto& element : value.GetArray())
+        sortMembers(element);
+    }
+    else if (value.IsObject())
+    {
+      std::sort(value.MemberBegin(), value.MemberEnd(), [](const auto& lhs, const auto& rhs) {
+        return json::keyLess(lhs.name, std::string_view(rhs.name.GetString(), rhs.name.GetStringLength()));
+      });
+      for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it)
+        sortMembers(it->value);
+    }
+  }
+}
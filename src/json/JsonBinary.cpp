@@ -0,0 +1,661 @@
+#include "Json.h"
+#include "JsonDocument.h"
+#include "Exceptions.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace mgutils
+{
+  namespace
+  {
+    // Nesting limit for decoding, so malformed input cannot exhaust the stack
+    constexpr size_t MAX_BINARY_DEPTH = 512;
+
+    class BinaryOutput
+    {
+    public:
+      explicit BinaryOutput(std::vector<uint8_t>& out): _out(out) {}
+
+      void byte(uint8_t b) { _out.push_back(b); }
+
+      template <typename T>
+      void bigEndian(T v)
+      {
+        for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8)
+          _out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(v) >> shift));
+      }
+
+      void bytes(const char* data, size_t size)
+      {
+        _out.insert(_out.end(), reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + size);
+      }
+
+      void float64(double v)
+      {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        bigEndian(bits);
+      }
+
+    private:
+      std::vector<uint8_t>& _out;
+    };
+
+    class BinaryInput
+    {
+    public:
+      BinaryInput(const uint8_t* data, size_t size, const char* format): _data(data), _end(data + size), _format(format) {}
+
+      bool atEnd() const { return _data == _end; }
+
+      uint8_t byte()
+      {
+        need(1);
+        return *_data++;
+      }
+
+      uint8_t peek()
+      {
+        need(1);
+        return *_data;
+      }
+
+      template <typename T>
+      T bigEndian()
+      {
+        need(sizeof(T));
+        uint64_t v = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+          v = (v << 8) | _data[i];
+        _data += sizeof(T);
+        return static_cast<T>(v);
+      }
+
+      const char* bytes(uint64_t size)
+      {
+        need(size);
+        auto begin = reinterpret_cast<const char*>(_data);
+        _data += size;
+        return begin;
+      }
+
+      double float32()
+      {
+        uint32_t bits = bigEndian<uint32_t>();
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+      }
+
+      double float64()
+      {
+        uint64_t bits = bigEndian<uint64_t>();
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+      }
+
+      [[noreturn]] void fail(const std::string& reason) const
+      {
+        throw JsonParseException(std::string("Failed to parse ") + _format + " content: " + reason);
+      }
+
+      void enter(size_t& depth) const
+      {
+        if (++depth > MAX_BINARY_DEPTH)
+          fail("nesting too deep");
+      }
+
+      static rapidjson::SizeType length(uint64_t size, const BinaryInput& input)
+      {
+        if (size > std::numeric_limits<rapidjson::SizeType>::max())
+          input.fail("length out of range");
+        return static_cast<rapidjson::SizeType>(size);
+      }
+
+    private:
+      void need(uint64_t size) const
+      {
+        if (size > static_cast<uint64_t>(_end - _data))
+          fail("unexpected end of input");
+      }
+
+      const uint8_t* _data;
+      const uint8_t* _end;
+      const char* _format;
+    };
+
+    // MessagePack
+
+    class MsgPackEncoder
+    {
+    public:
+      explicit MsgPackEncoder(std::vector<uint8_t>& out): _out(out) {}
+
+      void encode(const rapidjson::Value& value)
+      {
+        switch (value.GetType())
+        {
+          case rapidjson::kNullType:
+            _out.byte(0xc0);
+            break;
+          case rapidjson::kFalseType:
+            _out.byte(0xc2);
+            break;
+          case rapidjson::kTrueType:
+            _out.byte(0xc3);
+            break;
+          case rapidjson::kStringType:
+            string(value.GetString(), value.GetStringLength());
+            break;
+          case rapidjson::kNumberType:
+            number(value);
+            break;
+          case rapidjson::kArrayType:
+            header(value.Size(), 0x90, 15, 0xdc);
+            for (const auto& element : value.GetArray())
+              encode(element);
+            break;
+          case rapidjson::kObjectType:
+            header(value.MemberCount(), 0x80, 15, 0xde);
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+              string(it->name.GetString(), it->name.GetStringLength());
+              encode(it->value);
+            }
+            break;
+        }
+      }
+
+    private:
+      // fix form when size fits, otherwise the 16 bit marker and the 32 bit one that follows it
+      void header(uint32_t size, uint8_t fixMarker, uint32_t fixMax, uint8_t marker16)
+      {
+        if (size <= fixMax) {
+          _out.byte(static_cast<uint8_t>(fixMarker | size));
+        } else if (size <= 0xffff) {
+          _out.byte(marker16);
+          _out.bigEndian(static_cast<uint16_t>(size));
+        } else {
+          _out.byte(marker16 + 1);
+          _out.bigEndian(size);
+        }
+      }
+
+      void string(const char* str, uint32_t size)
+      {
+        if (size <= 31) {
+          _out.byte(static_cast<uint8_t>(0xa0 | size));
+        } else if (size <= 0xff) {
+          _out.byte(0xd9);
+          _out.byte(static_cast<uint8_t>(size));
+        } else if (size <= 0xffff) {
+          _out.byte(0xda);
+          _out.bigEndian(static_cast<uint16_t>(size));
+        } else {
+          _out.byte(0xdb);
+          _out.bigEndian(size);
+        }
+        _out.bytes(str, size);
+      }
+
+      void number(const rapidjson::Value& value)
+      {
+        if (value.IsUint64()) {
+          uint64_t v = value.GetUint64();
+          if (v <= 0x7f) {
+            _out.byte(static_cast<uint8_t>(v));
+          } else if (v <= 0xff) {
+            _out.byte(0xcc);
+            _out.byte(static_cast<uint8_t>(v));
+          } else if (v <= 0xffff) {
+            _out.byte(0xcd);
+            _out.bigEndian(static_cast<uint16_t>(v));
+          } else if (v <= 0xffffffff) {
+            _out.byte(0xce);
+            _out.bigEndian(static_cast<uint32_t>(v));
+          } else {
+            _out.byte(0xcf);
+            _out.bigEndian(v);
+          }
+        } else if (value.IsInt64()) {
+          // Only negative values reach here
+          int64_t v = value.GetInt64();
+          if (v >= -32) {
+            _out.byte(static_cast<uint8_t>(v));
+          } else if (v >= std::numeric_limits<int8_t>::min()) {
+            _out.byte(0xd0);
+            _out.byte(static_cast<uint8_t>(v));
+          } else if (v >= std::numeric_limits<int16_t>::min()) {
+            _out.byte(0xd1);
+            _out.bigEndian(static_cast<uint16_t>(v));
+          } else if (v >= std::numeric_limits<int32_t>::min()) {
+            _out.byte(0xd2);
+            _out.bigEndian(static_cast<uint32_t>(v));
+          } else {
+            _out.byte(0xd3);
+            _out.bigEndian(static_cast<uint64_t>(v));
+          }
+        } else {
+          _out.byte(0xcb);
+          _out.float64(value.GetDouble());
+        }
+      }
+
+      BinaryOutput _out;
+    };
+
+    // Generator for Document::Populate, emitting SAX events straight into the document
+    class MsgPackDecoder
+    {
+    public:
+      MsgPackDecoder(const uint8_t* data, size_t size): _in(data, size, "MessagePack") {}
+
+      template <typename Handler>
+      bool operator()(Handler& handler)
+      {
+        if (_in.atEnd())
+          _in.fail("empty input");
+
+        size_t depth = 0;
+        value(handler, depth);
+        if (!_in.atEnd())
+          _in.fail("trailing bytes after the root value");
+        return true;
+      }
+
+    private:
+      template <typename Handler>
+      void value(Handler& handler, size_t depth)
+      {
+        const uint8_t marker = _in.byte();
+
+        if (marker <= 0x7f) {
+          handler.Int(marker);
+        } else if (marker >= 0xe0) {
+          handler.Int(static_cast<int8_t>(marker));
+        } else if ((marker & 0xe0) == 0xa0) {
+          string(handler, marker & 0x1f, false);
+        } else if ((marker & 0xf0) == 0x90) {
+          array(handler, marker & 0x0f, depth);
+        } else if ((marker & 0xf0) == 0x80) {
+          object(handler, marker & 0x0f, depth);
+        } else {
+          switch (marker)
+          {
+            case 0xc0: handler.Null(); break;
+            case 0xc2: handler.Bool(false); break;
+            case 0xc3: handler.Bool(true); break;
+            case 0xca: handler.Double(_in.float32()); break;
+            case 0xcb: handler.Double(_in.float64()); break;
+            case 0xcc: handler.Uint(_in.bigEndian<uint8_t>()); break;
+            case 0xcd: handler.Uint(_in.bigEndian<uint16_t>()); break;
+            case 0xce: handler.Uint(_in.bigEndian<uint32_t>()); break;
+            case 0xcf: handler.Uint64(_in.bigEndian<uint64_t>()); break;
+            case 0xd0: handler.Int(_in.bigEndian<int8_t>()); break;
+            case 0xd1: handler.Int(_in.bigEndian<int16_t>()); break;
+            case 0xd2: handler.Int(_in.bigEndian<int32_t>()); break;
+            case 0xd3: handler.Int64(_in.bigEndian<int64_t>()); break;
+            case 0xd9: string(handler, _in.bigEndian<uint8_t>(), false); break;
+            case 0xda: string(handler, _in.bigEndian<uint16_t>(), false); break;
+            case 0xdb: string(handler, _in.bigEndian<uint32_t>(), false); break;
+            case 0xdc: array(handler, _in.bigEndian<uint16_t>(), depth); break;
+            case 0xdd: array(handler, _in.bigEndian<uint32_t>(), depth); break;
+            case 0xde: object(handler, _in.bigEndian<uint16_t>(), depth); break;
+            case 0xdf: object(handler, _in.bigEndian<uint32_t>(), depth); break;
+            default:
+              // bin and ext have no JSON counterpart
+              _in.fail("unsupported type marker " + std::to_string(marker));
+          }
+        }
+      }
+
+      template <typename Handler>
+      void string(Handler& handler, uint64_t size, bool key)
+      {
+        auto length = BinaryInput::length(size, _in);
+        const char* str = _in.bytes(length);
+        if (key) {
+          handler.Key(str, length, true);
+        } else {
+          handler.String(str, length, true);
+        }
+      }
+
+      template <typename Handler>
+      void array(Handler& handler, uint64_t size, size_t depth)
+      {
+        _in.enter(depth);
+        auto count = BinaryInput::length(size, _in);
+        handler.StartArray();
+        for (rapidjson::SizeType i = 0; i < count; ++i)
+          value(handler, depth);
+        handler.EndArray(count);
+      }
+
+      template <typename Handler>
+      void object(Handler& handler, uint64_t size, size_t depth)
+      {
+        _in.enter(depth);
+        auto count = BinaryInput::length(size, _in);
+        handler.StartObject();
+        for (rapidjson::SizeType i = 0; i < count; ++i)
+        {
+          const uint8_t marker = _in.byte();
+          if ((marker & 0xe0) == 0xa0) {
+            string(handler, marker & 0x1f, true);
+          } else if (marker == 0xd9) {
+            string(handler, _in.bigEndian<uint8_t>(), true);
+          } else if (marker == 0xda) {
+            string(handler, _in.bigEndian<uint16_t>(), true);
+          } else if (marker == 0xdb) {
+            string(handler, _in.bigEndian<uint32_t>(), true);
+          } else {
+            _in.fail("map keys must be strings");
+          }
+          value(handler, depth);
+        }
+        handler.EndObject(count);
+      }
+
+      BinaryInput _in;
+    };
+
+    // CBOR (RFC 8949)
+
+    enum CborMajor : uint8_t
+    {
+      CBOR_UNSIGNED = 0,
+      CBOR_NEGATIVE = 1,
+      CBOR_BYTES = 2,
+      CBOR_TEXT = 3,
+      CBOR_ARRAY = 4,
+      CBOR_MAP = 5,
+      CBOR_TAG = 6,
+      CBOR_SIMPLE = 7
+    };
+
+    class CborEncoder
+    {
+    public:
+      explicit CborEncoder(std::vector<uint8_t>& out): _out(out) {}
+
+      void encode(const rapidjson::Value& value)
+      {
+        switch (value.GetType())
+        {
+          case rapidjson::kNullType:
+            _out.byte(0xf6);
+            break;
+          case rapidjson::kFalseType:
+            _out.byte(0xf4);
+            break;
+          case rapidjson::kTrueType:
+            _out.byte(0xf5);
+            break;
+          case rapidjson::kStringType:
+            head(CBOR_TEXT, value.GetStringLength());
+            _out.bytes(value.GetString(), value.GetStringLength());
+            break;
+          case rapidjson::kNumberType:
+            if (value.IsUint64()) {
+              head(CBOR_UNSIGNED, value.GetUint64());
+            } else if (value.IsInt64()) {
+              head(CBOR_NEGATIVE, static_cast<uint64_t>(-(value.GetInt64() + 1)));
+            } else {
+              _out.byte(0xfb);
+              _out.float64(value.GetDouble());
+            }
+            break;
+          case rapidjson::kArrayType:
+            head(CBOR_ARRAY, value.Size());
+            for (const auto& element : value.GetArray())
+              encode(element);
+            break;
+          case rapidjson::kObjectType:
+            head(CBOR_MAP, value.MemberCount());
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+              head(CBOR_TEXT, it->name.GetStringLength());
+              _out.bytes(it->name.GetString(), it->name.GetStringLength());
+              encode(it->value);
+            }
+            break;
+        }
+      }
+
+    private:
+      void head(CborMajor major, uint64_t argument)
+      {
+        const auto type = static_cast<uint8_t>(major << 5);
+        if (argument < 24) {
+          _out.byte(static_cast<uint8_t>(type | argument));
+        } else if (argument <= 0xff) {
+          _out.byte(type | 24);
+          _out.byte(static_cast<uint8_t>(argument));
+        } else if (argument <= 0xffff) {
+          _out.byte(type | 25);
+          _out.bigEndian(static_cast<uint16_t>(argument));
+        } else if (argument <= 0xffffffff) {
+          _out.byte(type | 26);
+          _out.bigEndian(static_cast<uint32_t>(argument));
+        } else {
+          _out.byte(type | 27);
+          _out.bigEndian(argument);
+        }
+      }
+
+      BinaryOutput _out;
+    };
+
+    class CborDecoder
+    {
+    public:
+      CborDecoder(const uint8_t* data, size_t size): _in(data, size, "CBOR") {}
+
+      template <typename Handler>
+      bool operator()(Handler& handler)
+      {
+        if (_in.atEnd())
+          _in.fail("empty input");
+
+        size_t depth = 0;
+        value(handler, depth);
+        if (!_in.atEnd())
+          _in.fail("trailing bytes after the root value");
+        return true;
+      }
+
+    private:
+      static constexpr uint8_t INDEFINITE = 31;
+      static constexpr uint8_t BREAK = 0xff;
+
+      uint64_t argument(uint8_t additional)
+      {
+        if (additional < 24)
+          return additional;
+
+        switch (additional)
+        {
+          case 24: return _in.bigEndian<uint8_t>();
+          case 25: return _in.bigEndian<uint16_t>();
+          case 26: return _in.bigEndian<uint32_t>();
+          case 27: return _in.bigEndian<uint64_t>();
+          default: _in.fail("invalid additional information " + std::to_string(additional));
+        }
+      }
+
+      static double halfFloat(uint16_t half)
+      {
+        const int exponent = (half >> 10) & 0x1f;
+        const int mantissa = half & 0x3ff;
+        double v;
+        if (exponent == 0) {
+          v = std::ldexp(mantissa, -24);
+        } else if (exponent != 31) {
+          v = std::ldexp(mantissa + 1024, exponent - 25);
+        } else {
+          v = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        }
+        return (half & 0x8000) ? -v : v;
+      }
+
+      template <typename Handler>
+      void value(Handler& handler, size_t depth)
+      {
+        const uint8_t initial = _in.byte();
+        const auto major = static_cast<CborMajor>(initial >> 5);
+        const uint8_t additional = initial & 0x1f;
+
+        switch (major)
+        {
+          case CBOR_UNSIGNED:
+            handler.Uint64(argument(additional));
+            break;
+          case CBOR_NEGATIVE:
+          {
+            uint64_t n = argument(additional);
+            if (n > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+              _in.fail("negative integer out of range");
+            handler.Int64(-1 - static_cast<int64_t>(n));
+            break;
+          }
+          case CBOR_BYTES:
+            _in.fail("byte strings have no JSON counterpart");
+          case CBOR_TEXT:
+            text(handler, additional, false);
+            break;
+          case CBOR_ARRAY:
+          {
+            _in.enter(depth);
+            handler.StartArray();
+            rapidjson::SizeType count = 0;
+            if (additional == INDEFINITE) {
+              for (; _in.peek() != BREAK; ++count)
+                value(handler, depth);
+              _in.byte();
+            } else {
+              count = BinaryInput::length(argument(additional), _in);
+              for (rapidjson::SizeType i = 0; i < count; ++i)
+                value(handler, depth);
+            }
+            handler.EndArray(count);
+            break;
+          }
+          case CBOR_MAP:
+          {
+            _in.enter(depth);
+            handler.StartObject();
+            rapidjson::SizeType count = 0;
+            if (additional == INDEFINITE) {
+              for (; _in.peek() != BREAK; ++count)
+                member(handler, depth);
+              _in.byte();
+            } else {
+              count = BinaryInput::length(argument(additional), _in);
+              for (rapidjson::SizeType i = 0; i < count; ++i)
+                member(handler, depth);
+            }
+            handler.EndObject(count);
+            break;
+          }
+          case CBOR_TAG:
+            // Tags only annotate the item that follows; a chain of them nests like containers do
+            argument(additional);
+            _in.enter(depth);
+            value(handler, depth);
+            break;
+          case CBOR_SIMPLE:
+            switch (additional)
+            {
+              case 20: handler.Bool(false); break;
+              case 21: handler.Bool(true); break;
+              case 22:
+              case 23: handler.Null(); break; // null and undefined
+              case 25: handler.Double(halfFloat(_in.bigEndian<uint16_t>())); break;
+              case 26: handler.Double(_in.float32()); break;
+              case 27: handler.Double(_in.float64()); break;
+              default: _in.fail("unsupported simple value " + std::to_string(additional));
+            }
+            break;
+        }
+      }
+
+      template <typename Handler>
+      void member(Handler& handler, size_t depth)
+      {
+        const uint8_t initial = _in.byte();
+        if ((initial >> 5) != CBOR_TEXT)
+          _in.fail("map keys must be text strings");
+        text(handler, initial & 0x1f, true);
+        value(handler, depth);
+      }
+
+      template <typename Handler>
+      void text(Handler& handler, uint8_t additional, bool key)
+      {
+        if (additional == INDEFINITE)
+          _in.fail("indefinite length strings are not supported");
+
+        auto length = BinaryInput::length(argument(additional), _in);
+        const char* str = _in.bytes(length);
+        if (key) {
+          handler.Key(str, length, true);
+        } else {
+          handler.String(str, length, true);
+        }
+      }
+
+      BinaryInput _in;
+    };
+  }
+
+  std::vector<uint8_t> JsonDocument::toMsgPack() const
+  {
+    std::vector<uint8_t> out;
+    toMsgPack(out);
+    return out;
+  }
+
+  void JsonDocument::toMsgPack(std::vector<uint8_t>& out) const
+  {
+    MsgPackEncoder(out).encode(_document);
+  }
+
+  std::vector<uint8_t> JsonDocument::toCbor() const
+  {
+    std::vector<uint8_t> out;
+    toCbor(out);
+    return out;
+  }
+
+  void JsonDocument::toCbor(std::vector<uint8_t>& out) const
+  {
+    CborEncoder(out).encode(_document);
+  }
+
+  std::shared_ptr<JsonDocument> Json::parseMsgPack(const uint8_t* data, size_t size)
+  {
+    std::shared_ptr<JsonDocument> document(new JsonDocument());
+    MsgPackDecoder decoder(data, size);
+    document->_document.Populate(decoder);
+    return document;
+  }
+
+  std::shared_ptr<JsonDocument> Json::parseMsgPack(const std::vector<uint8_t>& data)
+  {
+    return parseMsgPack(data.data(), data.size());
+  }
+
+  std::shared_ptr<JsonDocument> Json::parseCbor(const uint8_t* data, size_t size)
+  {
+    std::shared_ptr<JsonDocument> document(new JsonDocument());
+    CborDecoder decoder(data, size);
+    document->_document.Populate(decoder);
+    return document;
+  }
+
+  std::shared_ptr<JsonDocument> Json::parseCbor(const std::vector<uint8_t>& data)
+  {
+    return parseCbor(data.data(), data.size());
+  }
+}
@@ -0,0 +1,82 @@
+#include "JsonBuilder.h"
+#include "JsonDocument.h"
+
+namespace mgutils
+{
+  ObjectBuilder::ObjectBuilder(const std::shared_ptr<JsonDocument>& doc, size_t reserve, bool uniqueKeys):
+      _value(rapidjson::kObjectType), _allocator(doc->getAllocator()), _uniqueKeys(uniqueKeys)
+  {
+    if (reserve > 0)
+      _value.MemberReserve(static_cast<rapidjson::SizeType>(reserve), _allocator);
+  }
+
+  ObjectBuilder& ObjectBuilder::add(std::string_view key, JsonValue&& value)
+  {
+    rapidjson::Value member = value.release(_allocator);
+    return addMember(key, member);
+  }
+
+  ObjectBuilder& ObjectBuilder::add(std::string_view key, ObjectBuilder&& nested)
+  {
+    return add(key, nested.build());
+  }
+
+  ObjectBuilder& ObjectBuilder::add(std::string_view key, ArrayBuilder&& nested)
+  {
+    return add(key, nested.build());
+  }
+
+  ObjectBuilder& ObjectBuilder::addMember(std::string_view key, rapidjson::Value& value)
+  {
+    if (!_uniqueKeys)
+    {
+      auto it = _value.FindMember(rapidjson::Value(rapidjson::StringRef(key.data(), key.size())));
+      if (it != _value.MemberEnd()) {
+        it->value = value;
+        return *this;
+      }
+    }
+
+    rapidjson::Value name(key.data(), static_cast<rapidjson::SizeType>(key.size()), _allocator);
+    _value.AddMember(name, value, _allocator);
+    return *this;
+  }
+
+  JsonValue ObjectBuilder::build()
+  {
+    JsonValue built(std::move(_value), _allocator);
+    _value.SetObject();
+    return built;
+  }
+
+  ArrayBuilder::ArrayBuilder(const std::shared_ptr<JsonDocument>& doc, size_t reserve):
+      _value(rapidjson::kArrayType), _allocator(doc->getAllocator())
+  {
+    if (reserve > 0)
+      _value.Reserve(static_cast<rapidjson::SizeType>(reserve), _allocator);
+  }
+
+  ArrayBuilder& ArrayBuilder::push(JsonValue&& value)
+  {
+    rapidjson::Value element = value.release(_allocator);
+    _value.PushBack(element, _allocator);
+    return *this;
+  }
+
+  ArrayBuilder& ArrayBuilder::push(ObjectBuilder&& nested)
+  {
+    return push(nested.build());
+  }
+
+  ArrayBuilder& ArrayBuilder::push(ArrayBuilder&& nested)
+  {
+    return push(nested.build());
+  }
+
+  JsonValue ArrayBuilder::build()
+  {
+    JsonValue built(std::move(_value), _allocator);
+    _value.SetArray();
+    return built;
+  }
+}
@@ -3,13 +3,100 @@
 //
 
 #include "JsonDocument.h"
-#include "rapidjson/filewritestream.h"
 #include "rapidjson/prettywriter.h"
-#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 #include "JsonValue.h"
+#include "JsonStreams.h"
+#include "FrozenJson.h"
+#include "JsonPatch.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace mgutils
 {
+  namespace
+  {
+    // rapidjson output stream filling a ring of fixed chunks and handing all of them to a single writev
+    class FdWriteStream
+    {
+    public:
+      typedef char Ch;
+
+      explicit FdWriteStream(int fd): _fd(fd) {}
+
+      void Put(char c)
+      {
+        if (_pos == CHUNK_SIZE)
+          nextChunk();
+        _chunks[_current][_pos++] = c;
+      }
+
+      void Flush()
+      {
+        iovec vectors[CHUNK_COUNT];
+        size_t count = 0;
+        for (size_t i = 0; i < _current; ++i)
+          vectors[count++] = {_chunks[i], CHUNK_SIZE};
+        if (_pos > 0)
+          vectors[count++] = {_chunks[_current], _pos};
+
+        writeAll(vectors, count);
+        _current = 0;
+        _pos = 0;
+      }
+
+      bool good() const { return _good; }
+
+    private:
+      static constexpr size_t CHUNK_SIZE = 16384;
+      static constexpr size_t CHUNK_COUNT = 4;
+
+      void nextChunk()
+      {
+        if (++_current == CHUNK_COUNT) {
+          _current = CHUNK_COUNT - 1;
+          Flush();
+          return;
+        }
+        _pos = 0;
+      }
+
+      void writeAll(iovec* vectors, size_t count)
+      {
+        while (_good && count > 0)
+        {
+          ssize_t written = ::writev(_fd, vectors, static_cast<int>(count));
+          if (written < 0) {
+            if (errno == EINTR)
+              continue;
+            _good = false;
+            return;
+          }
+
+          // Skip fully written vectors and advance into a partially written one
+          auto remaining = static_cast<size_t>(written);
+          while (count > 0 && remaining >= vectors->iov_len) {
+            remaining -= vectors->iov_len;
+            ++vectors;
+            --count;
+          }
+          if (count > 0) {
+            vectors->iov_base = static_cast<char*>(vectors->iov_base) + remaining;
+            vectors->iov_len -= remaining;
+          }
+        }
+      }
+
+      int _fd;
+      char _chunks[CHUNK_COUNT][CHUNK_SIZE];
+      size_t _current = 0;
+      size_t _pos = 0;
+      bool _good = true;
+    };
+  }
+
   JsonDocument::JsonDocument():
       _document(),
       _allocator(_document.GetAllocator())
@@ -22,30 +109,45 @@ namespace mgutils
 
   std::string JsonDocument::toString(bool pretty) const
   {
-    rapidjson::StringBuffer buffer;
+    std::string out;
+    serializeTo(out, pretty);
+    return out;
+  }
+
+  void JsonDocument::serializeTo(std::string& out, bool pretty) const
+  {
+    JsonStringStream stream(out);
     if (pretty) {
-      rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+      rapidjson::PrettyWriter<JsonStringStream> writer(stream);
       _document.Accept(writer);
     } else {
-      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      rapidjson::Writer<JsonStringStream> writer(stream);
       _document.Accept(writer);
     }
-    return buffer.GetString();
   }
 
-  bool JsonDocument::save(const std::string& file)
+  bool JsonDocument::serializeTo(int fd, bool pretty) const
   {
-    FILE* fp = fopen(file.c_str(), "w");
-    if (!fp)
-      return false;
+    FdWriteStream stream(fd);
+    if (pretty) {
+      rapidjson::PrettyWriter<FdWriteStream> writer(stream);
+      _document.Accept(writer);
+    } else {
+      rapidjson::Writer<FdWriteStream> writer(stream);
+      _document.Accept(writer);
+    }
+    stream.Flush();
+    return stream.good();
+  }
 
-    char writeBuffer[65536];
-    rapidjson::FileWriteStream os(fp, writeBuffer, sizeof(writeBuffer));
-    rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
-    _document.Accept(writer);
-    fclose(fp);
+  bool JsonDocument::save(const std::string& file, bool pretty)
+  {
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return false;
 
-    return true;
+    bool written = serializeTo(fd, pretty);
+    return ::close(fd) == 0 && written;
   }
 
   JsonValue JsonDocument::getRoot()
@@ -53,6 +155,37 @@ namespace mgutils
     return {_document, shared_from_this()};
   }
 
+  std::shared_ptr<const FrozenJson> JsonDocument::freeze(bool compact) const
+  {
+    return std::shared_ptr<const FrozenJson>(new FrozenJson(_document, compact));
+  }
+
+  void JsonDocument::setRoot(JsonValue&& root)
+  {
+    rapidjson::Value value = root.release(_allocator);
+    static_cast<rapidjson::Value&>(_document).Swap(value);
+  }
+
+  JsonView JsonDocument::view() const
+  {
+    return JsonView(_document);
+  }
+
+  void JsonDocument::applyPatch(const JsonPatch& patch)
+  {
+    patch.apply(*this);
+  }
+
+  void JsonDocument::applyMergePatch(const JsonView& patch)
+  {
+    JsonPatch::applyMerge(*this, patch);
+  }
+
+  JsonPatch JsonDocument::diff(const JsonDocument& target) const
+  {
+    return JsonPatch::diff(view(), target.view());
+  }
+
   void JsonDocument::setObjet()
   {
     _document.SetObject();
@@ -0,0 +1,464 @@
+#include "JsonIncrementalParser.h"
+#include "Json.h"
+#include "JsonDocument.h"
+#include "Exceptions.h"
+#include "StringPool.h"
+
+namespace mgutils
+{
+  namespace
+  {
+    const char kTrue[] = "true";
+    const char kFalse[] = "false";
+    const char kNull[] = "null";
+
+    bool isWhitespace(char c)
+    {
+      return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    bool isNumberChar(char c)
+    {
+      return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    int hexDigit(char c)
+    {
+      if (c >= '0' && c <= '9')
+        return c - '0';
+      if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+      return -1;
+    }
+
+    // Generator for Populate: the events were already handed to the document, which only has to
+    // take the finished root off its stack
+    struct TakeRoot
+    {
+      template <typename Handler>
+      bool operator()(Handler&) const { return true; }
+    };
+  }
+
+  JsonIncrementalParser::JsonIncrementalParser(OnDocumentCallback onDocument, std::shared_ptr<StringPool> pool):
+  _onDocument(std::move(onDocument)),
+  _pool(std::move(pool))
+  {}
+
+  size_t JsonIncrementalParser::feed(const char* data, size_t size)
+  {
+    size_t emitted = 0;
+    size_t i = 0;
+
+    while (i < size)
+    {
+      if (_document) {
+        i += resume(data + i, size - i);
+        if (!_containers.empty())
+          break; // the chunk ended inside the document
+        finish();
+        ++emitted;
+        continue;
+      }
+
+      // Whatever the scan leaves over is a document cut by the end of the chunk
+      i = scan(data, i, size, emitted);
+      if (i < size) {
+        _document.reset(new JsonDocument());
+        _expect = Expect::Value;
+      }
+    }
+
+    return emitted;
+  }
+
+  // Parses the documents closing inside data[begin, size) straight from the chunk; returns the
+  // offset of a document left open at the end of it, or size
+  size_t JsonIncrementalParser::scan(const char* data, size_t begin, size_t size, size_t& emitted)
+  {
+    size_t depth = 0;
+    size_t start = begin; // first byte of the current document
+    bool inString = false;
+    bool escaped = false;
+
+    for (size_t i = begin; i < size; ++i)
+    {
+      const char c = data[i];
+
+      if (inString)
+      {
+        if (escaped) {
+          escaped = false;
+        } else if (c == '\\') {
+          escaped = true;
+        } else if (c == '"') {
+          inString = false;
+        }
+        continue;
+      }
+
+      if (depth == 0)
+      {
+        // Between documents
+        if (isWhitespace(c))
+          continue;
+        if (c != '{' && c != '[')
+          fail(std::string("unexpected character '") + c + "' between documents");
+        start = i;
+        depth = 1;
+        continue;
+      }
+
+      switch (c)
+      {
+        case '"':
+          inString = true;
+          break;
+        case '{':
+        case '[':
+          ++depth;
+          break;
+        case '}':
+        case ']':
+          if (--depth == 0) {
+            _onDocument(parse(data + start, i + 1 - start));
+            ++emitted;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    return depth > 0 ? start : size;
+  }
+
+  // Tokenizes data into the document under construction until its root closes; returns the number
+  // of bytes consumed, all of them unless the document ended inside the chunk
+  size_t JsonIncrementalParser::resume(const char* data, size_t size)
+  {
+    rapidjson::Document& handler = _document->_document;
+    size_t i = 0;
+
+    while (i < size)
+    {
+      const char c = data[i];
+
+      switch (_inside)
+      {
+        case Token::String:
+        case Token::Key:
+          i = string(data, i, size);
+          continue;
+        case Token::Number:
+          if (isNumberChar(c)) {
+            _token.push_back(c);
+            ++i;
+            continue;
+          }
+          endNumber();
+          break; // c follows the number
+        case Token::Literal:
+          if (c != *_literal)
+            fail(std::string("unexpected character '") + c + "' in literal");
+          ++i;
+          if (*++_literal == '\0') {
+            if (_literal == kNull + 4)
+              handler.Null();
+            else
+              handler.Bool(_literal == kTrue + 4);
+            _inside = Token::None;
+            _expect = Expect::CommaOrEnd;
+          }
+          continue;
+        case Token::None:
+          break;
+      }
+
+      ++i;
+      if (isWhitespace(c))
+        continue;
+
+      switch (_expect)
+      {
+        case Expect::KeyOrEnd:
+          if (c == '}') {
+            close(true);
+            break;
+          }
+          [[fallthrough]];
+        case Expect::Key:
+          if (c != '"')
+            fail(std::string("expected a member name, got '") + c + "'");
+          ++_containers.back().count;
+          _inside = Token::Key;
+          break;
+        case Expect::Colon:
+          if (c != ':')
+            fail(std::string("expected ':', got '") + c + "'");
+          _expect = Expect::Value;
+          break;
+        case Expect::ValueOrEnd:
+          if (c == ']') {
+            close(false);
+            break;
+          }
+          [[fallthrough]];
+        case Expect::Value:
+          value(c);
+          break;
+        case Expect::CommaOrEnd:
+          if (c == ',') {
+            _expect = _containers.back().object ? Expect::Key : Expect::Value;
+          } else if (c == (_containers.back().object ? '}' : ']')) {
+            close(_containers.back().object);
+          } else {
+            fail(std::string("expected ',' or a closing bracket, got '") + c + "'");
+          }
+          break;
+      }
+
+      if (_containers.empty())
+        return i;
+    }
+
+    return size;
+  }
+
+  // Consumes string bytes from data[begin, size) into _token; returns the offset after the closing
+  // quote, or size when the string goes on in the next chunk
+  size_t JsonIncrementalParser::string(const char* data, size_t begin, size_t size)
+  {
+    size_t i = begin;
+
+    while (i < size)
+    {
+      if (_escape == 0)
+      {
+        size_t run = i;
+        while (run < size && data[run] != '"' && data[run] != '\\' && static_cast<unsigned char>(data[run]) >= 0x20)
+          ++run;
+        if (run > i) {
+          if (_highSurrogate != 0)
+            fail("unpaired surrogate in string");
+          _token.append(data + i, run - i);
+          i = run;
+          continue;
+        }
+
+        const char c = data[i++];
+        if (c == '"') {
+          if (_highSurrogate != 0)
+            fail("unpaired surrogate in string");
+          endString();
+          return i;
+        }
+        if (c == '\\') {
+          _escape = 1;
+          continue;
+        }
+        fail("control character in string");
+      }
+
+      const char c = data[i++];
+
+      if (_escape == 1)
+      {
+        if (_highSurrogate != 0 && c != 'u')
+          fail("unpaired surrogate in string");
+        _escape = 0;
+        switch (c)
+        {
+          case '"': _token.push_back('"'); break;
+          case '\\': _token.push_back('\\'); break;
+          case '/': _token.push_back('/'); break;
+          case 'b': _token.push_back('\b'); break;
+          case 'f': _token.push_back('\f'); break;
+          case 'n': _token.push_back('\n'); break;
+          case 'r': _token.push_back('\r'); break;
+          case 't': _token.push_back('\t'); break;
+          case 'u':
+            _escape = 2;
+            _unicode = 0;
+            break;
+          default:
+            fail(std::string("invalid escape '\\") + c + "' in string");
+        }
+        continue;
+      }
+
+      // One of the four digits of \u
+      const int digit = hexDigit(c);
+      if (digit < 0)
+        fail("invalid \\u escape in string");
+      _unicode = (_unicode << 4) | static_cast<uint32_t>(digit);
+      if (++_escape == 6) {
+        _escape = 0;
+        codepoint(_unicode);
+      }
+    }
+
+    return size;
+  }
+
+  void JsonIncrementalParser::value(char c)
+  {
+    rapidjson::Document& handler = _document->_document;
+
+    if (!_containers.empty() && !_containers.back().object)
+      ++_containers.back().count;
+
+    switch (c)
+    {
+      case '{':
+        handler.StartObject();
+        _containers.push_back({true, 0});
+        _expect = Expect::KeyOrEnd;
+        break;
+      case '[':
+        handler.StartArray();
+        _containers.push_back({false, 0});
+        _expect = Expect::ValueOrEnd;
+        break;
+      case '"':
+        _inside = Token::String;
+        break;
+      case 't':
+        _literal = kTrue + 1;
+        _inside = Token::Literal;
+        break;
+      case 'f':
+        _literal = kFalse + 1;
+        _inside = Token::Literal;
+        break;
+      case 'n':
+        _literal = kNull + 1;
+        _inside = Token::Literal;
+        break;
+      default:
+        if (c != '-' && (c < '0' || c > '9'))
+          fail(std::string("unexpected character '") + c + "'");
+        _token.assign(1, c);
+        _inside = Token::Number;
+        break;
+    }
+  }
+
+  // Appends a \u escape to the string as UTF-8, pairing surrogates
+  void JsonIncrementalParser::codepoint(uint32_t codepoint)
+  {
+    if (_highSurrogate != 0) {
+      if (codepoint < 0xDC00 || codepoint > 0xDFFF)
+        fail("unpaired surrogate in string");
+      codepoint = 0x10000 + ((_highSurrogate - 0xD800) << 10) + (codepoint - 0xDC00);
+      _highSurrogate = 0;
+    } else if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+      _highSurrogate = codepoint;
+      return;
+    } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+      fail("unpaired surrogate in string");
+    }
+
+    if (codepoint < 0x80) {
+      _token.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+      _token.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+      _token.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+      _token.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+      _token.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+      _token.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+      _token.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+      _token.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+      _token.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+      _token.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+  }
+
+  // Hands the finished string to the document, interned when a pool is set, as Json::parse does
+  void JsonIncrementalParser::endString()
+  {
+    rapidjson::Document& handler = _document->_document;
+    const auto length = static_cast<rapidjson::SizeType>(_token.size());
+    const std::optional<std::string_view> pooled = _pool ? _pool->intern(_token) : std::nullopt;
+    const char* str = pooled ? pooled->data() : _token.data();
+
+    if (_inside == Token::Key) {
+      handler.Key(str, length, !pooled);
+      _expect = Expect::Colon;
+    } else {
+      handler.String(str, length, !pooled);
+      _expect = Expect::CommaOrEnd;
+    }
+    _inside = Token::None;
+    _token.clear();
+  }
+
+  // rapidjson reads the number itself, so integer ranges and double rounding match Json::parse
+  void JsonIncrementalParser::endNumber()
+  {
+    rapidjson::Reader reader;
+    rapidjson::StringStream stream(_token.c_str());
+    if (reader.Parse(stream, _document->_document).IsError())
+      fail("invalid number '" + _token + "'");
+    _inside = Token::None;
+    _expect = Expect::CommaOrEnd;
+    _token.clear();
+  }
+
+  void JsonIncrementalParser::close(bool object)
+  {
+    rapidjson::Document& handler = _document->_document;
+    const uint32_t count = _containers.back().count;
+    if (object)
+      handler.EndObject(count);
+    else
+      handler.EndArray(count);
+    _containers.pop_back();
+    _expect = Expect::CommaOrEnd;
+  }
+
+  // Moves the root the tokenizer built into place and emits the document
+  void JsonIncrementalParser::finish()
+  {
+    TakeRoot takeRoot;
+    _document->_document.Populate(takeRoot);
+    if (_pool)
+      _document->_source = _pool;
+    std::shared_ptr<JsonDocument> document = std::move(_document);
+    reset();
+    _onDocument(std::move(document));
+  }
+
+  void JsonIncrementalParser::reset()
+  {
+    _document.reset();
+    _containers.clear();
+    _token.clear();
+    _expect = Expect::Value;
+    _inside = Token::None;
+    _literal = nullptr;
+    _escape = 0;
+    _unicode = 0;
+    _highSurrogate = 0;
+  }
+
+  std::shared_ptr<JsonDocument> JsonIncrementalParser::parse(const char* data, size_t size)
+  {
+    try {
+      return Json::parse(data, size, _pool);
+    } catch (const JsonParseException&) {
+      reset();
+      throw;
+    }
+  }
+
+  void JsonIncrementalParser::fail(const std::string& reason)
+  {
+    reset();
+    throw JsonParseException("Failed to parse JSON stream: " + reason);
+  }
+}
@@ -0,0 +1,569 @@
+#include "JsonPatch.h"
+#include "JsonDocument.h"
+#include "Exceptions.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace mgutils
+{
+  namespace
+  {
+    using Allocator = rapidjson::Document::AllocatorType;
+
+    const rapidjson::Value* stringMember(const rapidjson::Value& operation, const char* name)
+    {
+      auto it = operation.FindMember(name);
+      if (it == operation.MemberEnd())
+        return nullptr;
+      if (!it->value.IsString())
+        throw JsonUsageException(std::string("JSON patch member '") + name + "' must be a string");
+      return &it->value;
+    }
+
+    rapidjson::Value::MemberIterator findMember(rapidjson::Value& object, const std::string& key)
+    {
+      for (auto it = object.MemberBegin(); it != object.MemberEnd(); ++it)
+      {
+        if (it->name.GetStringLength() == key.size() && std::memcmp(it->name.GetString(), key.data(), key.size()) == 0)
+          return it;
+      }
+      return object.MemberEnd();
+    }
+
+    // rapidjson only appends, so new entries are pushed and rotated back into position
+    void insertElement(rapidjson::Value& array, uint32_t position, rapidjson::Value& value, Allocator& allocator)
+    {
+      array.PushBack(value, allocator);
+      for (rapidjson::SizeType i = array.Size() - 1; i > position; --i)
+        array[i].Swap(array[i - 1]);
+    }
+
+    void insertMember(rapidjson::Value& object, uint32_t position, const std::string& key, rapidjson::Value& value,
+                      Allocator& allocator)
+    {
+      rapidjson::Value name(key.data(), static_cast<rapidjson::SizeType>(key.size()), allocator);
+      object.AddMember(name, value, allocator);
+
+      auto members = object.MemberBegin();
+      for (rapidjson::SizeType i = object.MemberCount() - 1; i > position; --i) {
+        members[i].name.Swap(members[i - 1].name);
+        members[i].value.Swap(members[i - 1].value);
+      }
+    }
+
+    // Removes the element or member at position, keeping the order of the rest, and returns its value
+    rapidjson::Value eraseAt(rapidjson::Value& parent, uint32_t position)
+    {
+      rapidjson::Value removed;
+      if (parent.IsArray()) {
+        removed.Swap(parent[position]);
+        parent.Erase(parent.Begin() + position);
+      } else {
+        auto member = parent.MemberBegin() + position;
+        removed.Swap(member->value);
+        parent.EraseMember(member);
+      }
+      return removed;
+    }
+
+    void appendToken(std::string& pointer, const char* token, size_t length)
+    {
+      pointer.push_back('/');
+      for (size_t i = 0; i < length; ++i)
+      {
+        if (token[i] == '~') {
+          pointer += "~0";
+        } else if (token[i] == '/') {
+          pointer += "~1";
+        } else {
+          pointer.push_back(token[i]);
+        }
+      }
+    }
+
+    void appendIndex(std::string& pointer, rapidjson::SizeType index)
+    {
+      pointer.push_back('/');
+      pointer += std::to_string(index);
+    }
+
+    void addOperation(rapidjson::Document& patch, const char* op, const std::string& path, const rapidjson::Value* value)
+    {
+      auto& allocator = patch.GetAllocator();
+      rapidjson::Value operation(rapidjson::kObjectType);
+      operation.MemberReserve(value ? 3 : 2, allocator);
+
+      rapidjson::Value name(rapidjson::StringRef(op));
+      rapidjson::Value pointer(path.data(), static_cast<rapidjson::SizeType>(path.size()), allocator);
+      operation.AddMember("op", name, allocator);
+      operation.AddMember("path", pointer, allocator);
+      if (value) {
+        rapidjson::Value copy(*value, allocator, true);
+        operation.AddMember("value", copy, allocator);
+      }
+
+      patch.PushBack(operation, allocator);
+    }
+
+    void diffValues(const rapidjson::Value& from, const rapidjson::Value& to, std::string& pointer,
+                    rapidjson::Document& patch);
+
+    void diffObjects(const rapidjson::Value& from, const rapidjson::Value& to, std::string& pointer,
+                     rapidjson::Document& patch)
+    {
+      const size_t length = pointer.size();
+
+      for (auto it = from.MemberBegin(); it != from.MemberEnd(); ++it)
+      {
+        if (to.FindMember(it->name) != to.MemberEnd())
+          continue;
+        appendToken(pointer, it->name.GetString(), it->name.GetStringLength());
+        addOperation(patch, "remove", pointer, nullptr);
+        pointer.resize(length);
+      }
+
+      for (auto it = to.MemberBegin(); it != to.MemberEnd(); ++it)
+      {
+        appendToken(pointer, it->name.GetString(), it->name.GetStringLength());
+        auto source = from.FindMember(it->name);
+        if (source == from.MemberEnd()) {
+          addOperation(patch, "add", pointer, &it->value);
+        } else {
+          diffValues(source->value, it->value, pointer, patch);
+        }
+        pointer.resize(length);
+      }
+    }
+
+    // Largest from x to middle (after trimming common ends) aligned by LCS; bigger ones are diffed as one gap
+    constexpr size_t MAX_ALIGNMENT_CELLS = 1 << 16;
+
+    // Turns from[fromBegin, fromEnd) into to[toBegin, toEnd), with the array already matching to before
+    // toBegin: elements are diffed pairwise, then the surplus is removed or added
+    void diffGap(const rapidjson::Value& from, rapidjson::SizeType fromBegin, rapidjson::SizeType fromEnd,
+                 const rapidjson::Value& to, rapidjson::SizeType toBegin, rapidjson::SizeType toEnd,
+                 std::string& pointer, rapidjson::Document& patch)
+    {
+      const size_t length = pointer.size();
+      const rapidjson::SizeType paired = std::min(fromEnd - fromBegin, toEnd - toBegin);
+
+      for (rapidjson::SizeType i = 0; i < paired; ++i) {
+        appendIndex(pointer, toBegin + i);
+        diffValues(from[fromBegin + i], to[toBegin + i], pointer, patch);
+        pointer.resize(length);
+      }
+
+      for (rapidjson::SizeType i = fromBegin + paired; i < fromEnd; ++i) {
+        appendIndex(pointer, toBegin + paired);
+        addOperation(patch, "remove", pointer, nullptr);
+        pointer.resize(length);
+      }
+
+      for (rapidjson::SizeType i = toBegin + paired; i < toEnd; ++i) {
+        appendIndex(pointer, i);
+        addOperation(patch, "add", pointer, &to[i]);
+        pointer.resize(length);
+      }
+    }
+
+    // Elements shared at both ends are skipped and the rest aligned on their longest common
+    // subsequence, so an insertion or removal anywhere costs one operation
+    void diffArrays(const rapidjson::Value& from, const rapidjson::Value& to, std::string& pointer,
+                    rapidjson::Document& patch)
+    {
+      const rapidjson::SizeType fromSize = from.Size();
+      const rapidjson::SizeType toSize = to.Size();
+
+      rapidjson::SizeType prefix = 0;
+      while (prefix < fromSize && prefix < toSize && from[prefix] == to[prefix])
+        ++prefix;
+
+      rapidjson::SizeType suffix = 0;
+      while (suffix < fromSize - prefix && suffix < toSize - prefix &&
+             from[fromSize - 1 - suffix] == to[toSize - 1 - suffix])
+        ++suffix;
+
+      const size_t n = fromSize - suffix - prefix;
+      const size_t m = toSize - suffix - prefix;
+      if (n == 0 || m == 0 || n * m > MAX_ALIGNMENT_CELLS) {
+        diffGap(from, prefix, fromSize - suffix, to, prefix, toSize - suffix, pointer, patch);
+        return;
+      }
+
+      // lcs[i][j]: longest common subsequence of from[prefix + i..] and to[prefix + j..] within the middle
+      std::vector<uint32_t> lcs((n + 1) * (m + 1), 0);
+      std::vector<uint8_t> equal(n * m, 0);
+      auto cell = [m](size_t i, size_t j) { return i * (m + 1) + j; };
+
+      for (size_t i = n; i-- > 0;)
+      {
+        for (size_t j = m; j-- > 0;)
+        {
+          if (from[prefix + i] == to[prefix + j]) {
+            equal[i * m + j] = 1;
+            lcs[cell(i, j)] = lcs[cell(i + 1, j + 1)] + 1;
+          } else {
+            lcs[cell(i, j)] = std::max(lcs[cell(i + 1, j)], lcs[cell(i, j + 1)]);
+          }
+        }
+      }
+
+      size_t i = 0, j = 0, gapFrom = 0, gapTo = 0;
+      while (i < n && j < m)
+      {
+        if (equal[i * m + j]) {
+          diffGap(from, prefix + gapFrom, prefix + i, to, prefix + gapTo, prefix + j, pointer, patch);
+          gapFrom = ++i;
+          gapTo = ++j;
+        } else if (lcs[cell(i + 1, j)] >= lcs[cell(i, j + 1)]) {
+          ++i;
+        } else {
+          ++j;
+        }
+      }
+
+      diffGap(from, prefix + gapFrom, prefix + n, to, prefix + gapTo, prefix + m, pointer, patch);
+    }
+
+    void diffValues(const rapidjson::Value& from, const rapidjson::Value& to, std::string& pointer,
+                    rapidjson::Document& patch)
+    {
+      if (from.IsObject() && to.IsObject()) {
+        diffObjects(from, to, pointer, patch);
+      } else if (from.IsArray() && to.IsArray()) {
+        diffArrays(from, to, pointer, patch);
+      } else if (!(from == to)) {
+        addOperation(patch, "replace", pointer, &to);
+      }
+    }
+
+    void mergeValue(rapidjson::Value& target, const rapidjson::Value& patch, Allocator& allocator)
+    {
+      if (!patch.IsObject()) {
+        target.CopyFrom(patch, allocator, true);
+        return;
+      }
+
+      if (!target.IsObject())
+        target.SetObject();
+
+      for (auto it = patch.MemberBegin(); it != patch.MemberEnd(); ++it)
+      {
+        auto member = target.FindMember(it->name);
+        if (it->value.IsNull()) {
+          if (member != target.MemberEnd())
+            target.EraseMember(member);
+          continue;
+        }
+
+        if (member != target.MemberEnd()) {
+          mergeValue(member->value, it->value, allocator);
+          continue;
+        }
+
+        rapidjson::Value name(it->name, allocator, true);
+        rapidjson::Value value;
+        mergeValue(value, it->value, allocator);
+        target.AddMember(name, value, allocator);
+      }
+    }
+  }
+
+  JsonPatch JsonPatch::compile(const JsonView& operations)
+  {
+    auto document = std::make_shared<rapidjson::Document>();
+    document->CopyFrom(*operations._value, document->GetAllocator(), true);
+    return fromDocument(std::move(document));
+  }
+
+  JsonPatch JsonPatch::parse(const std::string& json)
+  {
+    auto document = std::make_shared<rapidjson::Document>();
+    document->Parse(json.c_str(), json.size());
+    if (document->HasParseError())
+      throw JsonParseException("Failed to parse JSON patch: " + json);
+    return fromDocument(std::move(document));
+  }
+
+  JsonPatch JsonPatch::fromDocument(std::shared_ptr<rapidjson::Document> document)
+  {
+    if (!document->IsArray())
+      throw JsonUsageException("JSON patch must be an array of operations");
+
+    JsonPatch patch;
+    patch._operations.reserve(document->Size());
+
+    for (const auto& entry : document->GetArray())
+    {
+      if (!entry.IsObject())
+        throw JsonUsageException("JSON patch operation must be an object");
+
+      const rapidjson::Value* op = stringMember(entry, "op");
+      const rapidjson::Value* path = stringMember(entry, "path");
+      if (!op || !path)
+        throw JsonUsageException("JSON patch operation needs 'op' and 'path'");
+
+      Operation operation{Op::Add, JsonPath::compile(std::string(path->GetString(), path->GetStringLength())),
+                          JsonPath(), nullptr};
+
+      const std::string_view name(op->GetString(), op->GetStringLength());
+      if (name == "add") {
+        operation.op = Op::Add;
+      } else if (name == "remove") {
+        operation.op = Op::Remove;
+      } else if (name == "replace") {
+        operation.op = Op::Replace;
+      } else if (name == "move") {
+        operation.op = Op::Move;
+      } else if (name == "copy") {
+        operation.op = Op::Copy;
+      } else if (name == "test") {
+        operation.op = Op::Test;
+      } else {
+        throw JsonUsageException("Unknown JSON patch operation: " + std::string(name));
+      }
+
+      if (operation.op == Op::Add || operation.op == Op::Replace || operation.op == Op::Test)
+      {
+        auto value = entry.FindMember("value");
+        if (value == entry.MemberEnd())
+          throw JsonUsageException("JSON patch '" + std::string(name) + "' operation needs a 'value'");
+        operation.value = &value->value;
+      }
+
+      if (operation.op == Op::Move || operation.op == Op::Copy)
+      {
+        const rapidjson::Value* from = stringMember(entry, "from");
+        if (!from)
+          throw JsonUsageException("JSON patch '" + std::string(name) + "' operation needs a 'from'");
+        operation.from = JsonPath::compile(std::string(from->GetString(), from->GetStringLength()));
+      }
+
+      patch._operations.push_back(std::move(operation));
+    }
+
+    patch._document = std::move(document);
+    return patch;
+  }
+
+  JsonPatch JsonPatch::diff(const JsonView& from, const JsonView& to)
+  {
+    auto document = std::make_shared<rapidjson::Document>(rapidjson::kArrayType);
+    std::string pointer;
+    diffValues(*from._value, *to._value, pointer, *document);
+    return fromDocument(std::move(document));
+  }
+
+  void JsonPatch::applyMerge(JsonDocument& document, const JsonView& mergePatch)
+  {
+    mergeValue(document._document, *mergePatch._value, document._allocator);
+  }
+
+  void JsonPatch::apply(JsonDocument& document) const
+  {
+    rapidjson::Value& root = document._document;
+    std::vector<Undo> undo;
+    undo.reserve(_operations.size());
+
+    try
+    {
+      for (const auto& operation : _operations)
+        applyOperation(root, operation, document._allocator, undo);
+    }
+    catch (...)
+    {
+      rollback(root, undo, document._allocator);
+      throw;
+    }
+  }
+
+  void JsonPatch::applyOperation(rapidjson::Value& root, const Operation& operation, Allocator& allocator,
+                                 std::vector<Undo>& undo)
+  {
+    switch (operation.op)
+    {
+      case Op::Add:
+      {
+        rapidjson::Value value(*operation.value, allocator, true);
+        add(root, operation.path, value, allocator, undo);
+        break;
+      }
+      case Op::Remove:
+        take(root, operation.path, false, undo);
+        break;
+      case Op::Replace:
+      {
+        rapidjson::Value* target = resolve(root, operation.path);
+        if (!target)
+          throw JsonPatchException("JSON patch target does not exist: " + operation.path.pointer());
+        rapidjson::Value value(*operation.value, allocator, true);
+        target->Swap(value);
+        undo.push_back({Undo::Kind::Restore, &operation.path, 0, false, std::move(value)});
+        break;
+      }
+      case Op::Move:
+      {
+        const std::string& from = operation.from.pointer();
+        const std::string& path = operation.path.pointer();
+        if (from == path)
+          break;
+        if (path.size() > from.size() && path.compare(0, from.size(), from) == 0 && path[from.size()] == '/')
+          throw JsonPatchException("JSON patch cannot move " + from + " into its own child " + path);
+
+        rapidjson::Value value = take(root, operation.from, true, undo);
+        try {
+          add(root, operation.path, value, allocator, undo);
+        } catch (...) {
+          // add throws before touching the document, so there is nothing for the Insert to carry back:
+          // it gets the taken value itself
+          Undo& insert = undo.back();
+          insert.value.Swap(value);
+          insert.carry = false;
+          throw;
+        }
+        break;
+      }
+      case Op::Copy:
+      {
+        const rapidjson::Value* source = resolve(root, operation.from);
+        if (!source)
+          throw JsonPatchException("JSON patch source does not exist: " + operation.from.pointer());
+        rapidjson::Value value(*source, allocator);
+        add(root, operation.path, value, allocator, undo);
+        break;
+      }
+      case Op::Test:
+      {
+        const rapidjson::Value* target = resolve(root, operation.path);
+        if (!target || !(*target == *operation.value))
+          throw JsonPatchException("JSON patch test failed at " + operation.path.pointer());
+        break;
+      }
+    }
+  }
+
+  void JsonPatch::rollback(rapidjson::Value& root, std::vector<Undo>& undo, Allocator& allocator)
+  {
+    rapidjson::Value carry;
+
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it)
+    {
+      const JsonPath& path = *it->path;
+      switch (it->kind)
+      {
+        case Undo::Kind::Erase:
+          carry = eraseAt(parentOf(root, path), it->position);
+          break;
+        case Undo::Kind::Insert:
+        {
+          rapidjson::Value& value = it->carry ? carry : it->value;
+          rapidjson::Value& parent = parentOf(root, path);
+          if (parent.IsArray()) {
+            insertElement(parent, it->position, value, allocator);
+          } else {
+            insertMember(parent, it->position, path._tokens.back().key, value, allocator);
+          }
+          break;
+        }
+        case Undo::Kind::Restore:
+          resolve(root, path)->Swap(it->value);
+          carry.Swap(it->value);
+          break;
+      }
+    }
+  }
+
+  rapidjson::Value* JsonPatch::resolve(rapidjson::Value& root, const JsonPath& path)
+  {
+    const rapidjson::Value* current = &root;
+    for (const auto& token : path._tokens)
+    {
+      current = JsonPath::step(*current, token, false);
+      if (!current)
+        return nullptr;
+    }
+    return const_cast<rapidjson::Value*>(current);
+  }
+
+  rapidjson::Value& JsonPatch::parentOf(rapidjson::Value& root, const JsonPath& path)
+  {
+    const rapidjson::Value* current = &root;
+    for (size_t i = 0; i + 1 < path._tokens.size(); ++i)
+    {
+      current = JsonPath::step(*current, path._tokens[i], false);
+      if (!current)
+        throw JsonPatchException("JSON patch path does not exist: " + path.pointer());
+    }
+
+    if (!current->IsObject() && !current->IsArray())
+      throw JsonPatchException("JSON patch path does not end in an object or array: " + path.pointer());
+    return const_cast<rapidjson::Value&>(*current);
+  }
+
+  void JsonPatch::add(rapidjson::Value& root, const JsonPath& path, rapidjson::Value& value, Allocator& allocator,
+                      std::vector<Undo>& undo)
+  {
+    if (path._tokens.empty()) {
+      root.Swap(value);
+      undo.push_back({Undo::Kind::Restore, &path, 0, false, std::move(value)});
+      return;
+    }
+
+    rapidjson::Value& parent = parentOf(root, path);
+    const JsonPath::Token& token = path._tokens.back();
+
+    if (parent.IsArray())
+    {
+      const uint32_t position = token.append ? parent.Size() : token.index;
+      if (position == JsonPath::NO_INDEX || position > parent.Size())
+        throw JsonPatchException("JSON patch array index out of range: " + path.pointer());
+      insertElement(parent, position, value, allocator);
+      undo.push_back({Undo::Kind::Erase, &path, position, false, rapidjson::Value()});
+      return;
+    }
+
+    auto member = findMember(parent, token.key);
+    if (member != parent.MemberEnd()) {
+      member->value.Swap(value);
+      undo.push_back({Undo::Kind::Restore, &path, 0, false, std::move(value)});
+      return;
+    }
+
+    insertMember(parent, parent.MemberCount(), token.key, value, allocator);
+    undo.push_back({Undo::Kind::Erase, &path, parent.MemberCount() - 1, false, rapidjson::Value()});
+  }
+
+  rapidjson::Value JsonPatch::take(rapidjson::Value& root, const JsonPath& path, bool carry, std::vector<Undo>& undo)
+  {
+    if (path._tokens.empty())
+      throw JsonPatchException("JSON patch cannot remove the document root");
+
+    rapidjson::Value& parent = parentOf(root, path);
+    const JsonPath::Token& token = path._tokens.back();
+
+    uint32_t position;
+    if (parent.IsArray())
+    {
+      if (token.index == JsonPath::NO_INDEX || token.index >= parent.Size())
+        throw JsonPatchException("JSON patch target does not exist: " + path.pointer());
+      position = token.index;
+    }
+    else
+    {
+      auto member = findMember(parent, token.key);
+      if (member == parent.MemberEnd())
+        throw JsonPatchException("JSON patch target does not exist: " + path.pointer());
+      position = static_cast<uint32_t>(member - parent.MemberBegin());
+    }
+
+    rapidjson::Value removed = eraseAt(parent, position);
+    if (carry) {
+      undo.push_back({Undo::Kind::Insert, &path, position, true, rapidjson::Value()});
+      return removed;
+    }
+
+    undo.push_back({Undo::Kind::Insert, &path, position, false, std::move(removed)});
+    return rapidjson::Value();
+  }
+}
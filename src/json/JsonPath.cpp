@@ -0,0 +1,160 @@
+#include "JsonPath.h"
+#include "JsonDocument.h"
+#include "Exceptions.h"
+#include <cstring>
+
+namespace mgutils
+{
+  JsonPath JsonPath::compile(const std::string& pointer)
+  {
+    JsonPath path;
+    path._pointer = pointer;
+
+    if (pointer.empty())
+      return path;
+
+    if (pointer[0] != '/')
+      throw JsonUsageException("JSON pointer must start with '/': " + pointer);
+
+    size_t pos = 1;
+    while (true)
+    {
+      size_t end = pointer.find('/', pos);
+      if (end == std::string::npos)
+        end = pointer.size();
+
+      Token token{std::string(), NO_INDEX, false, false};
+      token.key.reserve(end - pos);
+
+      for (size_t i = pos; i < end; ++i)
+      {
+        if (pointer[i] != '~') {
+          token.key.push_back(pointer[i]);
+          continue;
+        }
+
+        char escaped = i + 1 < end ? pointer[i + 1] : '\0';
+        if (escaped == '0') {
+          token.key.push_back('~');
+        } else if (escaped == '1') {
+          token.key.push_back('/');
+        } else {
+          throw JsonUsageException("Invalid escape in JSON pointer: " + pointer);
+        }
+        ++i;
+      }
+
+      const std::string& key = token.key;
+      if (key == "*") {
+        token.wildcard = true;
+        path._hasWildcard = true;
+      } else if (key == "-") {
+        token.append = true;
+      } else if (!key.empty() && key.size() <= 9 && (key == "0" || key[0] != '0') &&
+                 key.find_first_not_of("0123456789") == std::string::npos) {
+        token.index = static_cast<uint32_t>(std::stoul(key));
+      }
+
+      path._tokens.push_back(std::move(token));
+
+      if (end == pointer.size())
+        break;
+      pos = end + 1;
+    }
+
+    return path;
+  }
+
+  const rapidjson::Value* JsonPath::step(const rapidjson::Value& value, const Token& token, bool sortedKeys)
+  {
+    if (value.IsArray())
+    {
+      if (token.index == NO_INDEX || token.index >= value.Size())
+        return nullptr;
+      return &value[token.index];
+    }
+
+    if (!value.IsObject())
+      return nullptr;
+
+    if (sortedKeys)
+      return json::findMemberSorted(value, token.key);
+
+    // Compare lengths before bytes; most non-matching keys are rejected without touching their text
+    const size_t length = token.key.size();
+    const char* key = token.key.data();
+    for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it)
+    {
+      if (it->name.GetStringLength() == length && std::memcmp(it->name.GetString(), key, length) == 0)
+        return &it->value;
+    }
+
+    return nullptr;
+  }
+
+  void JsonPath::collect(const rapidjson::Value& value, size_t tokenIndex, bool sortedKeys, std::vector<JsonView>& out) const
+  {
+    const rapidjson::Value* current = &value;
+
+    for (; tokenIndex < _tokens.size(); ++tokenIndex)
+    {
+      const Token& token = _tokens[tokenIndex];
+      if (token.wildcard)
+      {
+        if (current->IsArray()) {
+          for (const auto& element : current->GetArray())
+            collect(element, tokenIndex + 1, sortedKeys, out);
+        } else if (current->IsObject()) {
+          for (auto it = current->MemberBegin(); it != current->MemberEnd(); ++it)
+            collect(it->value, tokenIndex + 1, sortedKeys, out);
+        }
+        return;
+      }
+
+      current = step(*current, token, sortedKeys);
+      if (!current)
+        return;
+    }
+
+    out.push_back(JsonView(*current, sortedKeys));
+  }
+
+  std::optional<JsonView> JsonPath::evaluate(const JsonView& root) const
+  {
+    if (_hasWildcard)
+    {
+      std::vector<JsonView> matches;
+      collect(*root._value, 0, root._sortedKeys, matches);
+      if (matches.empty())
+        return std::nullopt;
+      return matches.front();
+    }
+
+    const rapidjson::Value* current = root._value;
+    for (const auto& token : _tokens)
+    {
+      current = step(*current, token, root._sortedKeys);
+      if (!current)
+        return std::nullopt;
+    }
+
+    return JsonView(*current, root._sortedKeys);
+  }
+
+  std::optional<JsonView> JsonPath::evaluate(const JsonDocument& document) const
+  {
+    return evaluate(document.view());
+  }
+
+  size_t JsonPath::evaluateAll(const JsonView& root, std::vector<JsonView>& out) const
+  {
+    out.clear();
+    collect(*root._value, 0, root._sortedKeys, out);
+    return out.size();
+  }
+
+  size_t JsonPath::evaluateAll(const JsonDocument& document, std::vector<JsonView>& out) const
+  {
+    return evaluateAll(document.view(), out);
+  }
+}
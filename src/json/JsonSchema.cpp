@@ -0,0 +1,116 @@
+#include "JsonSchema.h"
+#include "JsonDocument.h"
+#include "Exceptions.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/stringbuffer.h"
+
+namespace mgutils
+{
+  namespace
+  {
+    rapidjson::Document copyOf(const rapidjson::Value& value)
+    {
+      rapidjson::Document document;
+      document.CopyFrom(value, document.GetAllocator(), true);
+      return document;
+    }
+
+    // Names listed by a "required" failure, e.g. " (missing: s, p)"
+    std::string missingMembers(const rapidjson::Value& error)
+    {
+      if (!error.IsObject())
+        return {};
+      auto required = error.FindMember("required");
+      if (required == error.MemberEnd() || !required->value.IsObject())
+        return {};
+      auto missing = required->value.FindMember("missing");
+      if (missing == required->value.MemberEnd() || !missing->value.IsArray())
+        return {};
+
+      std::string names;
+      for (const auto& name : missing->value.GetArray())
+      {
+        if (!name.IsString())
+          continue;
+        names += names.empty() ? " (missing: " : ", ";
+        names.append(name.GetString(), name.GetStringLength());
+      }
+      return names.empty() ? names : names + ")";
+    }
+
+    // Works for both SchemaValidator and SchemaValidatingReader, which report failures the same way
+    template <typename Validator>
+    [[noreturn]] void throwInvalid(const Validator& validator)
+    {
+      rapidjson::StringBuffer instance;
+      validator.GetInvalidDocumentPointer().Stringify(instance);
+      rapidjson::StringBuffer schema;
+      validator.GetInvalidSchemaPointer().StringifyUriFragment(schema);
+
+      std::string instancePath(instance.GetString(), instance.GetSize());
+      std::string schemaPath(schema.GetString(), schema.GetSize());
+      std::string keyword(validator.GetInvalidSchemaKeyword());
+
+      std::string message = "JSON schema validation failed: '" + keyword + "' at '" + instancePath + "'" +
+                            missingMembers(validator.GetError()) + " (schema " + schemaPath + ")";
+      throw JsonValidationException(message, std::move(instancePath), std::move(schemaPath), std::move(keyword));
+    }
+  }
+
+  JsonSchema::JsonSchema(const rapidjson::Value& schema):
+      _source(copyOf(schema)),
+      _schema(_source)
+  {}
+
+  std::shared_ptr<const JsonSchema> JsonSchema::compile(const JsonView& schema)
+  {
+    if (!schema.isObject())
+      throw JsonUsageException("JSON schema must be an object");
+    return std::shared_ptr<const JsonSchema>(new JsonSchema(*schema._value));
+  }
+
+  std::shared_ptr<const JsonSchema> JsonSchema::compile(const std::string& schema)
+  {
+    rapidjson::Document document;
+    document.Parse(schema.c_str(), schema.size());
+    if (document.HasParseError())
+      throw JsonParseException("Failed to parse JSON schema: " + schema);
+    return compile(JsonView(document));
+  }
+
+  std::shared_ptr<JsonDocument> JsonSchema::parse(const std::string& json) const
+  {
+    return parse(json.data(), json.length());
+  }
+
+  std::shared_ptr<JsonDocument> JsonSchema::parse(const char* json, size_t length) const
+  {
+    rapidjson::MemoryStream stream(json, length);
+    rapidjson::SchemaValidatingReader<rapidjson::kParseDefaultFlags, rapidjson::MemoryStream, rapidjson::UTF8<>> reader(stream, _schema);
+
+    std::shared_ptr<JsonDocument> document(new JsonDocument());
+    document->_document.Populate(reader);
+
+    if (!reader.GetParseResult())
+    {
+      if (!reader.IsValid())
+        throwInvalid(reader);
+      throw JsonParseException("Failed to parse JSON content: " + std::string(json, length));
+    }
+
+    return document;
+  }
+
+  void JsonSchema::validate(const JsonView& value) const
+  {
+    rapidjson::SchemaValidator validator(_schema);
+    if (!value._value->Accept(validator))
+      throwInvalid(validator);
+  }
+
+  bool JsonSchema::isValid(const JsonView& value) const
+  {
+    rapidjson::SchemaValidator validator(_schema);
+    return value._value->Accept(validator);
+  }
+}
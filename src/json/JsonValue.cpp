@@ -13,6 +13,9 @@ namespace mgutils
   JsonValue::JsonValue(const rapidjson::Value& value, rapidjson::Document::AllocatorType& allocator):
       _value(value, allocator),_allocator(allocator) {}
 
+  JsonValue::JsonValue(rapidjson::Value&& value, rapidjson::Document::AllocatorType& allocator):
+      _value(std::move(value)),_allocator(allocator) {}
+
   // Movement constructor
   JsonValue::JsonValue(JsonValue&& other) noexcept:
       _value(std::move(other._value)), _allocator(other._allocator){}
@@ -225,9 +228,29 @@ namespace mgutils
     throw JsonUsageException("Key not found or not an array: " + key);
   }
 
+  const rapidjson::Value& JsonValue::arrayMember(const std::string& key) const
+  {
+    if (_value.IsObject())
+    {
+      auto it = _value.FindMember(key.c_str());
+      if (it != _value.MemberEnd() && it->value.IsArray())
+        return it->value;
+    }
+    throw JsonUsageException("Key not found or not an array: " + key);
+  }
+
+  const rapidjson::Value& JsonValue::asArray() const
+  {
+    if (!_value.IsArray())
+      throw JsonUsageException("JsonValue is not an array");
+    return _value;
+  }
+
   JsonValue& JsonValue::setObject(const std::string& key, const JsonValue& objectValue)
   {
-    rapidjson::Value obj(objectValue._value, _allocator);
+    // Strings referenced rather than owned (a string pool, an in situ mapping) belong to the other
+    // document, so the copy takes its own
+    rapidjson::Value obj(objectValue._value, _allocator, true);
 
     if (_value.HasMember(key.c_str())) {
       _value[key.c_str()] = obj;
@@ -242,38 +265,68 @@ namespace mgutils
   JsonValue& JsonValue::setVector(const std::string& key, std::vector<JsonValue>& values)
   {
     rapidjson::Value array(rapidjson::kArrayType);
-    for (auto& val : values) {
-      array.PushBack(val._value, _allocator);
+    appendValues(array, values);
+    return setMember(key, array);
+  }
+
+  JsonValue& JsonValue::setVector(const std::string& key, std::vector<JsonValue>&& values)
+  {
+    rapidjson::Value array(rapidjson::kArrayType);
+    appendValues(array, values);
+    return setMember(key, array);
+  }
+
+  JsonValue& JsonValue::set(const std::string& key, JsonValue&& value)
+  {
+    if (!_value.IsObject()) {
+      _value.SetObject();
     }
 
-    if (_value.HasMember(key.c_str())) {
-      _value[key.c_str()] = array;
-    } else {
-      rapidjson::Value name(key.c_str(), _allocator);
-      _value.AddMember(name, array, _allocator);
+    rapidjson::Value member = value.release(_allocator);
+    return setMember(key, member);
+  }
+
+  JsonValue& JsonValue::set(const std::string& key, std::vector<JsonValue>&& values)
+  {
+    if (!_value.IsObject()) {
+      _value.SetObject();
     }
 
-    return *this;
+    return setVector(key, std::move(values));
   }
 
-  JsonValue& JsonValue::setVector(const std::string& key, std::vector<JsonValue>&& values)
+  rapidjson::Value JsonValue::release(rapidjson::Document::AllocatorType& target)
   {
-    rapidjson::Value array(rapidjson::kArrayType);
+    if (&_allocator == &target)
+      return std::move(_value);
 
-    for (auto& val : values) {
-      array.PushBack(val._value, _allocator);
-    }
+    rapidjson::Value copy(_value, target, true);
+    _value.SetNull();
+    return copy;
+  }
 
-    if (_value.HasMember(key.c_str())) {
-      _value[key.c_str()] = array;
+  JsonValue& JsonValue::setMember(const std::string& key, rapidjson::Value& value)
+  {
+    auto it = _value.FindMember(key.c_str());
+    if (it != _value.MemberEnd()) {
+      it->value = value;
     } else {
-      rapidjson::Value name(key.c_str(), _allocator);
-      _value.AddMember(name, array, _allocator);
+      rapidjson::Value name(key.c_str(), static_cast<rapidjson::SizeType>(key.size()), _allocator);
+      _value.AddMember(name, value, _allocator);
     }
 
     return *this;
   }
 
+  void JsonValue::appendValues(rapidjson::Value& array, std::vector<JsonValue>& values)
+  {
+    array.Reserve(static_cast<rapidjson::SizeType>(values.size()), _allocator);
+    for (auto& val : values) {
+      rapidjson::Value element = val.release(_allocator);
+      array.PushBack(element, _allocator);
+    }
+  }
+
   JsonValue& JsonValue::setBool(const std::string& key, bool boolValue)
   {
     rapidjson::Value name(key.c_str(), _allocator);
@@ -407,7 +460,7 @@ namespace mgutils
     return std::nullopt;
   }
 
-  std::optional<double> JsonValue::asUint() const
+  std::optional<unsigned> JsonValue::asUint() const
   {
     if (_value.IsUint()) {
       return _value.GetUint();
@@ -415,7 +468,7 @@ namespace mgutils
     return std::nullopt;
   }
 
-  std::optional<double> JsonValue::asUint64() const
+  std::optional<uint64_t> JsonValue::asUint64() const
   {
     if (_value.IsUint64()) {
       return _value.GetUint64();
@@ -0,0 +1,216 @@
+#include "JsonView.h"
+#include "Exceptions.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace mgutils
+{
+  const rapidjson::Value* JsonView::member(std::string_view key) const
+  {
+    if (!_value->IsObject())
+      return nullptr;
+
+    if (_sortedKeys)
+      return json::findMemberSorted(*_value, key);
+
+    rapidjson::Value name(rapidjson::StringRef(key.data(), key.size()));
+    auto it = _value->FindMember(name);
+    if (it == _value->MemberEnd())
+      return nullptr;
+
+    return &it->value;
+  }
+
+  const rapidjson::Value& JsonView::arrayMember(std::string_view key) const
+  {
+    auto value = member(key);
+    if (!value || !value->IsArray())
+      throw JsonUsageException("Key not found or not an array: " + std::string(key));
+    return *value;
+  }
+
+  const rapidjson::Value& JsonView::asArray() const
+  {
+    if (!_value->IsArray())
+      throw JsonUsageException("JsonView is not an array");
+    return *_value;
+  }
+
+  bool JsonView::isEmpty() const
+  {
+    if (_value->IsObject()) {
+      return _value->ObjectEmpty();
+    } else if (_value->IsArray()) {
+      return _value->Empty();
+    }
+
+    return false;
+  }
+
+  bool JsonView::hasBool(std::string_view key) const
+  {
+    auto value = member(key);
+    return value && value->IsBool();
+  }
+
+  bool JsonView::hasNumber(std::string_view key) const
+  {
+    auto value = member(key);
+    return value && value->IsNumber();
+  }
+
+  bool JsonView::hasString(std::string_view key) const
+  {
+    auto value = member(key);
+    return value && value->IsString();
+  }
+
+  bool JsonView::hasObject(std::string_view key) const
+  {
+    auto value = member(key);
+    return value && value->IsObject();
+  }
+
+  bool JsonView::hasArray(std::string_view key) const
+  {
+    auto value = member(key);
+    return value && value->IsArray();
+  }
+
+  std::optional<std::string_view> JsonView::getString(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value).asString();
+    return std::nullopt;
+  }
+
+  std::optional<int> JsonView::getInt(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value).asInt();
+    return std::nullopt;
+  }
+
+  std::optional<unsigned> JsonView::getUint(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value).asUint();
+    return std::nullopt;
+  }
+
+  std::optional<int64_t> JsonView::getInt64(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value).asInt64();
+    return std::nullopt;
+  }
+
+  std::optional<uint64_t> JsonView::getUint64(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value).asUint64();
+    return std::nullopt;
+  }
+
+  std::optional<bool> JsonView::getBool(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value).asBool();
+    return std::nullopt;
+  }
+
+  std::optional<double> JsonView::getDouble(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value).asDouble();
+    return std::nullopt;
+  }
+
+  std::optional<std::string_view> JsonView::asString() const
+  {
+    if (_value->IsString())
+      return std::string_view(_value->GetString(), _value->GetStringLength());
+    return std::nullopt;
+  }
+
+  std::optional<int> JsonView::asInt() const
+  {
+    if (_value->IsInt())
+      return _value->GetInt();
+    return std::nullopt;
+  }
+
+  std::optional<unsigned> JsonView::asUint() const
+  {
+    if (_value->IsUint())
+      return _value->GetUint();
+    return std::nullopt;
+  }
+
+  std::optional<int64_t> JsonView::asInt64() const
+  {
+    if (_value->IsInt64())
+      return _value->GetInt64();
+    return std::nullopt;
+  }
+
+  std::optional<uint64_t> JsonView::asUint64() const
+  {
+    if (_value->IsUint64())
+      return _value->GetUint64();
+    return std::nullopt;
+  }
+
+  std::optional<bool> JsonView::asBool() const
+  {
+    if (_value->IsBool())
+      return _value->GetBool();
+    return std::nullopt;
+  }
+
+  std::optional<double> JsonView::asDouble() const
+  {
+    // Any number converts, integers included
+    if (_value->IsNumber())
+      return _value->GetDouble();
+    return std::nullopt;
+  }
+
+  std::optional<JsonView> JsonView::get(std::string_view key) const
+  {
+    if (auto value = member(key))
+      return JsonView(*value, _sortedKeys);
+    return std::nullopt;
+  }
+
+  std::optional<JsonView> JsonView::at(size_t index) const
+  {
+    if (_value->IsArray() && index < _value->Size())
+      return JsonView((*_value)[static_cast<rapidjson::SizeType>(index)], _sortedKeys);
+    return std::nullopt;
+  }
+
+  size_t JsonView::size() const
+  {
+    if (_value->IsObject()) {
+      return _value->MemberCount();
+    } else if (_value->IsArray()) {
+      return _value->Size();
+    }
+    return 0;
+  }
+
+  std::string JsonView::toString(bool pretty) const
+  {
+    rapidjson::StringBuffer buffer;
+    if (pretty) {
+      rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+      _value->Accept(writer);
+    } else {
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      _value->Accept(writer);
+    }
+    return {buffer.GetString(), buffer.GetSize()};
+  }
+}
@@ -0,0 +1,574 @@
+#include "LazyJson.h"
+#include "Exceptions.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+#include <cstring>
+#include <limits>
+
+namespace mgutils
+{
+  namespace
+  {
+    // Receives the single number event of a bare number, so numbers get the exact same
+    // integer/double classification and conversion as a DOM parse
+    struct NumberHandler: rapidjson::BaseReaderHandler<rapidjson::UTF8<>, NumberHandler>
+    {
+      rapidjson::Value value;
+
+      bool Int(int i) { value.SetInt(i); return true; }
+      bool Uint(unsigned u) { value.SetUint(u); return true; }
+      bool Int64(int64_t i) { value.SetInt64(i); return true; }
+      bool Uint64(uint64_t u) { value.SetUint64(u); return true; }
+      bool Double(double d) { value.SetDouble(d); return true; }
+    };
+
+    bool isDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    void appendUtf8(char*& out, unsigned code)
+    {
+      if (code < 0x80) {
+        *out++ = static_cast<char>(code);
+      } else if (code < 0x800) {
+        *out++ = static_cast<char>(0xc0 | (code >> 6));
+        *out++ = static_cast<char>(0x80 | (code & 0x3f));
+      } else if (code < 0x10000) {
+        *out++ = static_cast<char>(0xe0 | (code >> 12));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (code & 0x3f));
+      } else {
+        *out++ = static_cast<char>(0xf0 | (code >> 18));
+        *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (code & 0x3f));
+      }
+    }
+  }
+
+  // LazyJson
+
+  LazyJson::LazyJson(std::string json): _text(std::move(json)) {}
+
+  std::shared_ptr<LazyJson> LazyJson::parse(std::string json)
+  {
+    std::shared_ptr<LazyJson> document(new LazyJson(std::move(json)));
+    document->scan();
+    return document;
+  }
+
+  std::shared_ptr<LazyJson> LazyJson::parse(const char* json, size_t length)
+  {
+    return parse(std::string(json, length));
+  }
+
+  void LazyJson::fail(size_t pos, const std::string& reason) const
+  {
+    throw JsonParseException("Failed to parse JSON content at offset " + std::to_string(pos) + ": " + reason);
+  }
+
+  void LazyJson::scan()
+  {
+    if (_text.size() >= std::numeric_limits<uint32_t>::max())
+      fail(0, "input larger than 4 GB");
+
+    enum class Expect { Value, ValueOrEnd, Key, KeyOrEnd, Colon, CommaOrEnd, Done };
+
+    // Tokens are about one per 6 bytes of typical messages
+    _tape.clear();
+    _tape.reserve(_text.size() / 6 + 4);
+
+    std::vector<uint32_t> open; // tape indices of the containers being scanned
+    const char* text = _text.data();
+    const size_t size = _text.size();
+    Expect expect = Expect::Value;
+    size_t pos = 0;
+
+    auto close = [&]() {
+      _tape[open.back()].next = static_cast<uint32_t>(_tape.size());
+      open.pop_back();
+      ++pos;
+      expect = open.empty() ? Expect::Done : Expect::CommaOrEnd;
+    };
+
+    auto literal = [&](const char* word, size_t length, TokenType type) {
+      if (_text.compare(pos, length, word) != 0)
+        fail(pos, "invalid literal");
+      _tape.push_back({static_cast<uint32_t>(pos), static_cast<uint32_t>(length), static_cast<uint32_t>(_tape.size() + 1), type});
+      pos += length;
+    };
+
+    while (true)
+    {
+      while (pos < size && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t'))
+        ++pos;
+      if (pos == size)
+        break;
+
+      const char c = text[pos];
+      switch (expect)
+      {
+        case Expect::Done:
+          fail(pos, "unexpected characters after the root value");
+
+        case Expect::Colon:
+          if (c != ':')
+            fail(pos, "expected ':'");
+          ++pos;
+          expect = Expect::Value;
+          continue;
+
+        case Expect::CommaOrEnd:
+        {
+          const TokenType container = _tape[open.back()].type;
+          if (c == ',') {
+            ++pos;
+            expect = container == TokenType::Object ? Expect::Key : Expect::Value;
+          } else if ((c == '}' && container == TokenType::Object) || (c == ']' && container == TokenType::Array)) {
+            close();
+          } else {
+            fail(pos, "expected ',' or a closing bracket");
+          }
+          continue;
+        }
+
+        case Expect::KeyOrEnd:
+          if (c == '}') {
+            close();
+            continue;
+          }
+          [[fallthrough]];
+        case Expect::Key:
+          if (c != '"')
+            fail(pos, "expected an object key");
+          ++_tape[open.back()].length;
+          scanString(pos);
+          expect = Expect::Colon;
+          continue;
+
+        case Expect::ValueOrEnd:
+          if (c == ']') {
+            close();
+            continue;
+          }
+          [[fallthrough]];
+        case Expect::Value:
+          break;
+      }
+
+      if (!open.empty() && _tape[open.back()].type == TokenType::Array)
+        ++_tape[open.back()].length;
+
+      switch (c)
+      {
+        case '{':
+        case '[':
+          open.push_back(static_cast<uint32_t>(_tape.size()));
+          _tape.push_back({static_cast<uint32_t>(pos), 0, 0, c == '{' ? TokenType::Object : TokenType::Array});
+          ++pos;
+          expect = c == '{' ? Expect::KeyOrEnd : Expect::ValueOrEnd;
+          continue;
+        case '"':
+          scanString(pos);
+          break;
+        case 't':
+          literal("true", 4, TokenType::True);
+          break;
+        case 'f':
+          literal("false", 5, TokenType::False);
+          break;
+        case 'n':
+          literal("null", 4, TokenType::Null);
+          break;
+        default:
+          if (c != '-' && !isDigit(c))
+            fail(pos, "unexpected character");
+          scanNumber(pos);
+          break;
+      }
+
+      expect = open.empty() ? Expect::Done : Expect::CommaOrEnd;
+    }
+
+    if (expect != Expect::Done)
+      fail(pos, "unexpected end of input");
+  }
+
+  void LazyJson::scanString(size_t& pos)
+  {
+    char* text = _text.data();
+    const size_t size = _text.size();
+    const size_t begin = pos + 1;
+
+    // Fast path: most strings have no escapes and are used where they lie
+    size_t read = begin;
+    while (read < size && text[read] != '"' && text[read] != '\\' && static_cast<unsigned char>(text[read]) >= 0x20)
+      ++read;
+
+    // Escapes are decoded in place; the decoded form is never longer than the escaped one
+    char* out = text + read;
+    auto hex4 = [&](size_t at) {
+      if (at + 4 > size)
+        fail(at, "truncated unicode escape");
+      unsigned code = 0;
+      for (size_t i = at; i < at + 4; ++i)
+      {
+        const char h = text[i];
+        code <<= 4;
+        if (isDigit(h)) {
+          code |= h - '0';
+        } else if (h >= 'a' && h <= 'f') {
+          code |= h - 'a' + 10;
+        } else if (h >= 'A' && h <= 'F') {
+          code |= h - 'A' + 10;
+        } else {
+          fail(i, "invalid unicode escape");
+        }
+      }
+      return code;
+    };
+
+    while (true)
+    {
+      if (read >= size)
+        fail(pos, "unterminated string");
+
+      const char c = text[read];
+      if (c == '"')
+        break;
+      if (static_cast<unsigned char>(c) < 0x20)
+        fail(read, "control character in string");
+      if (c != '\\') {
+        *out++ = c;
+        ++read;
+        continue;
+      }
+
+      if (read + 1 >= size)
+        fail(pos, "unterminated string");
+      const char escaped = text[read + 1];
+      read += 2;
+      switch (escaped)
+      {
+        case '"': *out++ = '"'; break;
+        case '\\': *out++ = '\\'; break;
+        case '/': *out++ = '/'; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u':
+        {
+          unsigned code = hex4(read);
+          read += 4;
+          if (code >= 0xd800 && code <= 0xdbff)
+          {
+            if (read + 2 > size || text[read] != '\\' || text[read + 1] != 'u')
+              fail(read, "unpaired surrogate");
+            unsigned low = hex4(read + 2);
+            if (low < 0xdc00 || low > 0xdfff)
+              fail(read, "invalid low surrogate");
+            read += 6;
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          }
+          else if (code >= 0xdc00 && code <= 0xdfff)
+          {
+            fail(read, "unpaired surrogate");
+          }
+          appendUtf8(out, code);
+          break;
+        }
+        default:
+          fail(read - 1, "invalid escape");
+      }
+    }
+
+    const auto length = static_cast<uint32_t>(out - (text + begin));
+    _tape.push_back({static_cast<uint32_t>(begin), length, static_cast<uint32_t>(_tape.size() + 1), TokenType::String});
+    pos = read + 1;
+  }
+
+  void LazyJson::scanNumber(size_t& pos)
+  {
+    const char* text = _text.data();
+    const size_t size = _text.size();
+    const size_t begin = pos;
+
+    auto digits = [&]() {
+      const size_t start = pos;
+      while (pos < size && isDigit(text[pos]))
+        ++pos;
+      if (pos == start)
+        fail(pos, "invalid number");
+    };
+
+    if (text[pos] == '-')
+      ++pos;
+    if (pos < size && text[pos] == '0') {
+      ++pos;
+    } else {
+      digits();
+    }
+    if (pos < size && text[pos] == '.') {
+      ++pos;
+      digits();
+    }
+    if (pos < size && (text[pos] == 'e' || text[pos] == 'E')) {
+      ++pos;
+      if (pos < size && (text[pos] == '+' || text[pos] == '-'))
+        ++pos;
+      digits();
+    }
+
+    _tape.push_back({static_cast<uint32_t>(begin), static_cast<uint32_t>(pos - begin),
+                     static_cast<uint32_t>(_tape.size() + 1), TokenType::Number});
+  }
+
+  // LazyValue
+
+  std::optional<uint32_t> LazyValue::member(std::string_view key) const
+  {
+    const auto& tape = _json->_tape;
+    const auto& object = tape[_index];
+    if (object.type != LazyJson::TokenType::Object)
+      return std::nullopt;
+
+    const char* text = _json->_text.data();
+    uint32_t index = _index + 1;
+    for (uint32_t i = 0; i < object.length; ++i)
+    {
+      const auto& name = tape[index];
+      if (name.length == key.size() && std::memcmp(text + name.begin, key.data(), key.size()) == 0)
+        return index + 1;
+      index = tape[index + 1].next;
+    }
+
+    return std::nullopt;
+  }
+
+  rapidjson::Value LazyValue::scalar() const
+  {
+    const auto& token = _json->_tape[_index];
+    const char* text = _json->_text.data() + token.begin;
+
+    switch (token.type)
+    {
+      case LazyJson::TokenType::False:
+        return rapidjson::Value(false);
+      case LazyJson::TokenType::True:
+        return rapidjson::Value(true);
+      case LazyJson::TokenType::String:
+        return rapidjson::Value(rapidjson::StringRef(text, token.length));
+      case LazyJson::TokenType::Number:
+      {
+        NumberHandler handler;
+        rapidjson::MemoryStream stream(text, token.length);
+        rapidjson::Reader reader;
+        reader.Parse(stream, handler);
+        return std::move(handler.value);
+      }
+      default:
+        return rapidjson::Value();
+    }
+  }
+
+  bool LazyValue::hasBool(std::string_view key) const
+  {
+    auto index = member(key);
+    return index && LazyValue(*_json, *index).asBool().has_value();
+  }
+
+  bool LazyValue::hasNumber(std::string_view key) const
+  {
+    auto index = member(key);
+    return index && _json->_tape[*index].type == LazyJson::TokenType::Number;
+  }
+
+  bool LazyValue::hasString(std::string_view key) const
+  {
+    auto index = member(key);
+    return index && _json->_tape[*index].type == LazyJson::TokenType::String;
+  }
+
+  bool LazyValue::hasObject(std::string_view key) const
+  {
+    auto index = member(key);
+    return index && _json->_tape[*index].type == LazyJson::TokenType::Object;
+  }
+
+  bool LazyValue::hasArray(std::string_view key) const
+  {
+    auto index = member(key);
+    return index && _json->_tape[*index].type == LazyJson::TokenType::Array;
+  }
+
+  std::optional<std::string> LazyValue::getString(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).asString();
+    return std::nullopt;
+  }
+
+  std::optional<int> LazyValue::getInt(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).asInt();
+    return std::nullopt;
+  }
+
+  std::optional<unsigned> LazyValue::getUint(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).asUint();
+    return std::nullopt;
+  }
+
+  std::optional<int64_t> LazyValue::getInt64(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).as<int64_t>();
+    return std::nullopt;
+  }
+
+  std::optional<uint64_t> LazyValue::getUint64(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).asUint64();
+    return std::nullopt;
+  }
+
+  std::optional<bool> LazyValue::getBool(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).asBool();
+    return std::nullopt;
+  }
+
+  std::optional<float> LazyValue::getFloat(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).asFloat();
+    return std::nullopt;
+  }
+
+  std::optional<double> LazyValue::getDouble(std::string_view key) const
+  {
+    if (auto index = member(key))
+      return LazyValue(*_json, *index).asDouble();
+    return std::nullopt;
+  }
+
+  std::optional<std::string> LazyValue::asString() const
+  {
+    const auto& token = _json->_tape[_index];
+    if (token.type == LazyJson::TokenType::String)
+      return std::string(_json->_text.data() + token.begin, token.length);
+    return std::nullopt;
+  }
+
+  std::optional<int> LazyValue::asInt() const
+  {
+    rapidjson::Value value = scalar();
+    if (value.IsInt())
+      return value.GetInt();
+    return std::nullopt;
+  }
+
+  std::optional<bool> LazyValue::asBool() const
+  {
+    const auto type = _json->_tape[_index].type;
+    if (type == LazyJson::TokenType::True || type == LazyJson::TokenType::False)
+      return type == LazyJson::TokenType::True;
+    return std::nullopt;
+  }
+
+  std::optional<float> LazyValue::asFloat() const
+  {
+    rapidjson::Value value = scalar();
+    if (value.IsFloat())
+      return value.GetFloat();
+    return std::nullopt;
+  }
+
+  std::optional<double> LazyValue::asDouble() const
+  {
+    rapidjson::Value value = scalar();
+    if (value.IsDouble())
+      return value.GetDouble();
+    return std::nullopt;
+  }
+
+  std::optional<unsigned> LazyValue::asUint() const
+  {
+    rapidjson::Value value = scalar();
+    if (value.IsUint())
+      return value.GetUint();
+    return std::nullopt;
+  }
+
+  std::optional<uint64_t> LazyValue::asUint64() const
+  {
+    rapidjson::Value value = scalar();
+    if (value.IsUint64())
+      return value.GetUint64();
+    return std::nullopt;
+  }
+
+  bool LazyValue::isNull() const
+  {
+    return _json->_tape[_index].type == LazyJson::TokenType::Null;
+  }
+
+  bool LazyValue::isEmpty() const
+  {
+    const auto& token = _json->_tape[_index];
+    if (token.type == LazyJson::TokenType::Object || token.type == LazyJson::TokenType::Array)
+      return token.length == 0;
+    return false;
+  }
+
+  LazyValue LazyValue::getObject(std::string_view key) const
+  {
+    auto index = member(key);
+    if (index && _json->_tape[*index].type == LazyJson::TokenType::Object)
+      return LazyValue(*_json, *index);
+
+    throw JsonParseException("Key not found or not an object");
+  }
+
+  std::vector<LazyValue> LazyValue::getArray(std::string_view key) const
+  {
+    auto index = member(key);
+    if (!index || _json->_tape[*index].type != LazyJson::TokenType::Array)
+      throw JsonUsageException("Key not found or not an array: " + std::string(key));
+    return LazyValue(*_json, *index).getArray();
+  }
+
+  std::vector<LazyValue> LazyValue::getArray() const
+  {
+    const auto& tape = _json->_tape;
+    const auto& array = tape[_index];
+    if (array.type != LazyJson::TokenType::Array)
+      throw JsonUsageException("LazyValue is not an array");
+
+    std::vector<LazyValue> values;
+    values.reserve(array.length);
+    uint32_t index = _index + 1;
+    for (uint32_t i = 0; i < array.length; ++i)
+    {
+      values.push_back(LazyValue(*_json, index));
+      index = tape[index].next;
+    }
+    return values;
+  }
+
+  size_t LazyValue::size() const
+  {
+    const auto& token = _json->_tape[_index];
+    if (token.type == LazyJson::TokenType::Object || token.type == LazyJson::TokenType::Array)
+      return token.length;
+    return 0;
+  }
+}
@@ -3,9 +3,24 @@
 //
 #include <catch2/catch.hpp>
 #include <mgutils/CsvLoader.h>
+#include <mgutils/csv/CsvWriter.h>
+#include <mgutils/csv/CsvScanner.h>
+#include <mgutils/csv/MappedCsvReader.h>
+#include <mgutils/models/Trade.h>
+#include <mgutils/Utils.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
 #include <string>
 #include <vector>
 
+#ifdef MGUTILS_WITH_ZLIB
+#include <zlib.h>
+#endif
+
 using namespace mgutils;
 
 // Test case for basic operations of CSVLoader
@@ -76,3 +91,741 @@ TEST_CASE("CSV basic tests", "[csv_loader]")
     REQUIRE(allData[0].size() > 0);
   }
 }
+
+TEST_CASE("Memory-mapped CSV reader", "[csv_loader]")
+{
+  SECTION("Same cells as CsvLoader") {
+    CsvLoader loader("resources/test1.csv");
+    MappedCsvReader reader("resources/test1.csv");
+
+    REQUIRE(reader.columnNames() == std::vector<std::string>{"Column1", "Column2", "Column3"});
+    REQUIRE(reader.rowCount() == 3);
+    REQUIRE(reader.getColumn<std::string>("Column1") == loader.getColumn<std::string>("Column1"));
+    REQUIRE(reader.getColumn<int>("Column2") == std::vector<int>{100, 200, 300});
+    REQUIRE(reader.getCell<bool>("Column3", 1) == false);
+    REQUIRE(reader.getCell<std::string_view>(0, 2) == "Value3");
+
+    MappedCsvReader semicolon("resources/test_semicolon.csv", ';');
+    REQUIRE(semicolon.getCell<std::string>("Column1", 0) == "ValueA");
+  }
+
+  SECTION("Quoted fields, CRLF and no header") {
+    {
+      std::ofstream out("mapped_quoted.csv", std::ios::binary);
+      out << "1,\"a,b\",2.5\r\n"
+          << "\n"
+          << "-2,\"say \"\"hi\"\"\",\r\n"
+          << "3,\"multi\nline\",1e-3";
+    }
+
+    MappedCsvReader reader("mapped_quoted.csv", CsvOptions{',', '"', false});
+    REQUIRE(reader.columnNames().empty());
+    REQUIRE(reader.columnCount() == 3);
+    REQUIRE(reader.rowCount() == 3);
+
+    REQUIRE(reader.row(0)[1] == "a,b");
+    REQUIRE(reader.row(0).get<double>(2) == 2.5);
+    REQUIRE(reader.row(1).get<int64_t>(0) == -2);
+    REQUIRE(reader.row(1)[1] == "say \"hi\"");
+    REQUIRE(reader.row(1)[2].empty());
+    REQUIRE(reader.row(2)[1] == "multi\nline");
+    REQUIRE(reader.row(2).get<double>(2) == 0.001);
+    REQUIRE_FALSE(reader.row(1).tryGet<double>(2).has_value());
+  }
+
+  SECTION("Custom quote character") {
+    {
+      std::ofstream out("mapped_single_quoted.csv");
+      out << "name,qty\n'a,b',1\n'it''s',2\n";
+    }
+
+    const CsvOptions options{',', '\''};
+    MappedCsvReader reader("mapped_single_quoted.csv", options);
+    CsvLoader loader("mapped_single_quoted.csv", options);
+    REQUIRE(reader.row(0)[0] == "a,b");
+    REQUIRE(reader.row(1)[0] == "it's");
+    REQUIRE(loader.getCell<std::string>("name", 0) == "a,b");
+    REQUIRE(loader.getColumn<int>("qty") == std::vector<int>{1, 2});
+  }
+
+  SECTION("Errors") {
+    MappedCsvReader reader("resources/test1.csv");
+    REQUIRE_THROWS_AS(reader.columnIndex("InvalidColumn"), CsvUsageException);
+    REQUIRE_THROWS_AS(reader.row(3), CsvUsageException);
+    REQUIRE_THROWS_AS(reader.getCell<int>("Column1", 0), CsvUsageException);
+    REQUIRE_THROWS_AS(MappedCsvReader("resources/missing.csv"), FilesException);
+
+    {
+      std::ofstream out("mapped_ragged.csv");
+      out << "a,b\n1,2\n3\n";
+    }
+    REQUIRE_THROWS_AS(MappedCsvReader("mapped_ragged.csv"), CsvReadException);
+
+    {
+      std::ofstream out("mapped_unterminated.csv");
+      out << "a,b\n1,\"2\n";
+    }
+    REQUIRE_THROWS_AS(MappedCsvReader("mapped_unterminated.csv"), CsvReadException);
+  }
+}
+
+TEST_CASE("Streaming CSV rows", "[csv_loader]")
+{
+  SECTION("Same records as the mapped reader") {
+    MappedCsvReader mapped("resources/test1.csv");
+    auto rows = CsvLoader::rows("resources/test1.csv");
+    REQUIRE(rows.columnNames() == mapped.columnNames());
+
+    size_t count = 0;
+    for (const CsvRow& row : rows)
+    {
+      REQUIRE(row.size() == 3);
+      REQUIRE(row[0] == mapped.row(count)[0]);
+      REQUIRE(row.get<int>(rows.columnIndex("Column2")) == static_cast<int>(100 * (count + 1)));
+      ++count;
+    }
+    REQUIRE(count == 3);
+    REQUIRE(rows.rowCount() == 3);
+  }
+
+  SECTION("Quoted fields crossing block boundaries") {
+    {
+      std::ofstream out("stream_blocks.csv", std::ios::binary);
+      out << "id,text\r\n";
+      for (int i = 0; i < 200; ++i)
+      {
+        std::string text(static_cast<size_t>(i % 37), 'x');
+        out << i << ",\"" << text << ",\"\"q\"\"\n" << "\"\r\n";
+      }
+    }
+
+    // Blocks far smaller than a record force every record through a refill
+    for (size_t blockSize : {1, 7, 64, 4096})
+    {
+      auto rows = CsvLoader::rows("stream_blocks.csv", {}, blockSize);
+      REQUIRE(rows.columnNames() == std::vector<std::string>{"id", "text"});
+
+      int i = 0;
+      for (const CsvRow& row : rows)
+      {
+        REQUIRE(row.get<int>(0) == i);
+        REQUIRE(row[1] == std::string(static_cast<size_t>(i % 37), 'x') + ",\"q\"\n");
+        ++i;
+      }
+      REQUIRE(i == 200);
+    }
+  }
+
+  SECTION("Errors") {
+    REQUIRE_THROWS_AS(CsvLoader::rows("resources/missing.csv"), FilesException);
+
+    {
+      std::ofstream out("stream_unterminated.csv");
+      out << "a,b\n1,\"2\n3,4\n";
+    }
+    auto rows = CsvLoader::rows("stream_unterminated.csv", {}, 4);
+    REQUIRE_THROWS_AS(rows.next(), CsvReadException);
+  }
+}
+
+TEST_CASE("Parallel CSV loading", "[csv_loader]")
+{
+  // Quoted fields with newlines and delimiters sit right where naive splitting would cut
+  {
+    std::ofstream out("parallel.csv", std::ios::binary);
+    out << "id,note,value\n";
+    for (int i = 0; i < 20000; ++i)
+    {
+      if (i % 3 == 0)
+        out << i << ",\"line\n" << i << ",\"\"x\"\"\n\"," << i * 0.5 << "\n";
+      else
+        out << i << ",plain," << i * 0.5 << "\r\n";
+    }
+  }
+
+  REQUIRE(CsvLoader::readHeader("parallel.csv") == std::vector<std::string>{"id", "note", "value"});
+
+  for (size_t threads : {1, 3, 8, 64})
+  {
+    // Handlers run on worker threads, where Catch assertions are not allowed
+    auto ids = CsvLoader::parallelLoad("parallel.csv", [](const CsvRow& row) {
+      return row.size() == 3 ? row.get<int>(0) : -1;
+    }, threads);
+
+    REQUIRE(ids.size() == 20000);
+    bool ordered = true;
+    for (int i = 0; i < 20000; ++i)
+      ordered = ordered && ids[i] == i;
+    REQUIRE(ordered);
+  }
+
+  auto notes = CsvLoader::parallelLoad("parallel.csv", [](const CsvRow& row) { return std::string(row[1]); }, 8);
+  REQUIRE(notes[3] == "line\n3,\"x\"\n");
+  REQUIRE(notes[4] == "plain");
+
+  {
+    std::ofstream out("parallel_bad.csv");
+    out << "a,b\n1,2\n3,\"4\n";
+  }
+  REQUIRE_THROWS_AS(CsvLoader::parallelLoad("parallel_bad.csv", [](const CsvRow& row) { return row.size(); }),
+                    CsvReadException);
+}
+
+TEST_CASE("Columnar CSV loading", "[csv_loader]")
+{
+  {
+    std::ofstream out("columns.csv", std::ios::binary);
+    out << "source,symbol,price,amount,side,time\r\n";
+    out << "binance,BTCUSDT,61234.5,0.012,B,1718000000000\r\n";
+    out << "binance,\"BTC,USDT\",61234.25,1e-3,S,1718000000150\r\n";
+    out << "\r\n";
+    out << "bybit,BTCUSDT,-0.000125,3,B,-5";
+  }
+
+  auto table = CsvLoader::loadColumns<double, int64_t, std::string, char>("columns.csv", {"price", "time", "symbol", "side"});
+  REQUIRE(table.size() == 3);
+  REQUIRE(table.names()[1] == "time");
+  REQUIRE(table.column<0>() == std::vector<double>{61234.5, 61234.25, -0.000125});
+  REQUIRE(table.column<1>() == std::vector<int64_t>{1718000000000, 1718000000150, -5});
+  REQUIRE(table.column<2>()[1] == "BTC,USDT");
+  REQUIRE(table.column<3>() == std::vector<char>{'B', 'S', 'B'});
+
+  auto amounts = CsvLoader::loadColumns<float>("columns.csv", {"amount"});
+  REQUIRE(amounts.column<0>() == std::vector<float>{0.012f, 0.001f, 3.0f});
+
+  // Same values as the general conversion for the fast float path
+  for (const char* text : {"0.1", "123456789012345", "1234567890123456789", "-0.0", "9007199254740993", "1.5e300", ".5"})
+  {
+    double fast = 0;
+    REQUIRE(csv::parseDouble(text, fast));
+    REQUIRE(fast == std::strtod(text, nullptr));
+  }
+
+  double number = 0;
+  int64_t integer = 0;
+  REQUIRE((csv::parse(std::string_view("+5"), integer) && integer == 5));
+  REQUIRE((csv::parse(std::string_view("+.5e1"), number) && number == 5.0));
+  for (const char* text : {"+-5", "+-5.5e1", "++5", "+", "-+5", "5-", "1e5x"})
+  {
+    REQUIRE_FALSE(csv::parse(std::string_view(text), integer));
+    REQUIRE_FALSE(csv::parse(std::string_view(text), number));
+  }
+  // Failed conversions leave the output alone
+  REQUIRE(integer == 5);
+  REQUIRE(number == 5.0);
+
+  REQUIRE_THROWS_AS(CsvLoader::loadColumns<double>("columns.csv", {"missing"}), CsvUsageException);
+  REQUIRE_THROWS_AS(CsvLoader::loadColumns<int>("columns.csv", {"price"}), CsvUsageException);
+  REQUIRE_THROWS_AS(CsvLoader::loadColumns<double>("columns.csv", {"price"}, CsvOptions{',', '"', false}),
+                    CsvUsageException);
+}
+
+TEST_CASE("CSV struct mapping", "[csv_loader]")
+{
+  using models::Trade;
+
+  // Columns out of declaration order, plus one the struct does not bind
+  {
+    std::ofstream out("trades.csv");
+    out << "time,symbol,price,amount,makerSide,source,id\n";
+    for (int i = 0; i < 10; ++i)
+      out << 1718000000000 + i << ",BTCUSDT," << 61000 + i << ".5,0.25," << (i % 2 ? 'S' : 'B') << ",binance," << i << "\n";
+    out << "1718000000010,ETHUSDT,,,U,bybit,10\n";
+  }
+
+  auto trades = CsvLoader::loadStructs<Trade>("trades.csv");
+  REQUIRE(trades.size() == 11);
+  REQUIRE(trades[0].source == "binance");
+  REQUIRE(trades[0].symbol == "BTCUSDT");
+  REQUIRE(trades[3].price == 61003.5);
+  REQUIRE(trades[3].amount == 0.25);
+  REQUIRE(trades[3].makerSide == models::SELL);
+  REQUIRE(trades[3].time == 1718000000003);
+  // Empty cells keep the member defaults
+  REQUIRE(std::isnan(trades[10].price));
+  REQUIRE(trades[10].source == "bybit");
+
+  std::vector<size_t> batchSizes;
+  int64_t lastTime = 0;
+  CsvLoader::forEachBatch<Trade>("trades.csv", 4, [&](std::vector<Trade>& batch) {
+    batchSizes.push_back(batch.size());
+    lastTime = batch.back().time;
+  });
+  REQUIRE(batchSizes == std::vector<size_t>{4, 4, 3});
+  REQUIRE(lastTime == 1718000000010);
+
+  {
+    std::ofstream out("trades_noheader.csv");
+    out << "binance,BTCUSDT,1.5,2,B,42\n";
+  }
+  auto headerless = CsvLoader::loadStructs<Trade>("trades_noheader.csv", CsvOptions{',', '"', false});
+  REQUIRE(headerless.size() == 1);
+  REQUIRE(headerless[0].time == 42);
+
+  REQUIRE_THROWS_AS(CsvLoader::loadStructs<Trade>("resources/test1.csv"), CsvUsageException);
+  {
+    std::ofstream out("trades_bad.csv");
+    out << "source,symbol,price,amount,makerSide,time\nbinance,BTCUSDT,abc,1,B,1\n";
+  }
+  REQUIRE_THROWS_AS(CsvLoader::loadStructs<Trade>("trades_bad.csv"), CsvUsageException);
+}
+
+TEST_CASE("Buffered CSV writer", "[csv_writer]")
+{
+  using models::Trade;
+
+  std::vector<Trade> trades(1000);
+  for (size_t i = 0; i < trades.size(); ++i)
+  {
+    trades[i].source = "binance";
+    trades[i].symbol = i % 2 ? "BTCUSDT" : "ETH,USDT";
+    trades[i].price = 61000.25 + static_cast<double>(i) / 8;
+    trades[i].amount = 0.1 * static_cast<double>(i);
+    trades[i].makerSide = i % 2 ? 'B' : 'S';
+    trades[i].time = 1718000000000 + static_cast<int64_t>(i);
+  }
+  trades[5].price = dNaN;
+
+  SECTION("Trades round trip through loadStructs") {
+    for (bool background : {false, true})
+    {
+      CsvWriterOptions options;
+      options.append = false;
+      options.background = background;
+      options.bufferSize = 256; // many flushes, and swaps in background mode
+      {
+        CsvWriter writer("writer_trades.csv", options);
+        writer.writeHeader<Trade>();
+        for (const auto& trade : trades)
+          writer.append(trade);
+        REQUIRE(writer.rowCount() == trades.size() + 1);
+      }
+
+      auto loaded = CsvLoader::loadStructs<Trade>("writer_trades.csv");
+      REQUIRE(loaded.size() == trades.size());
+      bool same = true;
+      for (size_t i = 0; i < trades.size(); ++i)
+      {
+        const auto& a = trades[i];
+        const auto& b = loaded[i];
+        same = same && a.source == b.source && a.symbol == b.symbol && a.amount == b.amount &&
+               a.makerSide == b.makerSide && a.time == b.time && (i == 5 || a.price == b.price);
+      }
+      REQUIRE(same);
+      REQUIRE(std::isnan(loaded[5].price));
+    }
+  }
+
+  SECTION("Quoting and appending") {
+    {
+      CsvWriterOptions options;
+      options.append = false;
+      CsvWriter writer("writer_quoting.csv", options);
+      writer.writeRow("plain", "with,comma", "say \"hi\"", "two\nlines", 42, -1.5, true, '\0');
+      writer.field("a").field(std::string("b")).endRow();
+    }
+    {
+      auto rows = CsvLoader::rows("writer_quoting.csv", CsvOptions{',', '"', false});
+      REQUIRE(rows.next());
+      REQUIRE(rows.row().size() == 8);
+      REQUIRE(rows.row()[1] == "with,comma");
+      REQUIRE(rows.row()[2] == "say \"hi\"");
+      REQUIRE(rows.row()[3] == "two\nlines");
+      REQUIRE(rows.row().get<double>(5) == -1.5);
+    }
+    {
+      CsvWriterOptions options;
+      options.quoting = CsvWriterOptions::Quoting::All;
+      options.delimiter = ';';
+      CsvWriter writer("writer_quoting.csv", options);
+      writer.writeRow("x", 1);
+      writer.flush();
+
+      std::ifstream in("writer_quoting.csv");
+      std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      REQUIRE(content == "plain,\"with,comma\",\"say \"\"hi\"\"\",\"two\nlines\",42,-1.5,true,\na,b\n\"x\";1\n");
+    }
+  }
+
+  SECTION("NaN round trips through loadColumns") {
+    {
+      CsvWriterOptions options;
+      options.append = false;
+      CsvWriter writer("writer_nan.csv", options);
+      writer.writeRow("price", "amount");
+      writer.writeRow(1.5, dNaN);
+      writer.writeRow(dNaN, 2.0f);
+    }
+
+    auto table = CsvLoader::loadColumns<double, float>("writer_nan.csv", {"price", "amount"});
+    REQUIRE(table.size() == 2);
+    REQUIRE(table.column<0>()[0] == 1.5);
+    REQUIRE(std::isnan(table.column<0>()[1]));
+    REQUIRE(std::isnan(table.column<1>()[0]));
+    REQUIRE(table.column<1>()[1] == 2.0f);
+
+    double value = 0;
+    REQUIRE(csv::parse(std::string_view("nan"), value));
+    REQUIRE(std::isnan(value));
+  }
+
+  REQUIRE_THROWS_AS(CsvWriter("missing_dir/out.csv"), CsvWriteException);
+}
+
+TEST_CASE("CSV column cache sidecar", "[csv_loader]")
+{
+  const std::string path = "cached.csv";
+  const std::string sidecar = path + ".mgcol";
+  std::remove(sidecar.c_str());
+
+  auto writeSource = [&](const char* flag) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "symbol,price,time,live\n";
+    for (int i = 0; i < 100; ++i)
+      out << "SYM" << i << "," << 100 + i << ".25," << 1718000000000 + i << "," << flag << "\n";
+  };
+  writeSource("1");
+
+  CsvOptions options;
+  options.columnCache = true;
+
+  auto first = CsvLoader::loadColumns<std::string, double, int64_t, bool>(path, {"symbol", "price", "time", "live"}, options);
+  REQUIRE(first.size() == 100);
+  REQUIRE(std::filesystem::exists(sidecar));
+
+  // Same size and mtime but different content: only a load served by the sidecar still sees the old flags
+  const auto mtime = std::filesystem::last_write_time(path);
+  writeSource("0");
+  std::filesystem::last_write_time(path, mtime);
+
+  auto cached = CsvLoader::loadColumns<std::string, double, int64_t, bool>(path, {"symbol", "price", "time", "live"}, options);
+  REQUIRE(cached.column<0>() == first.column<0>());
+  REQUIRE(cached.column<1>() == first.column<1>());
+  REQUIRE(cached.column<2>() == first.column<2>());
+  REQUIRE(cached.column<3>() == std::vector<bool>(100, true));
+
+  // A projection the sidecar lacks is parsed and added next to the cached columns
+  auto symbols = CsvLoader::loadColumns<int64_t>(path, {"time"}, options);
+  REQUIRE(symbols.column<0>() == first.column<2>());
+
+  // A newer mtime invalidates the sidecar
+  std::filesystem::last_write_time(path, mtime + std::chrono::seconds(10));
+  auto fresh = CsvLoader::loadColumns<double, bool>(path, {"price", "live"}, options);
+  REQUIRE(fresh.column<0>() == first.column<1>());
+  REQUIRE(fresh.column<1>() == std::vector<bool>(100, false));
+
+  // Without the option the sidecar is neither read nor needed
+  std::remove(sidecar.c_str());
+  auto plain = CsvLoader::loadColumns<bool>(path, {"live"});
+  REQUIRE(plain.column<0>() == std::vector<bool>(100, false));
+  REQUIRE_FALSE(std::filesystem::exists(sidecar));
+}
+
+TEST_CASE("SIMD CSV scanner", "[csv_loader]")
+{
+  using namespace mgutils::csv;
+
+  std::vector<CsvScanKernel> kernels;
+  for (auto kernel : {CsvScanKernel::Scalar, CsvScanKernel::Sse42, CsvScanKernel::Avx2})
+  {
+    if (scanKernelSupported(kernel))
+      kernels.push_back(kernel);
+  }
+
+  SECTION("Masks and prefix XOR") {
+    REQUIRE(prefixXor(0) == 0);
+    REQUIRE(prefixXor(0b1001) == 0b0111);
+    REQUIRE(prefixXor(uint64_t(1) << 63) == uint64_t(1) << 63);
+
+    std::string text = "a,\"b\nc\",d\n";
+    text.resize(100, 'x');
+    text[70] = ',';
+    for (auto kernel : kernels)
+    {
+      CsvBlockMasks masks[2];
+      REQUIRE(CsvScanner({}, kernel).classify(text.data(), text.size(), masks, 2) == 2);
+      REQUIRE(masks[0].delimiter == ((uint64_t(1) << 1) | (uint64_t(1) << 7)));
+      REQUIRE(masks[0].quote == ((uint64_t(1) << 2) | (uint64_t(1) << 6)));
+      REQUIRE(masks[0].newline == ((uint64_t(1) << 4) | (uint64_t(1) << 9)));
+      REQUIRE(masks[1].delimiter == uint64_t(1) << 6);
+      REQUIRE((masks[1].quote | masks[1].newline) == 0);
+    }
+  }
+
+  SECTION("Same records as the tokenizer") {
+    // Random text over the structural characters, so quotes, CRLF, blank lines and malformed fields
+    // all land on and across block boundaries
+    const char alphabet[] = {'a', 'b', ',', ',', '"', '"', '\n', '\r'};
+    std::mt19937 rng(7);
+
+    auto collect = [](auto&& split) {
+      std::vector<std::vector<std::string>> records;
+      try {
+        split([&](const char* record, const CsvField* fields, size_t count) {
+          std::vector<std::string> cells;
+          for (size_t i = 0; i < count; ++i)
+            cells.emplace_back(record + fields[i].begin, fields[i].end - fields[i].begin);
+          records.push_back(std::move(cells));
+        });
+      } catch (const CsvReadException&) {
+        records.push_back({"<error>"});
+      }
+      return records;
+    };
+
+    for (int round = 0; round < 2000; ++round)
+    {
+      std::string text(rng() % 300, ' ');
+      for (char& c : text)
+        c = alphabet[rng() % sizeof(alphabet)];
+
+      std::string tokenized = text;
+      auto expected = collect([&](auto&& onRecord) {
+        CsvTokenizer tokenizer;
+        std::vector<CsvField> fields;
+        size_t pos = 0;
+        while (pos < tokenized.size())
+        {
+          const size_t start = pos;
+          pos += tokenizer.next(tokenized.data() + pos, tokenized.size() - pos, true, fields);
+          if (!fields.empty())
+            onRecord(tokenized.data() + start, fields.data(), fields.size());
+        }
+      });
+
+      for (auto kernel : kernels)
+      {
+        std::string scanned = text;
+        auto records = collect([&](auto&& onRecord) {
+          CsvScanner({}, kernel).forEachRecord(scanned.data(), 0, scanned.size(),
+                                               [&](size_t start, const CsvField* fields, size_t count) {
+                                                 onRecord(scanned.data() + start, fields, count);
+                                               });
+        });
+        REQUIRE(records == expected);
+      }
+    }
+  }
+
+  SECTION("Malformed records early in a large input") {
+    // A stray quote and a bare CR near the start: only those records go to the tokenizer
+    std::string text = "a,b\"c,d\nx,y,z\n\rp,q,r\n";
+    for (int i = 0; i < 20000; ++i)
+      text += std::to_string(i) + ",\"q,\"\"" + std::to_string(i) + "\"\"\",t\r\n";
+    text += "last,\"unterminated\n";
+
+    for (auto kernel : kernels)
+    {
+      std::string scanned = text;
+      std::vector<std::string> cells;
+      size_t records = 0;
+      auto split = [&] {
+        CsvScanner({}, kernel).forEachRecord(scanned.data(), 0, scanned.size(),
+                                             [&](size_t start, const CsvField* fields, size_t count) {
+                                               ++records;
+                                               for (size_t i = 0; i < count; ++i)
+                                                 cells.emplace_back(scanned.data() + start + fields[i].begin,
+                                                                    fields[i].end - fields[i].begin);
+                                             });
+      };
+      REQUIRE_THROWS_AS(split(), CsvReadException);
+      REQUIRE(records == 20003);
+      REQUIRE(cells[0] == "a");
+      REQUIRE(cells[1] == "b\"c");
+      REQUIRE(cells[3] == "x");
+      REQUIRE(cells[6] == "p");
+      REQUIRE(cells[10] == "q,\"0\"");
+      REQUIRE(cells.back() == "t");
+      REQUIRE(cells[cells.size() - 2] == "q,\"19999\"");
+    }
+  }
+
+  SECTION("Fast path loads") {
+    const std::string path = "scanner.csv";
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out << "symbol,note,price\r\n";
+      for (int i = 0; i < 5000; ++i)
+        out << "SYM" << i % 7 << ",\"say \"\"" << i << "\"\", ok\"," << i << ".5\r\n";
+    }
+
+    MappedCsvReader reader(path);
+    REQUIRE(reader.rowCount() == 5000);
+    REQUIRE(reader.getCell<std::string_view>("note", 1234) == "say \"1234\", ok");
+
+    auto table = CsvLoader::loadColumns<std::string, double>(path, {"note", "price"});
+    REQUIRE(table.size() == 5000);
+    REQUIRE(table.column<0>()[4999] == "say \"4999\", ok");
+    REQUIRE(table.column<1>()[4999] == 4999.5);
+
+    REQUIRE_THROWS_AS(CsvScanner({}, static_cast<CsvScanKernel>(42)), CsvUsageException);
+  }
+}
+
+#ifdef MGUTILS_WITH_ZLIB
+TEST_CASE("Compressed CSV input", "[csv_loader]")
+{
+  using models::Trade;
+
+  std::string text = "source,symbol,price,amount,makerSide,time,note\n";
+  for (int i = 0; i < 5000; ++i)
+  {
+    text += "binance,BTCUSDT," + std::to_string(61000 + i) + ".5,0.25," + (i % 2 ? "S" : "B") + "," +
+            std::to_string(1718000000000 + i) + (i % 7 == 0 ? ",\"two\nlines, \"\"quoted\"\"\"\n" : ",plain\n");
+  }
+  {
+    std::ofstream out("compressed.csv", std::ios::binary);
+    out << text;
+  }
+
+  // Two gzip members, as appending to a .gz produces, split in the middle of a quoted field
+  const size_t split = text.find("two") + 2;
+  gzFile gz = gzopen("compressed.csv.gz", "wb");
+  REQUIRE(gzwrite(gz, text.data(), static_cast<unsigned>(split)) == static_cast<int>(split));
+  gzclose(gz);
+  gz = gzopen("compressed.csv.gz", "ab");
+  REQUIRE(gzwrite(gz, text.data() + split, static_cast<unsigned>(text.size() - split)) ==
+          static_cast<int>(text.size() - split));
+  gzclose(gz);
+
+  REQUIRE(csv::detectCompression("compressed.csv") == csv::CsvCompression::None);
+  REQUIRE(csv::detectCompression("compressed.csv.gz") == csv::CsvCompression::Gzip);
+  REQUIRE(csv::readAll("compressed.csv.gz") == std::vector<char>(text.begin(), text.end()));
+
+  SECTION("Streaming readers") {
+    REQUIRE(CsvLoader::readHeader("compressed.csv.gz") == CsvLoader::readHeader("compressed.csv"));
+
+    // Blocks smaller than a record make the parser wait on the decompression thread
+    for (size_t blockSize : {7, 4096, 1 << 20})
+    {
+      auto plain = CsvLoader::rows("compressed.csv");
+      auto compressed = CsvLoader::rows("compressed.csv.gz", {}, blockSize);
+      while (plain.next())
+      {
+        REQUIRE(compressed.next());
+        REQUIRE(compressed.row()[5] == plain.row()[5]);
+        REQUIRE(compressed.row()[6] == plain.row()[6]);
+      }
+      REQUIRE_FALSE(compressed.next());
+      REQUIRE(compressed.rowCount() == 5000);
+    }
+
+    auto trades = CsvLoader::loadStructs<Trade>("compressed.csv.gz");
+    REQUIRE(trades.size() == 5000);
+    REQUIRE(trades[4999].time == 1718000004999);
+  }
+
+  SECTION("Whole file loaders") {
+    auto notes = CsvLoader::parallelLoad("compressed.csv.gz", [](const CsvRow& row) { return std::string(row[6]); }, 4);
+    REQUIRE(notes == CsvLoader::parallelLoad("compressed.csv", [](const CsvRow& row) { return std::string(row[6]); }, 4));
+    REQUIRE(notes[7] == "two\nlines, \"quoted\"");
+
+    auto compressed = CsvLoader::loadColumns<double, int64_t>("compressed.csv.gz", {"price", "time"});
+    auto plain = CsvLoader::loadColumns<double, int64_t>("compressed.csv", {"price", "time"});
+    REQUIRE(compressed.size() == 5000);
+    REQUIRE(compressed.column<0>() == plain.column<0>());
+    REQUIRE(compressed.column<1>() == plain.column<1>());
+
+    REQUIRE_NOTHROW(CsvLoader("compressed.csv.gz"));
+    REQUIRE_THROWS_AS(MappedCsvReader("compressed.csv.gz"), CsvUsageException);
+  }
+
+  SECTION("Truncated input") {
+    {
+      std::ifstream in("compressed.csv.gz", std::ios::binary);
+      std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      std::ofstream out("truncated.csv.gz", std::ios::binary);
+      out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() / 2));
+    }
+    // Reported wherever the reader is when the decompression thread runs out of input
+    REQUIRE_THROWS_AS([] {
+      for (auto rows = CsvLoader::rows("truncated.csv.gz"); rows.next();) {}
+    }(), CsvReadException);
+    REQUIRE_THROWS_AS(CsvLoader::loadColumns<double>("truncated.csv.gz", {"price"}), CsvReadException);
+  }
+}
+#endif
+
+TEST_CASE("CSV time range index", "[csv_loader]")
+{
+  // Two records per time, so range edges fall between equal times
+  auto writeTrades = [](const std::string& path, int from, int to, std::ios::openmode mode) {
+    std::ofstream out(path, std::ios::binary | mode);
+    if (from == 0)
+      out << "time,price,note\n";
+    for (int i = from; i < to; ++i)
+      out << 1718000000000 + (i / 2) * 100 << "," << i << (i % 5 == 0 ? ",\"a\nb\"\n" : ",x\n");
+  };
+  writeTrades("ranged.csv", 0, 10000, std::ios::trunc);
+  std::remove(CsvTimeIndex::sidecarPath("ranged.csv").c_str());
+
+  REQUIRE_THROWS_AS(CsvLoader::readRange("ranged.csv", 0, 1, [](const CsvRow&) {}), CsvUsageException);
+
+  auto index = CsvTimeIndex::build("ranged.csv", "time", 64);
+  REQUIRE(index.rowCount() == 10000);
+  REQUIRE(index.entries().size() == 157);
+  REQUIRE(std::filesystem::exists(CsvTimeIndex::sidecarPath("ranged.csv")));
+
+  auto prices = [](const std::string& path, int64_t from, int64_t to) {
+    std::vector<int> out;
+    const size_t count = CsvLoader::readRange(path, from, to, [&](const CsvRow& row) { out.push_back(row.get<int>(1)); });
+    REQUIRE(count == out.size());
+    return out;
+  };
+
+  SECTION("Ranges") {
+    for (auto [from, to] : std::vector<std::pair<int, int>>{{0, 10000}, {1000, 1002}, {3198, 3202}, {640, 704}, {9998, 20000}})
+    {
+      std::vector<int> expected;
+      for (int i = from; i < std::min(to, 10000); ++i)
+        expected.push_back(i);
+      REQUIRE(prices("ranged.csv", 1718000000000 + from / 2 * 100, 1718000000000 + to / 2 * 100) == expected);
+    }
+    REQUIRE(prices("ranged.csv", 0, 1718000000000).empty());
+    REQUIRE(prices("ranged.csv", 1718000500000, 1718000600000).empty());
+
+    const size_t count = index.readRange(1718000000000, 1718000000100, [](const CsvRow& row) { REQUIRE(row.size() == 3); });
+    REQUIRE(count == 2);
+  }
+
+  SECTION("Sidecar follows the file") {
+    writeTrades("ranged.csv", 10000, 10100, std::ios::app);
+    REQUIRE_THROWS_AS(index.readRange(0, 1, [](const CsvRow&) {}), CsvUsageException);
+
+    // Indexed again with the recorded column and stride
+    REQUIRE(prices("ranged.csv", 1718000000000 + 5000 * 100, 1718000000000 + 5100 * 100).size() == 100);
+    auto reloaded = CsvTimeIndex::load("ranged.csv");
+    REQUIRE(reloaded.rowCount() == 10100);
+    REQUIRE(reloaded.stride() == 64);
+    REQUIRE(reloaded.timeColumn() == "time");
+  }
+
+  SECTION("Formatted times") {
+    {
+      std::ofstream out("ranged_dates.csv", std::ios::binary);
+      out << "symbol,date\n";
+      for (int minute = 0; minute < 120; ++minute)
+        out << "BTCUSDT,2024-06-10 " << 10 + minute / 60 << ":" << (minute % 60 < 10 ? "0" : "") << minute % 60 << ":30.250\n";
+    }
+    const std::string format = "%Y-%m-%d %H:%M:%S";
+    CsvTimeIndex::build("ranged_dates.csv", "date", 16, format);
+
+    std::vector<std::string> dates;
+    CsvLoader::readRange("ranged_dates.csv", parseDateTimeWithFormat("2024-06-10 11:00:00", format),
+                         parseDateTimeWithFormat("2024-06-10 11:03:00", format),
+                         [&](const CsvRow& row) { dates.emplace_back(row[1]); });
+    REQUIRE(dates == std::vector<std::string>{"2024-06-10 11:00:30.250", "2024-06-10 11:01:30.250", "2024-06-10 11:02:30.250"});
+  }
+
+  SECTION("Errors") {
+    REQUIRE_THROWS_AS(CsvTimeIndex::build("ranged.csv", "missing"), CsvUsageException);
+    REQUIRE_THROWS_AS(CsvTimeIndex::build("ranged.csv", "time", 0), CsvUsageException);
+    REQUIRE_THROWS_AS(CsvTimeIndex::build("ranged.csv", "note", 1), CsvUsageException);
+
+    {
+      std::ofstream out("ranged_unsorted.csv");
+      out << "time,price\n3,1\n2,1\n1,1\n";
+    }
+    REQUIRE_THROWS_AS(CsvTimeIndex::build("ranged_unsorted.csv", "time", 1), CsvUsageException);
+  }
+}
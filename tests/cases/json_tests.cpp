@@ -1,5 +1,9 @@
 #include <catch2/catch.hpp>
 #include "mgutils/Json.h"
+#include "mgutils/Files.h"
+#include "mgutils/models/Trade.h"
+#include <atomic>
+#include <thread>
 
 using namespace mgutils;
 
@@ -279,3 +283,932 @@ TEST_CASE("JSON parse and insert nested object", "[parse, object, nested]")
   REQUIRE(nestedObject.getInt("key2") == std::optional<int>(42));
 }
 
+TEST_CASE("JSON parse memory mapped file", "[parse, mmap]")
+{
+  const std::string filePath = "mapped_test.json";
+  const std::string jsonString = R"({"symbol":"BTCUSDT","levels":[1.5,2.5,3.5],"meta":{"venue":"binance"}})";
+  Files::writeFile(filePath, jsonString);
+
+  SECTION("Copying mode")
+  {
+    auto doc = Json::parseMappedFile(filePath);
+    REQUIRE(doc->toString() == jsonString);
+    REQUIRE(doc->getRoot().getString("symbol") == std::optional<std::string>("BTCUSDT"));
+  }
+
+  SECTION("In situ mode keeps the mapping alive")
+  {
+    JsonMappedFileOptions options;
+    options.inSitu = true;
+    auto doc = Json::parseMappedFile(filePath, options);
+    REQUIRE(doc->toString() == Json::parseFile(filePath)->toString());
+    REQUIRE(doc->getRoot().getObject("meta").getString("venue") == std::optional<std::string>("binance"));
+  }
+
+  SECTION("In situ values copied into another document outlive the mapping")
+  {
+    auto target = Json::createDocument();
+    auto released = Json::createDocument();
+    {
+      JsonMappedFileOptions options;
+      options.inSitu = true;
+      auto doc = Json::parseMappedFile(filePath, options);
+      JsonValue meta = doc->getRoot().getObject("meta");
+      target->getRoot().set("meta", meta);
+      released->getRoot().set("meta", doc->getRoot().getObject("meta"));
+    }
+
+    REQUIRE(target->getRoot().getObject("meta").getString("venue") == std::optional<std::string>("binance"));
+    REQUIRE(released->getRoot().getObject("meta").getString("venue") == std::optional<std::string>("binance"));
+    REQUIRE(target->toString() == R"({"meta":{"venue":"binance"}})");
+  }
+
+  SECTION("Errors")
+  {
+    REQUIRE_THROWS_AS(Json::parseMappedFile("does_not_exist.json"), FilesException);
+
+    Files::writeFile(filePath, "{\"broken\": ");
+    REQUIRE_THROWS_AS(Json::parseMappedFile(filePath), JsonParseException);
+  }
+
+  Files::deleteFileIfExists(filePath);
+}
+
+TEST_CASE("JSON struct binding decode and encode", "[struct, sax]")
+{
+  const std::string tradeJson = R"({"source":"binance","symbol":"BTCUSDT","price":65000.5,"amount":0.25,"makerSide":"B","time":1729500000000})";
+
+  SECTION("Decoding straight into the struct")
+  {
+    auto trade = JsonStruct::decode<models::Trade>(tradeJson);
+    REQUIRE(trade.source == "binance");
+    REQUIRE(trade.symbol == "BTCUSDT");
+    REQUIRE(trade.price == 65000.5);
+    REQUIRE(trade.amount == 0.25);
+    REQUIRE(trade.makerSide == models::BUY);
+    REQUIRE(trade.time == 1729500000000);
+  }
+
+  SECTION("Unknown keys and nested containers are skipped")
+  {
+    auto trade = JsonStruct::decode<models::Trade>(R"({"id":7,"extra":{"price":1,"list":[1,2,{"a":3}]},"price":10,"symbol":"ETHUSDT"})");
+    REQUIRE(trade.price == 10.0);
+    REQUIRE(trade.symbol == "ETHUSDT");
+    REQUIRE(trade.time == INVALID_INT64);
+  }
+
+  SECTION("Encoding round trip")
+  {
+    auto trade = JsonStruct::decode<models::Trade>(tradeJson);
+    REQUIRE(JsonStruct::encode(trade) == Json::parse(tradeJson)->toString());
+
+    models::Trade empty;
+    REQUIRE(JsonStruct::encode(empty) == R"({"source":"","symbol":"","price":null,"amount":null,"makerSide":null,"time":-9223372036854775808})");
+  }
+
+  SECTION("Arrays of objects")
+  {
+    std::vector<models::Trade> trades;
+    JsonStruct::decodeArray("[" + tradeJson + "," + tradeJson + "]", trades);
+    REQUIRE(trades.size() == 2);
+    REQUIRE(trades[1].symbol == "BTCUSDT");
+    REQUIRE(JsonStruct::encodeArray(trades) == "[" + JsonStruct::encode(trades[0]) + "," + JsonStruct::encode(trades[1]) + "]");
+  }
+
+  SECTION("Incompatible values throw")
+  {
+    REQUIRE_THROWS_AS(JsonStruct::decode<models::Trade>(R"({"price":"65000.5"})"), JsonParseException);
+    REQUIRE_THROWS_AS(JsonStruct::decode<models::Trade>(R"({"makerSide":"BUY"})"), JsonParseException);
+    REQUIRE_THROWS_AS(JsonStruct::decode<models::Trade>(R"({"price":[1]})"), JsonParseException);
+    REQUIRE_THROWS_AS(JsonStruct::decode<models::Trade>(R"([1,2])"), JsonParseException);
+  }
+}
+
+TEST_CASE("JSON compiled pointer paths", "[path, view]")
+{
+  const std::string jsonString = R"({
+        "data": [
+          {"bids": [{"px": 100.5, "qty": 1}, {"px": 100.0, "qty": 2}], "asks": [{"px": 101.0, "qty": 3}]},
+          {"bids": [{"px": 99.5, "qty": 4}], "asks": []}
+        ],
+        "a/b": {"m~n": "escaped"},
+        "0": "numeric key"
+    })";
+
+  auto doc = Json::parse(jsonString);
+
+  SECTION("Nested keys and indices")
+  {
+    auto path = JsonPath::compile("/data/0/bids/1/px");
+    auto px = path.evaluate(*doc);
+    REQUIRE(px.has_value());
+    REQUIRE(px->asDouble() == std::optional<double>(100.0));
+
+    auto bids = JsonPath::compile("/data/0/bids").evaluate(*doc);
+    REQUIRE(bids->isArray());
+    REQUIRE(bids->size() == 2);
+    REQUIRE(bids->at(0)->getDouble("px") == std::optional<double>(100.5));
+  }
+
+  SECTION("Escaped and numeric keys")
+  {
+    REQUIRE(JsonPath::compile("/a~1b/m~0n").evaluate(*doc)->asString() == std::optional<std::string_view>("escaped"));
+    REQUIRE(JsonPath::compile("/0").evaluate(*doc)->asString() == std::optional<std::string_view>("numeric key"));
+    REQUIRE(JsonPath::compile("").evaluate(*doc)->isObject());
+  }
+
+  SECTION("Missing values")
+  {
+    REQUIRE_FALSE(JsonPath::compile("/data/2").evaluate(*doc).has_value());
+    REQUIRE_FALSE(JsonPath::compile("/data/01").evaluate(*doc).has_value());
+    REQUIRE_FALSE(JsonPath::compile("/data/0/bids/0/px/deeper").evaluate(*doc).has_value());
+    REQUIRE_FALSE(JsonPath::compile("/nope").evaluate(*doc).has_value());
+  }
+
+  SECTION("Wildcards fill a caller vector")
+  {
+    auto path = JsonPath::compile("/data/*/bids/*/px");
+    REQUIRE(path.hasWildcard());
+
+    std::vector<JsonView> prices;
+    REQUIRE(path.evaluateAll(*doc, prices) == 3);
+    REQUIRE(prices[0].asDouble() == std::optional<double>(100.5));
+    REQUIRE(prices[1].asDouble() == std::optional<double>(100.0));
+    REQUIRE(prices[2].asDouble() == std::optional<double>(99.5));
+
+    // The vector is reused between evaluations
+    REQUIRE(JsonPath::compile("/data/*/asks/*/qty").evaluateAll(*doc, prices) == 1);
+    REQUIRE(prices[0].asInt() == std::optional<int>(3));
+  }
+
+  SECTION("A compiled path is reusable across documents")
+  {
+    auto path = JsonPath::compile("/data/0/bids/0/px");
+    auto other = Json::parse(R"({"data":[{"bids":[{"px":1.25}]}]})");
+    REQUIRE(path.evaluate(*doc)->asDouble() == std::optional<double>(100.5));
+    REQUIRE(path.evaluate(*other)->asDouble() == std::optional<double>(1.25));
+  }
+
+  SECTION("Malformed pointers throw")
+  {
+    REQUIRE_THROWS_AS(JsonPath::compile("data/0"), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonPath::compile("/data~2"), JsonUsageException);
+  }
+}
+
+TEST_CASE("JSON bulk numeric extraction", "[numbers, columns]")
+{
+  const std::string jsonString = R"({
+        "closes": [101.5, 102, 99.25, 100],
+        "volumes": [10, 20, 30],
+        "mixed": [1, 2, "three", 4],
+        "bids": [{"px": 100.5, "qty": 3}, {"qty": 4, "px": 100.25}, {"px": 100.0, "qty": 5}],
+        "broken": [{"px": 1.0, "qty": 1}, {"px": 2.0}]
+    })";
+
+  auto doc = Json::parse(jsonString);
+  JsonValue root = doc->getRoot();
+
+  SECTION("Numbers into a contiguous vector")
+  {
+    std::vector<double> closes;
+    auto result = root.getNumbers("closes", closes);
+    REQUIRE(result);
+    REQUIRE(result.count == 4);
+    REQUIRE(closes == std::vector<double>{101.5, 102.0, 99.25, 100.0});
+
+    std::vector<int64_t> volumes;
+    REQUIRE(root.getNumbers("volumes", volumes));
+    REQUIRE(volumes == std::vector<int64_t>{10, 20, 30});
+  }
+
+  SECTION("Integers never accept fractional numbers")
+  {
+    std::vector<int64_t> closes;
+    auto result = root.getNumbers("closes", closes);
+    REQUIRE_FALSE(result);
+    REQUIRE(result.badIndex == std::optional<size_t>(0));
+  }
+
+  SECTION("The first bad index is reported")
+  {
+    std::vector<double> mixed;
+    auto result = root.getNumbers("mixed", mixed);
+    REQUIRE_FALSE(result);
+    REQUIRE(result.badIndex == std::optional<size_t>(2));
+    REQUIRE(mixed == std::vector<double>{1.0, 2.0});
+  }
+
+  SECTION("Output capacity is reused")
+  {
+    std::vector<double> values;
+    values.reserve(64);
+    const double* data = values.data();
+    REQUIRE(root.getNumbers("closes", values));
+    REQUIRE(root.view().getNumbers("volumes", values));
+    REQUIRE(values.data() == data);
+    REQUIRE(values.size() == 3);
+  }
+
+  SECTION("Uniform objects into columns")
+  {
+    std::vector<double> prices;
+    std::vector<int> quantities;
+    auto result = root.getColumns("bids", {"px", "qty"}, prices, quantities);
+    REQUIRE(result);
+    REQUIRE(prices == std::vector<double>{100.5, 100.25, 100.0});
+    REQUIRE(quantities == std::vector<int>{3, 4, 5});
+
+    auto broken = root.getColumns("broken", {"px", "qty"}, prices, quantities);
+    REQUIRE(broken.badIndex == std::optional<size_t>(1));
+    REQUIRE(prices.size() == 1);
+    REQUIRE(quantities.size() == 1);
+  }
+
+  SECTION("Missing arrays throw")
+  {
+    std::vector<double> values;
+    REQUIRE_THROWS_AS(root.getNumbers("nope", values), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonValue("text", doc).asNumbers(values), JsonUsageException);
+    REQUIRE(root.getNumbers("bids", values).badIndex == std::optional<size_t>(0));
+  }
+}
+
+TEST_CASE("JSON serialization into caller buffers", "[serialize, writer]")
+{
+  auto doc = Json::parse(R"({"symbol":"BTCUSDT","levels":[1.5,2.5],"active":true})");
+
+  SECTION("serializeTo appends and reuses capacity")
+  {
+    std::string out = "prefix:";
+    out.reserve(256);
+    const char* data = out.data();
+    doc->serializeTo(out);
+    REQUIRE(out == "prefix:" + doc->toString());
+    REQUIRE(out.data() == data);
+  }
+
+  SECTION("Pretty save round trip")
+  {
+    const std::string filePath = "serialize_test.json";
+    REQUIRE(doc->save(filePath, true));
+    REQUIRE(Files::readFile(filePath) == doc->toString(true));
+    REQUIRE(Json::parseFile(filePath)->toString() == doc->toString());
+    Files::deleteFileIfExists(filePath);
+  }
+
+  SECTION("Large documents through a file descriptor")
+  {
+    std::string levels = "[";
+    for (int i = 0; i < 20000; ++i)
+      levels += (i ? ",\"level-" : "\"level-") + std::to_string(i) + "\"";
+    levels += "]";
+    auto big = Json::parse(levels);
+
+    const std::string filePath = "serialize_fd_test.json";
+    REQUIRE(big->save(filePath));
+    REQUIRE(Files::readFile(filePath) == big->toString());
+    Files::deleteFileIfExists(filePath);
+  }
+
+  SECTION("JsonWriter builds without a document")
+  {
+    std::string out;
+    JsonWriter writer(out);
+    writer.startObject()
+        .field("symbol", "BTCUSDT")
+        .field("price", 65000.5)
+        .field("qty", 3)
+        .field("closed", false)
+        .key("levels").startArray().value(1).value(2).endArray()
+        .key("meta").raw(R"({"venue":"binance"})")
+        .key("none").null()
+        .endObject();
+
+    REQUIRE(writer.isComplete());
+    REQUIRE(out == R"({"symbol":"BTCUSDT","price":65000.5,"qty":3,"closed":false,"levels":[1,2],"meta":{"venue":"binance"},"none":null})");
+    REQUIRE(Json::parse(out)->getRoot().getDouble("price") == std::optional<double>(65000.5));
+
+    writer.reset();
+    REQUIRE(out.empty());
+    models::Trade trade;
+    trade.symbol = "ETHUSDT";
+    trade.price = 3000.0;
+    writer.object(trade);
+    REQUIRE(out == JsonStruct::encode(trade));
+  }
+}
+
+TEST_CASE("JSON binary encodings", "[msgpack, cbor]")
+{
+  std::string longText(300, 'x');
+  std::string levels;
+  for (int i = 0; i < 20; ++i)
+    levels += (i ? "," : "") + std::to_string(i * 1000 - 5000);
+
+  const std::string json = R"({"symbol":"BTCUSDT","price":65000.5,"qty":-3,"big":18446744073709551615,"min":-9223372036854775808,)"
+                           R"("active":true,"closed":false,"none":null,"empty":{},"list":[],"text":")" + longText +
+                           R"(","levels":[)" + levels + R"(],"nested":{"a":{"b":[1.25,{"c":"d"}]}}})";
+  auto doc = Json::parse(json);
+
+  SECTION("MessagePack round trip")
+  {
+    auto bytes = doc->toMsgPack();
+    REQUIRE(bytes.size() < json.size());
+    REQUIRE(Json::parseMsgPack(bytes)->toString() == doc->toString());
+  }
+
+  SECTION("CBOR round trip")
+  {
+    auto bytes = doc->toCbor();
+    REQUIRE(bytes.size() < json.size());
+    REQUIRE(Json::parseCbor(bytes)->toString() == doc->toString());
+  }
+
+  SECTION("Known encodings")
+  {
+    auto small = Json::parse(R"({"a":1,"b":[true,null,-1]})");
+    REQUIRE(small->toMsgPack() == std::vector<uint8_t>{0x82, 0xa1, 'a', 0x01, 0xa1, 'b', 0x93, 0xc3, 0xc0, 0xff});
+    REQUIRE(small->toCbor() == std::vector<uint8_t>{0xa2, 0x61, 'a', 0x01, 0x61, 'b', 0x83, 0xf5, 0xf6, 0x20});
+
+    std::vector<uint8_t> out = {0x00};
+    small->toCbor(out);
+    REQUIRE(out.size() == 11);
+  }
+
+  SECTION("Malformed input throws")
+  {
+    auto bytes = doc->toMsgPack();
+    REQUIRE_THROWS_AS(Json::parseMsgPack(bytes.data(), bytes.size() - 1), JsonParseException);
+    bytes.push_back(0xc0);
+    REQUIRE_THROWS_AS(Json::parseMsgPack(bytes), JsonParseException);
+    REQUIRE_THROWS_AS(Json::parseMsgPack(std::vector<uint8_t>{}), JsonParseException);
+    REQUIRE_THROWS_AS(Json::parseMsgPack(std::vector<uint8_t>{0x81, 0x01, 0x01}), JsonParseException);
+
+    auto cbor = doc->toCbor();
+    REQUIRE_THROWS_AS(Json::parseCbor(cbor.data(), cbor.size() - 1), JsonParseException);
+    REQUIRE_THROWS_AS(Json::parseCbor(std::vector<uint8_t>(1024, 0x81)), JsonParseException);
+
+    // A long chain of tags (6(6(6(...)))) counts against the nesting limit
+    std::vector<uint8_t> tags(100000, 0xc6);
+    tags.push_back(0x01);
+    REQUIRE_THROWS_AS(Json::parseCbor(tags), JsonParseException);
+    REQUIRE(Json::parseCbor(std::vector<uint8_t>{0xa1, 0x61, 'a', 0xc6, 0xc6, 0x01})->toString() == R"({"a":1})");
+  }
+
+  SECTION("CBOR indefinite containers and half floats")
+  {
+    // [_ 1, {_ "a": 1.5}]
+    std::vector<uint8_t> bytes = {0x9f, 0x01, 0xbf, 0x61, 'a', 0xf9, 0x3e, 0x00, 0xff, 0xff};
+    REQUIRE(Json::parseCbor(bytes)->toString() == R"([1,{"a":1.5}])");
+  }
+}
+
+TEST_CASE("JSON incremental parsing of fragmented input", "[parse, incremental]")
+{
+  const std::string stream = R"( {"a":"}{\"[","b":[1,{"c":2}]})" "\n" R"([1,2,"]"] {"x":"\\"}  [])";
+  const std::vector<std::string> expected = {
+    R"({"a":"}{\"[","b":[1,{"c":2}]})", R"([1,2,"]"])", R"({"x":"\\"})", "[]"
+  };
+
+  std::vector<std::string> documents;
+  JsonIncrementalParser parser([&](std::shared_ptr<JsonDocument> document) {
+    documents.push_back(document->toString());
+  });
+
+  SECTION("Every split point yields the same documents")
+  {
+    for (size_t cut = 0; cut <= stream.size(); ++cut)
+    {
+      documents.clear();
+      parser.feed(stream.data(), cut);
+      parser.feed(stream.data() + cut, stream.size() - cut);
+      REQUIRE(documents == expected);
+      REQUIRE(parser.idle());
+      REQUIRE(parser.buffered() == 0);
+    }
+  }
+
+  SECTION("Byte at a time")
+  {
+    size_t emitted = 0;
+    for (char c : stream)
+      emitted += parser.feed(&c, 1);
+    REQUIRE(emitted == expected.size());
+    REQUIRE(documents == expected);
+  }
+
+  SECTION("Partial documents are resumed, holding only the cut token")
+  {
+    REQUIRE(parser.feed(R"({"price":650)") == 0);
+    REQUIRE_FALSE(parser.idle());
+    REQUIRE(parser.buffered() == 3);
+    REQUIRE(parser.feed("00.5}{\"next\"") == 1);
+    REQUIRE(documents == std::vector<std::string>{R"({"price":65000.5})"});
+    REQUIRE_FALSE(parser.idle());
+    REQUIRE(parser.buffered() == 0);
+
+    parser.reset();
+    REQUIRE(parser.idle());
+    REQUIRE(parser.feed("[true]") == 1);
+  }
+
+  SECTION("Tokens cut at any byte")
+  {
+    const std::string text =
+        R"({"s":"a\"\\\u00e9\ud83d\ude00/","n":[-12.5e-3,18446744073709551615,-9223372036854775808,0],)"
+        R"("l":[true,false,null],"e":{},"a":[]})";
+    const std::string reference = Json::parse(text)->toString();
+
+    for (size_t cut = 1; cut < text.size(); ++cut)
+    {
+      documents.clear();
+      REQUIRE(parser.feed(text.data(), cut) == 0);
+      REQUIRE(parser.feed(text.data() + cut, text.size() - cut) == 1);
+      REQUIRE(documents == std::vector<std::string>{reference});
+      REQUIRE(parser.idle());
+    }
+  }
+
+  SECTION("Malformed input throws and resets")
+  {
+    REQUIRE_THROWS_AS(parser.feed("42"), JsonParseException);
+    REQUIRE_THROWS_AS(parser.feed("{\"a\":}"), JsonParseException);
+    REQUIRE(parser.idle());
+    REQUIRE(parser.feed("{}") == 1);
+
+    for (const char* tail : {"e1]", "E]", "]"})
+    {
+      REQUIRE(parser.feed("[tru") == 0);
+      REQUIRE_THROWS_AS(parser.feed(tail), JsonParseException);
+      REQUIRE(parser.idle());
+    }
+    REQUIRE(parser.feed("[\"\\ud800") == 0);
+    REQUIRE_THROWS_AS(parser.feed("x\"]"), JsonParseException);
+    REQUIRE(parser.feed("{\"a\":1") == 0);
+    REQUIRE_THROWS_AS(parser.feed(" 2}"), JsonParseException);
+    REQUIRE(parser.idle());
+    REQUIRE(parser.buffered() == 0);
+  }
+}
+
+TEST_CASE("JSON move-based construction", "[builder, set]")
+{
+  auto doc = Json::createDocument();
+
+  SECTION("Builders assemble a document without copies")
+  {
+    ArrayBuilder bids(doc, 3);
+    for (int i = 0; i < 3; ++i)
+      bids.push(ObjectBuilder(doc, 2, true).add("px", 100.5 - i).add("qty", i + 1).build());
+    REQUIRE(bids.size() == 3);
+
+    doc->setRoot(ObjectBuilder(doc, 3, true)
+                     .add("symbol", "BTCUSDT")
+                     .add("sequence", uint64_t(42))
+                     .add("bids", std::move(bids))
+                     .build());
+
+    REQUIRE(bids.size() == 0);
+    REQUIRE(doc->toString() == R"({"symbol":"BTCUSDT","sequence":42,"bids":[{"px":100.5,"qty":1},{"px":99.5,"qty":2},{"px":98.5,"qty":3}]})");
+  }
+
+  SECTION("Repeated keys replace unless promised unique")
+  {
+    auto object = ObjectBuilder(doc).add("a", 1).add("a", std::string("two")).build();
+    REQUIRE(object.view().toString() == R"({"a":"two"})");
+  }
+
+  SECTION("set steals values from the same document")
+  {
+    JsonValue root(doc);
+    JsonValue levels = ArrayBuilder(doc).push(1).push(2).build();
+    root.set("levels", std::move(levels));
+    REQUIRE(levels.isNull());
+
+    std::vector<JsonValue> items;
+    items.emplace_back("first", doc);
+    items.emplace_back(2, doc);
+    root.set("items", std::move(items));
+    root.set("levels", JsonValue(true, doc));
+
+    REQUIRE(root.view().toString() == R"({"levels":true,"items":["first",2]})");
+  }
+
+  SECTION("Values from another document are copied")
+  {
+    JsonValue root(doc);
+    {
+      auto other = Json::parse(R"({"venue":"binance","fees":[0.1,0.2]})");
+      root.set("meta", other->getRoot());
+    }
+    doc->setRoot(std::move(root));
+    REQUIRE(doc->toString() == R"({"meta":{"venue":"binance","fees":[0.1,0.2]}})");
+  }
+}
+
+TEST_CASE("JSON frozen documents", "[freeze, view]")
+{
+  auto doc = Json::parse(R"({"symbol":"BTCUSDT","tick":0.01,"filters":{"minQty":0.001,"maxQty":9000},"venues":[{"name":"binance","id":1},{"name":"okx","id":2}]})");
+
+  SECTION("Compact snapshot sorts keys and keeps lookups working")
+  {
+    auto frozen = doc->freeze();
+    REQUIRE(frozen->isCompact());
+    REQUIRE(frozen->toString() == R"({"filters":{"maxQty":9000,"minQty":0.001},"symbol":"BTCUSDT","tick":0.01,"venues":[{"id":1,"name":"binance"},{"id":2,"name":"okx"}]})");
+
+    auto view = frozen->view();
+    REQUIRE(view.getString("symbol") == std::optional<std::string_view>("BTCUSDT"));
+    REQUIRE(view.get("filters")->getDouble("minQty") == std::optional<double>(0.001));
+    REQUIRE_FALSE(view.exists("missing"));
+    REQUIRE_FALSE(view.exists("symbo"));
+    REQUIRE(view.at(0) == std::nullopt);
+    REQUIRE(JsonPath::compile("/venues/1/name").evaluate(view)->asString() == std::optional<std::string_view>("okx"));
+
+    std::vector<JsonView> ids;
+    REQUIRE(JsonPath::compile("/venues/*/id").evaluateAll(view, ids) == 2);
+    REQUIRE(ids[1].asInt() == std::optional<int>(2));
+  }
+
+  SECTION("Snapshot is independent of the source document")
+  {
+    auto frozen = doc->freeze(false);
+    REQUIRE_FALSE(frozen->isCompact());
+    const std::string original = doc->toString();
+    REQUIRE(frozen->toString() == original);
+
+    doc->setRoot(JsonValue("replaced", doc));
+    doc.reset();
+    REQUIRE(frozen->toString() == original);
+  }
+
+  SECTION("Concurrent readers")
+  {
+    auto frozen = doc->freeze();
+    std::atomic<int> matches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+    {
+      readers.emplace_back([frozen, &matches] {
+        for (int i = 0; i < 1000; ++i)
+          if (frozen->view().get("filters")->getInt("maxQty") == std::optional<int>(9000))
+            ++matches;
+      });
+    }
+    for (auto& reader : readers)
+      reader.join();
+    REQUIRE(matches == 4000);
+  }
+}
+
+namespace
+{
+  enum class Side : int8_t { Buy = 1, Sell = -1 };
+}
+
+TEST_CASE("JSON typed getters", "[get, view]")
+{
+  auto doc = Json::parse(R"({"symbol":"BTCUSDT","id":18446744073709551615,"qty":300,"side":-1,"price":65000.5,"open":true})");
+  auto root = doc->getRoot();
+  auto view = doc->view();
+
+  SECTION("Exact integer widths")
+  {
+    REQUIRE(root.get<uint64_t>("id") == std::optional<uint64_t>(18446744073709551615ULL));
+    REQUIRE(root.get<int64_t>("id") == std::nullopt);
+    REQUIRE(view.get<int16_t>("qty") == std::optional<int16_t>(300));
+    REQUIRE(view.get<uint8_t>("qty") == std::nullopt);
+    REQUIRE(view.get<int>("price") == std::nullopt);
+    REQUIRE(view.get<double>("qty") == std::optional<double>(300.0));
+  }
+
+  SECTION("Strings, bools and enums")
+  {
+    REQUIRE(view.get<std::string_view>("symbol") == std::optional<std::string_view>("BTCUSDT"));
+    REQUIRE(root.get<std::string>("symbol") == std::optional<std::string>("BTCUSDT"));
+    REQUIRE(root.get<bool>("open") == std::optional<bool>(true));
+    REQUIRE(root.get<Side>("side") == std::optional<Side>(Side::Sell));
+    REQUIRE(view.get<bool>("symbol") == std::nullopt);
+    REQUIRE(view.get("price")->as<float>() == std::optional<float>(65000.5f));
+  }
+
+  SECTION("getOr falls back without optional")
+  {
+    REQUIRE(view.getOr<int>("qty", -1) == 300);
+    REQUIRE(view.getOr<int>("missing", -1) == -1);
+    REQUIRE(root.getOr<std::string_view>("symbol", "none") == "BTCUSDT");
+    REQUIRE(root.getOr<std::string_view>("price", "none") == "none");
+  }
+
+  SECTION("Unsigned as getters keep precision")
+  {
+    JsonValue id(uint64_t(18446744073709551615ULL), doc);
+    REQUIRE(id.asUint64() == std::optional<uint64_t>(18446744073709551615ULL));
+    REQUIRE(id.as<uint64_t>() == std::optional<uint64_t>(18446744073709551615ULL));
+    REQUIRE(JsonValue(4000000000u, doc).asUint() == std::optional<unsigned>(4000000000u));
+  }
+}
+
+TEST_CASE("JSON lazy tape parsing", "[parse, lazy]")
+{
+  const std::string message = R"({"e":"depthUpdate","E":1729500000123,"s":"BTCUSDT","U":157,"u":160,)"
+                              R"("b":[["65000.50","0.25"],["64999.00","1.5"]],"a":[],"m":true,"x":null,)"
+                              R"("px":65000.5,"qty":-3,"note":"tab\tquote\" é 😀"})";
+  auto lazy = LazyJson::parse(message);
+  auto root = lazy->root();
+  auto dom = Json::parse(message)->getRoot();
+
+  SECTION("Getters match JsonValue")
+  {
+    REQUIRE(root.getString("e") == dom.getString("e"));
+    REQUIRE(root.getUint64("E") == dom.getUint64("E"));
+    REQUIRE(root.getInt("U") == dom.getInt("U"));
+    REQUIRE(root.getInt("E") == dom.getInt("E"));
+    REQUIRE(root.getDouble("px") == dom.getDouble("px"));
+    REQUIRE(root.getDouble("U") == dom.getDouble("U"));
+    REQUIRE(root.getFloat("px") == dom.getFloat("px"));
+    REQUIRE(root.getInt64("qty") == dom.getInt64("qty"));
+    REQUIRE(root.getUint("qty") == dom.getUint("qty"));
+    REQUIRE(root.getBool("m") == dom.getBool("m"));
+    REQUIRE(root.getString("note") == dom.getString("note"));
+    REQUIRE(root.size() == dom.size());
+    REQUIRE(root.get<std::string_view>("s") == std::optional<std::string_view>("BTCUSDT"));
+    REQUIRE(root.getOr<int>("missing", 7) == 7);
+  }
+
+  SECTION("Structure")
+  {
+    REQUIRE(root.hasArray("b"));
+    REQUIRE(root.hasString("s"));
+    REQUIRE(root.hasNumber("px"));
+    REQUIRE(root.hasBool("m"));
+    REQUIRE_FALSE(root.hasObject("b"));
+    REQUIRE(root.exists("x"));
+    REQUIRE_FALSE(root.exists("missing"));
+
+    auto bids = root.getArray("b");
+    REQUIRE(bids.size() == 2);
+    REQUIRE(bids[1].getArray()[0].asString() == std::optional<std::string>("64999.00"));
+    REQUIRE(root.getArray("a").empty());
+    REQUIRE_THROWS_AS(root.getArray("s"), JsonUsageException);
+    REQUIRE_THROWS_AS(root.getObject("b"), JsonParseException);
+  }
+
+  SECTION("Malformed input throws")
+  {
+    for (const std::string bad : {"", "{", R"({"a" 1})", "[1,]", R"({"a":1,})", "[01]", "[1.]", "[tru]", R"("abc)",
+                                  "[1] 2", R"(["\x"])", R"(["\ud800"])", "[-]", "{1:2}"})
+      REQUIRE_THROWS_AS(LazyJson::parse(bad), JsonParseException);
+  }
+}
+
+TEST_CASE("JSON string interning", "[parse, pool]")
+{
+  auto pool = std::make_shared<StringPool>(16);
+  const std::string first = R"({"symbol":"BTCUSDT","price":65000.5,"note":"a value longer than sixteen bytes"})";
+  const std::string second = R"({"symbol":"BTCUSDT","price":64999.0})";
+
+  auto a = Json::parse(first, pool);
+  auto b = Json::parse(second, pool);
+  REQUIRE(a->toString() == Json::parse(first)->toString());
+  REQUIRE(b->toString() == Json::parse(second)->toString());
+
+  SECTION("Documents share pooled strings")
+  {
+    auto symbolA = a->view().get<std::string_view>("symbol");
+    auto symbolB = b->view().get<std::string_view>("symbol");
+    REQUIRE(symbolA->data() == symbolB->data());
+    REQUIRE(symbolA->data() == pool->find("BTCUSDT")->data());
+
+    REQUIRE_FALSE(pool->find("a value longer than sixteen bytes"));
+    REQUIRE(pool->size() == 4);
+  }
+
+  SECTION("Interned keys find members")
+  {
+    auto price = pool->intern("price");
+    REQUIRE(price);
+    REQUIRE(b->view().get<double>(*price) == std::optional<double>(64999.0));
+  }
+
+  SECTION("Documents keep the pool alive")
+  {
+    pool.reset();
+    REQUIRE(a->view().getString("symbol") == std::optional<std::string_view>("BTCUSDT"));
+  }
+
+  SECTION("Incremental parser interns through its pool")
+  {
+    std::vector<std::shared_ptr<JsonDocument>> documents;
+    JsonIncrementalParser parser([&](std::shared_ptr<JsonDocument> document) { documents.push_back(document); }, pool);
+    parser.feed(first + second);
+    REQUIRE(documents.size() == 2);
+    REQUIRE(documents[1]->view().get<std::string_view>("symbol")->data() == pool->find("BTCUSDT")->data());
+
+    // A document spanning chunks goes through the tokenizer, which interns the same way
+    parser.feed(first.substr(0, first.size() / 2));
+    parser.feed(first.substr(first.size() / 2));
+    REQUIRE(documents.size() == 3);
+    REQUIRE(documents[2]->view().get<std::string_view>("symbol")->data() == pool->find("BTCUSDT")->data());
+    REQUIRE(documents[2]->toString() == documents[0]->toString());
+  }
+
+  SECTION("Values taken out of a pooled document outlive it and its pool")
+  {
+    auto released = Json::createDocument();
+    auto merged = Json::parse(R"({"price":1.0})");
+    {
+      auto scoped = Json::parse(first, std::make_shared<StringPool>(16));
+      released->getRoot().set("trade", scoped->getRoot());
+      JsonPatch::applyMerge(*merged, scoped->view());
+    }
+
+    REQUIRE(released->getRoot().getObject("trade").getString("symbol") == std::optional<std::string>("BTCUSDT"));
+    REQUIRE(merged->view().getString("symbol") == std::optional<std::string_view>("BTCUSDT"));
+    REQUIRE(merged->view().getString("note") == std::optional<std::string_view>("a value longer than sixteen bytes"));
+  }
+
+  REQUIRE_THROWS_AS(Json::parse("{\"broken\":", pool), JsonParseException);
+}
+
+TEST_CASE("StringPool limits and concurrency", "[pool]")
+{
+  StringPool pool(8, 3);
+  REQUIRE(pool.intern("bid")->data() == pool.intern(std::string("bid"))->data());
+  REQUIRE_FALSE(pool.intern("longer than eight"));
+  REQUIRE(pool.intern("ask"));
+  REQUIRE(pool.intern("qty"));
+  REQUIRE_FALSE(pool.intern("px"));
+  REQUIRE(pool.size() == 3);
+
+  StringPool shared;
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches{0};
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 1000; ++i) {
+        std::string key = "key" + std::to_string(i % 100);
+        if (shared.intern(key)->data() != shared.find(key)->data())
+          ++mismatches;
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  REQUIRE(mismatches == 0);
+  REQUIRE(shared.size() == 100);
+}
+
+TEST_CASE("JSON patch, merge patch and diff", "[patch, diff]")
+{
+  SECTION("RFC 6902 operations")
+  {
+    auto doc = Json::parse(R"({"foo":["bar","baz"],"book":{"px":1}})");
+    doc->applyPatch(JsonPatch::parse(R"([
+      {"op":"add","path":"/foo/1","value":"qux"},
+      {"op":"add","path":"/foo/-","value":"end"},
+      {"op":"remove","path":"/foo/0"},
+      {"op":"replace","path":"/book/px","value":2.5},
+      {"op":"copy","from":"/book","path":"/copy"},
+      {"op":"move","from":"/book/px","path":"/px"},
+      {"op":"add","path":"/a~1b","value":true},
+      {"op":"test","path":"/copy/px","value":2.5}
+    ])"));
+
+    REQUIRE(doc->toString() == R"({"foo":["qux","baz","end"],"book":{},"copy":{"px":2.5},"px":2.5,"a/b":true})");
+  }
+
+  SECTION("A failing operation leaves the document unchanged")
+  {
+    auto doc = Json::parse(R"({"a":[1,2,3],"b":{"c":1,"d":2},"e":"x"})");
+    const std::string before = doc->toString();
+
+    auto patch = JsonPatch::parse(R"([
+      {"op":"add","path":"/a/1","value":9},
+      {"op":"remove","path":"/b/c"},
+      {"op":"move","from":"/a/0","path":"/b/d"},
+      {"op":"replace","path":"","value":{"gone":true}},
+      {"op":"add","path":"/new","value":[1]},
+      {"op":"test","path":"/new/0","value":2}
+    ])");
+    REQUIRE(patch.size() == 6);
+    REQUIRE_THROWS_AS(doc->applyPatch(patch), JsonPatchException);
+    REQUIRE(doc->toString() == before);
+
+    REQUIRE_THROWS_AS(doc->applyPatch(JsonPatch::parse(R"([{"op":"remove","path":"/a/3"}])")), JsonPatchException);
+    REQUIRE_THROWS_AS(doc->applyPatch(JsonPatch::parse(R"([{"op":"add","path":"/missing/x","value":1}])")), JsonPatchException);
+    REQUIRE_THROWS_AS(doc->applyPatch(JsonPatch::parse(R"([{"op":"move","from":"/b","path":"/b/inner"}])")), JsonPatchException);
+    REQUIRE(doc->toString() == before);
+
+    // Moves whose destination fails after the source has been taken
+    REQUIRE_THROWS_AS(doc->applyPatch(JsonPatch::parse(R"([{"op":"move","from":"/e","path":"/missing/x"}])")), JsonPatchException);
+    REQUIRE(doc->toString() == before);
+    REQUIRE_THROWS_AS(doc->applyPatch(JsonPatch::parse(R"([{"op":"move","from":"/a/0","path":"/a/5"}])")), JsonPatchException);
+    REQUIRE(doc->toString() == before);
+    REQUIRE_THROWS_AS(doc->applyPatch(JsonPatch::parse(R"([
+      {"op":"move","from":"/b/c","path":"/a/0"},
+      {"op":"move","from":"/e","path":"/a/9"}
+    ])")), JsonPatchException);
+    REQUIRE(doc->toString() == before);
+  }
+
+  SECTION("Malformed patches")
+  {
+    REQUIRE_THROWS_AS(JsonPatch::parse(R"({"op":"add"})"), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonPatch::parse(R"([{"op":"upsert","path":"/a"}])"), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonPatch::parse(R"([{"op":"add","path":"/a"}])"), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonPatch::parse(R"([{"op":"move","path":"/a"}])"), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonPatch::parse(R"([{"op":"remove","path":"a"}])"), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonPatch::parse("[{"), JsonParseException);
+  }
+
+  SECTION("RFC 7396 merge patch")
+  {
+    auto doc = Json::parse(R"({"title":"Goodbye!","author":{"givenName":"John","familyName":"Doe"},"tags":["example","sample"],"content":"text"})");
+    auto patch = Json::parse(R"({"title":"Hello!","phoneNumber":"+01-123-456-7890","author":{"familyName":null},"tags":["example"],"extra":{"keep":1,"drop":null}})");
+    doc->applyMergePatch(patch->view());
+
+    REQUIRE(doc->toString() == R"({"title":"Hello!","author":{"givenName":"John"},"tags":["example"],"content":"text",)"
+                               R"("phoneNumber":"+01-123-456-7890","extra":{"keep":1}})");
+  }
+
+  SECTION("Diff produces the patch between two documents")
+  {
+    auto from = Json::parse(R"({"symbol":"BTCUSDT","qty":1,"bids":[[100,1],[99,2],[98,3],[97,4]],"meta":{"seq":1,"old":true}})");
+    auto to = Json::parse(R"({"symbol":"BTCUSDT","qty":1.5,"bids":[[100,1],[99.5,7],[99,2],[97,4]],"meta":{"seq":2},"status":"open"})");
+
+    auto patch = from->diff(*to);
+    // qty, one inserted level, one removed level, seq, old and status
+    REQUIRE(patch.size() == 6);
+    REQUIRE(from->diff(*from).empty());
+
+    from->applyPatch(patch);
+    REQUIRE(from->diff(*to).empty());
+    REQUIRE(to->diff(*from).empty());
+
+    auto shipped = JsonPatch::parse(patch.toString());
+    auto replica = Json::parse(R"({"symbol":"BTCUSDT","qty":1,"bids":[[100,1],[99,2],[98,3],[97,4]],"meta":{"seq":1,"old":true}})");
+    replica->applyPatch(shipped);
+    REQUIRE(replica->toString() == from->toString());
+
+    auto growing = Json::parse("[1,2,3]");
+    auto grown = Json::parse("[0,1,2,3,4]");
+    REQUIRE(growing->diff(*grown).size() == 2);
+    REQUIRE(grown->diff(*growing).size() == 2);
+    REQUIRE(Json::parse("[1]")->diff(*Json::parse(R"({"a":1})")).toString() == R"([{"op":"replace","path":"","value":{"a":1}}])");
+  }
+}
+
+TEST_CASE("JSON schema validated parsing", "[parse, schema]")
+{
+  auto schema = JsonSchema::compile(R"({
+    "type": "object",
+    "required": ["s", "p", "q", "bids"],
+    "properties": {
+      "s": {"type": "string", "minLength": 1},
+      "p": {"type": "number", "exclusiveMinimum": true, "minimum": 0},
+      "q": {"type": "number"},
+      "bids": {"type": "array", "items": {"type": "array", "items": {"type": "number"}, "minItems": 2, "maxItems": 2}}
+    }
+  })");
+
+  SECTION("Valid messages parse into documents")
+  {
+    auto doc = schema->parse(R"({"s":"BTCUSDT","p":65000.5,"q":0.25,"bids":[[65000,1],[64999.5,2]]})");
+    REQUIRE(doc->view().get<double>("p") == std::optional<double>(65000.5));
+    REQUIRE(schema->isValid(doc->view()));
+    REQUIRE_NOTHROW(schema->validate(doc->view()));
+  }
+
+  SECTION("Violations report where and why")
+  {
+    try {
+      schema->parse(R"({"s":"BTCUSDT","p":65000.5,"q":0.25,"bids":[[65000,1],[64999.5,"2"]]})");
+      FAIL("Expected a validation error");
+    } catch (const JsonValidationException& e) {
+      REQUIRE(e.instancePath() == "/bids/1/1");
+      REQUIRE(e.keyword() == "type");
+      REQUIRE(e.schemaPath() == "#/properties/bids/items/items");
+    }
+
+    try {
+      schema->parse(R"({"s":"BTCUSDT","q":0.25,"bids":[]})");
+      FAIL("Expected a validation error");
+    } catch (const JsonValidationException& e) {
+      REQUIRE(e.instancePath().empty());
+      REQUIRE(e.keyword() == "required");
+      REQUIRE(std::string(e.what()).find("missing: p") != std::string::npos);
+    }
+
+    REQUIRE_THROWS_AS(schema->parse(R"({"s":"","p":1,"q":1,"bids":[]})"), JsonValidationException);
+    REQUIRE_THROWS_AS(schema->parse(R"({"s":"X","p":0,"q":1,"bids":[]})"), JsonValidationException);
+    REQUIRE_FALSE(schema->isValid(Json::parse(R"({"s":"X"})")->view()));
+  }
+
+  SECTION("Malformed input and schemas")
+  {
+    REQUIRE_THROWS_AS(schema->parse(R"({"s":"BTCUSDT",)"), JsonParseException);
+    REQUIRE_THROWS_AS(JsonSchema::compile("[1, 2]"), JsonUsageException);
+    REQUIRE_THROWS_AS(JsonSchema::compile("{"), JsonParseException);
+  }
+}